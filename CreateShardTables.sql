@@ -0,0 +1,66 @@
+-- 订单分片建表脚本：在每个 order_shards 节点的库中执行
+-- ORDER、ORDER_ITEM、PAYMENT_RECORD、DELIVERY_INFO 按 userId 分片存放，
+-- USER、MERCHANT、USER_ADDRESS、DISH 留在主库，分片上去掉指向这些表的外键，由服务端保证引用有效
+USE TakeAwayDatabase;
+
+-- 订单表(order）
+CREATE TABLE `ORDER` (
+  `orderId` VARCHAR(36) NOT NULL,
+  `userId` VARCHAR(36) NOT NULL,
+  `merchantId` VARCHAR(255) NOT NULL,
+  `totalPrice` DECIMAL(10,2) NOT NULL DEFAULT 0.00,
+  `status` VARCHAR(30) NOT NULL DEFAULT 'PENDING_PAYMENT',
+  `orderTime` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  `paymentTime` DATETIME,
+  `estimatedDeliveryTime` DATETIME,
+  `actualDeliveryTime` DATETIME,
+  `remark` TEXT,
+  `addressId` VARCHAR(36) NOT NULL,
+  PRIMARY KEY (`orderId`),
+  -- 用户订单按 (orderTime, orderId) 倒序分页；商家最近订单同样排序，带上 totalPrice 使统计查询只读索引
+  INDEX `idx_userId_orderTime` (`userId`, `orderTime`, `orderId`),
+  INDEX `idx_merchantId_orderTime` (`merchantId`, `orderTime`, `orderId`, `totalPrice`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 订单项表(ORDER_ITEM)
+CREATE TABLE `ORDER_ITEM` (
+  `orderItemId` VARCHAR(36) NOT NULL,
+  `orderId` VARCHAR(36) NOT NULL,
+  `dishId` VARCHAR(36) NOT NULL,
+  `dishName` VARCHAR(100) NOT NULL,
+  `price` DECIMAL(10,2) NOT NULL DEFAULT 0.00,
+  `quantity` INT NOT NULL DEFAULT 1,
+  PRIMARY KEY (`orderItemId`),
+  INDEX `idx_orderId` (`orderId`),
+  CONSTRAINT `fk_order_item_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`) ON DELETE CASCADE
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 支付记录表(PAYMENT_RECORD)
+CREATE TABLE `PAYMENT_RECORD` (
+  `paymentId` VARCHAR(36) NOT NULL,
+  `orderId` VARCHAR(36) NOT NULL,
+  `amount` DECIMAL(10,2) NOT NULL DEFAULT 0.00,
+  `paymentTime` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  `paymentMethod` VARCHAR(50) NOT NULL,
+  `transactionId` VARCHAR(100),
+  `status` VARCHAR(20) NOT NULL DEFAULT 'SUCCESS',
+  PRIMARY KEY (`paymentId`),
+  UNIQUE KEY `idx_orderId` (`orderId`),
+  UNIQUE KEY `idx_transactionId` (`transactionId`),
+  CONSTRAINT `fk_payment_record_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 配送信息表(DELIVERY_INFO)
+CREATE TABLE `DELIVERY_INFO` (
+  `deliveryId` VARCHAR(36) NOT NULL,
+  `orderId` VARCHAR(36) NOT NULL,
+  `deliveryStatus` VARCHAR(30) NOT NULL DEFAULT 'PENDING_PICKUP',
+  `estimatedDeliveryTime` DATETIME,
+  `actualDeliveryTime` DATETIME,
+  `deliveryPersonId` VARCHAR(36),
+  `deliveryPersonName` VARCHAR(50),
+  `deliveryPersonPhone` VARCHAR(20),
+  PRIMARY KEY (`deliveryId`),
+  UNIQUE KEY `idx_orderId` (`orderId`),
+  CONSTRAINT `fk_delivery_info_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
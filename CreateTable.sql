@@ -13,9 +13,7 @@ CREATE TABLE `USER` (
   PRIMARY KEY (`userId`),
   UNIQUE KEY `idx_username` (`username`),
   UNIQUE KEY `idx_email` (`email`),
-  UNIQUE KEY `idx_phoneNumber` (`phoneNumber`),
-  INDEX `idx_registrationDate` (`registrationDate`),
-  INDEX `idx_status` (`status`)
+  UNIQUE KEY `idx_phoneNumber` (`phoneNumber`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
 
@@ -28,7 +26,6 @@ CREATE TABLE `USER_ADDRESS` (
   `fullAddress` VARCHAR(255) NOT NULL,
   `isDefault` TINYINT(1) NOT NULL DEFAULT 0,
   PRIMARY KEY (`addressId`),
-  UNIQUE KEY `idx_addressId` (`addressId`),
   INDEX `idx_userId` (`userId`),
   CONSTRAINT `fk_user_address_user` FOREIGN KEY (`userId`) REFERENCES `USER` (`userId`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -45,11 +42,8 @@ CREATE TABLE `MERCHANT` (
   `registrationDate` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
   `status` VARCHAR(20) NOT NULL DEFAULT 'pending',
   PRIMARY KEY (`merchantId`),
-  UNIQUE KEY `idx_merchantId` (`merchantId`),
   UNIQUE KEY `idx_name` (`name`),
-  INDEX `idx_isOpen` (`isOpen`),
-  INDEX `idx_registrationDate` (`registrationDate`),
-  INDEX `idx_status` (`status`)
+  INDEX `idx_isOpen` (`isOpen`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
 -- 菜品分类表(DISH_CATEGORY)
@@ -59,9 +53,8 @@ CREATE TABLE `DISH_CATEGORY` (
   `categoryName` VARCHAR(50) NOT NULL,
   `sortOrder` INT NOT NULL DEFAULT 0,
   PRIMARY KEY (`categoryId`),
-  UNIQUE KEY `idx_categoryId` (`categoryId`),
-  INDEX `idx_merchantId` (`merchantId`),
-  INDEX `idx_categoryName` (`categoryName`),
+  -- 商家分类列表按 sortOrder 排序
+  INDEX `idx_merchantId_sortOrder` (`merchantId`, `sortOrder`),
   CONSTRAINT `fk_dish_category_merchant` FOREIGN KEY (`merchantId`) REFERENCES `MERCHANT` (`merchantId`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
@@ -79,15 +72,9 @@ CREATE TABLE `DISH` (
   `rating` DECIMAL(2,1) NOT NULL DEFAULT 0.0,
   `isOnSale` TINYINT(1) NOT NULL DEFAULT 1,
   PRIMARY KEY (`dishId`),
-  UNIQUE KEY `idx_dishId` (`dishId`),
-  INDEX `idx_merchantId` (`merchantId`),
+  -- 商家菜品列表按名称排序；stock、sales、rating 随下单和评价频繁更新，不建索引
+  INDEX `idx_merchantId_name` (`merchantId`, `name`),
   INDEX `idx_categoryId` (`categoryId`),
-  INDEX `idx_name` (`name`),
-  INDEX `idx_price` (`price`),
-  INDEX `idx_stock` (`stock`),
-  INDEX `idx_sales` (`sales`),
-  INDEX `idx_rating` (`rating`),
-  INDEX `idx_isOnSale` (`isOnSale`),
   CONSTRAINT `fk_dish_merchant` FOREIGN KEY (`merchantId`) REFERENCES `MERCHANT` (`merchantId`) ON DELETE CASCADE,
   CONSTRAINT `fk_dish_category` FOREIGN KEY (`categoryId`) REFERENCES `DISH_CATEGORY` (`categoryId`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -106,14 +93,9 @@ CREATE TABLE `ORDER` (
   `remark` TEXT,
   `addressId` VARCHAR(36) NOT NULL,
   PRIMARY KEY (`orderId`),
-  UNIQUE KEY `idx_orderId` (`orderId`),
-  INDEX `idx_userId` (`userId`),
-  INDEX `idx_merchantId` (`merchantId`),
-  INDEX `idx_status` (`status`),
-  INDEX `idx_orderTime` (`orderTime`),
-  INDEX `idx_paymentTime` (`paymentTime`),
-  INDEX `idx_estimatedDeliveryTime` (`estimatedDeliveryTime`),
-  INDEX `idx_actualDeliveryTime` (`actualDeliveryTime`),
+  -- 用户订单按 (orderTime, orderId) 倒序分页；商家最近订单同样排序，带上 totalPrice 使统计查询只读索引
+  INDEX `idx_userId_orderTime` (`userId`, `orderTime`, `orderId`),
+  INDEX `idx_merchantId_orderTime` (`merchantId`, `orderTime`, `orderId`, `totalPrice`),
   INDEX `idx_addressId` (`addressId`),
   CONSTRAINT `fk_order_user` FOREIGN KEY (`userId`) REFERENCES `USER` (`userId`),
   CONSTRAINT `fk_order_merchant` FOREIGN KEY (`merchantId`) REFERENCES `MERCHANT` (`merchantId`),
@@ -131,7 +113,6 @@ CREATE TABLE `ORDER_ITEM` (
   `price` DECIMAL(10,2) NOT NULL DEFAULT 0.00,
   `quantity` INT NOT NULL DEFAULT 1,
   PRIMARY KEY (`orderItemId`),
-  UNIQUE KEY `idx_orderItemId` (`orderItemId`),
   INDEX `idx_orderId` (`orderId`),
   INDEX `idx_dishId` (`dishId`),
   CONSTRAINT `fk_order_item_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`) ON DELETE CASCADE,
@@ -149,11 +130,8 @@ CREATE TABLE `PAYMENT_RECORD` (
   `transactionId` VARCHAR(100),
   `status` VARCHAR(20) NOT NULL DEFAULT 'SUCCESS',
   PRIMARY KEY (`paymentId`),
-  UNIQUE KEY `idx_paymentId` (`paymentId`),
   UNIQUE KEY `idx_orderId` (`orderId`),
   UNIQUE KEY `idx_transactionId` (`transactionId`),
-  INDEX `idx_paymentTime` (`paymentTime`),
-  INDEX `idx_status` (`status`),
   CONSTRAINT `fk_payment_record_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
@@ -168,12 +146,7 @@ CREATE TABLE `DELIVERY_INFO` (
   `deliveryPersonName` VARCHAR(50),
   `deliveryPersonPhone` VARCHAR(20),
   PRIMARY KEY (`deliveryId`),
-  UNIQUE KEY `idx_deliveryId` (`deliveryId`),
   UNIQUE KEY `idx_orderId` (`orderId`),
-  INDEX `idx_deliveryStatus` (`deliveryStatus`),
-  INDEX `idx_estimatedDeliveryTime` (`estimatedDeliveryTime`),
-  INDEX `idx_actualDeliveryTime` (`actualDeliveryTime`),
-  INDEX `idx_deliveryPersonId` (`deliveryPersonId`),
   CONSTRAINT `fk_delivery_info_order` FOREIGN KEY (`orderId`) REFERENCES `ORDER` (`orderId`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
@@ -191,11 +164,8 @@ CREATE TABLE `USER_COMMENT` (
   `content` TEXT,
   `commentTime` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
   PRIMARY KEY (`commentId`),
-  UNIQUE KEY `idx_commentId` (`commentId`),
   INDEX `idx_userId` (`userId`),
-  INDEX `idx_dishId` (`dishId`),
-  INDEX `idx_rating` (`rating`),
-  INDEX `idx_commentTime` (`commentTime`),
+  INDEX `idx_dishId_commentTime` (`dishId`, `commentTime`, `commentId`),
   CONSTRAINT `fk_user_comment_user` FOREIGN KEY (`userId`) REFERENCES `USER` (`userId`),
   CONSTRAINT `fk_user_comment_dish` FOREIGN KEY (`dishId`) REFERENCES `DISH` (`dishId`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -209,15 +179,26 @@ CREATE TABLE `MERCHANT_REVIEW` (
   `content` TEXT,
   `reviewTime` DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,
   PRIMARY KEY (`reviewId`),
-  UNIQUE KEY `idx_reviewId` (`reviewId`),
   INDEX `idx_userId` (`userId`),
-  INDEX `idx_merchantId` (`merchantId`),
-  INDEX `idx_rating` (`rating`),
-  INDEX `idx_reviewTime` (`reviewTime`),
+  INDEX `idx_merchantId_reviewTime` (`merchantId`, `reviewTime`, `reviewId`),
   CONSTRAINT `fk_merchant_review_user` FOREIGN KEY (`userId`) REFERENCES `USER` (`userId`),
   CONSTRAINT `fk_merchant_review_merchant` FOREIGN KEY (`merchantId`) REFERENCES `MERCHANT` (`merchantId`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
+-- 评分汇总表(RATING_SUMMARY)：商家评价与菜品评论的条数、总分与各星级条数，随评价写入累加
+CREATE TABLE `RATING_SUMMARY` (
+  `targetType` VARCHAR(10) NOT NULL,
+  `targetId` VARCHAR(255) NOT NULL,
+  `ratingCount` INT NOT NULL DEFAULT 0,
+  `ratingSum` BIGINT NOT NULL DEFAULT 0,
+  `star1` INT NOT NULL DEFAULT 0,
+  `star2` INT NOT NULL DEFAULT 0,
+  `star3` INT NOT NULL DEFAULT 0,
+  `star4` INT NOT NULL DEFAULT 0,
+  `star5` INT NOT NULL DEFAULT 0,
+  PRIMARY KEY (`targetType`, `targetId`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
 -- 管理员表(ADMIN_USER)
 CREATE TABLE `ADMIN_USER` (
   `adminId` VARCHAR(36) NOT NULL,
@@ -226,8 +207,5 @@ CREATE TABLE `ADMIN_USER` (
   `role` VARCHAR(50) NOT NULL DEFAULT 'operator',
   `lastLogin` DATETIME,
   PRIMARY KEY (`adminId`),
-  UNIQUE KEY `idx_adminId` (`adminId`),
-  UNIQUE KEY `idx_username` (`username`),
-  INDEX `idx_role` (`role`),
-  INDEX `idx_lastLogin` (`lastLogin`)
+  UNIQUE KEY `idx_username` (`username`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
@@ -0,0 +1,55 @@
+-- 索引调整迁移脚本：在主库执行一次，需在 MigrateRatingSummary.sql 之后执行
+-- 去掉与主键重复的唯一索引、没有查询使用的单列索引，为热点查询建立复合索引；
+-- 先建新索引再删除旧索引，外键始终有可用的索引。都是在线 DDL，执行期间读写不阻塞。
+-- 执行前后各运行一次 bench_index（见 bench/index_bench.cpp）对比 EXPLAIN 结果与吞吐。
+USE TakeAwayDatabase;
+
+-- 热点查询的复合索引
+ALTER TABLE `DISH_CATEGORY` ADD INDEX `idx_merchantId_sortOrder` (`merchantId`, `sortOrder`), ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `DISH` ADD INDEX `idx_merchantId_name` (`merchantId`, `name`), ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `ORDER`
+  ADD INDEX `idx_userId_orderTime` (`userId`, `orderTime`, `orderId`),
+  ADD INDEX `idx_merchantId_orderTime` (`merchantId`, `orderTime`, `orderId`, `totalPrice`),
+  ALGORITHM=INPLACE, LOCK=NONE;
+
+-- 与主键重复、没有查询使用或已被复合索引覆盖的索引
+ALTER TABLE `USER`
+  DROP INDEX `idx_registrationDate`, DROP INDEX `idx_status`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `USER_ADDRESS`
+  DROP INDEX `idx_addressId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `MERCHANT`
+  DROP INDEX `idx_merchantId`, DROP INDEX `idx_registrationDate`, DROP INDEX `idx_status`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `DISH_CATEGORY`
+  DROP INDEX `idx_categoryId`, DROP INDEX `idx_merchantId`, DROP INDEX `idx_categoryName`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `DISH`
+  DROP INDEX `idx_dishId`, DROP INDEX `idx_merchantId`, DROP INDEX `idx_name`, DROP INDEX `idx_price`,
+  DROP INDEX `idx_stock`, DROP INDEX `idx_sales`, DROP INDEX `idx_rating`, DROP INDEX `idx_isOnSale`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `ORDER`
+  DROP INDEX `idx_orderId`, DROP INDEX `idx_userId`, DROP INDEX `idx_merchantId`, DROP INDEX `idx_status`,
+  DROP INDEX `idx_orderTime`, DROP INDEX `idx_paymentTime`, DROP INDEX `idx_estimatedDeliveryTime`,
+  DROP INDEX `idx_actualDeliveryTime`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `ORDER_ITEM`
+  DROP INDEX `idx_orderItemId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `PAYMENT_RECORD`
+  DROP INDEX `idx_paymentId`, DROP INDEX `idx_paymentTime`, DROP INDEX `idx_status`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `DELIVERY_INFO`
+  DROP INDEX `idx_deliveryId`, DROP INDEX `idx_deliveryStatus`, DROP INDEX `idx_estimatedDeliveryTime`,
+  DROP INDEX `idx_actualDeliveryTime`, DROP INDEX `idx_deliveryPersonId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `USER_COMMENT`
+  DROP INDEX `idx_commentId`, DROP INDEX `idx_dishId`, DROP INDEX `idx_rating`, DROP INDEX `idx_commentTime`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `MERCHANT_REVIEW`
+  DROP INDEX `idx_reviewId`, DROP INDEX `idx_merchantId`, DROP INDEX `idx_rating`, DROP INDEX `idx_reviewTime`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `ADMIN_USER`
+  DROP INDEX `idx_adminId`, DROP INDEX `idx_role`, DROP INDEX `idx_lastLogin`,
+  ALGORITHM=INPLACE, LOCK=NONE;
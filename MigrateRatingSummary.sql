@@ -0,0 +1,39 @@
+-- 评分汇总迁移脚本：在主库执行一次，为已有数据建立 RATING_SUMMARY 并刷新 DISH.rating
+-- 执行期间暂停 /review/create 与 /comment/add，脚本按现有数据整体重算，可重复执行
+USE TakeAwayDatabase;
+
+CREATE TABLE IF NOT EXISTS `RATING_SUMMARY` (
+  `targetType` VARCHAR(10) NOT NULL,
+  `targetId` VARCHAR(255) NOT NULL,
+  `ratingCount` INT NOT NULL DEFAULT 0,
+  `ratingSum` BIGINT NOT NULL DEFAULT 0,
+  `star1` INT NOT NULL DEFAULT 0,
+  `star2` INT NOT NULL DEFAULT 0,
+  `star3` INT NOT NULL DEFAULT 0,
+  `star4` INT NOT NULL DEFAULT 0,
+  `star5` INT NOT NULL DEFAULT 0,
+  PRIMARY KEY (`targetType`, `targetId`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- 评价列表按 (时间, ID) 倒序分页
+ALTER TABLE `MERCHANT_REVIEW` ADD INDEX `idx_merchantId_reviewTime` (`merchantId`, `reviewTime`, `reviewId`);
+ALTER TABLE `USER_COMMENT` ADD INDEX `idx_dishId_commentTime` (`dishId`, `commentTime`, `commentId`);
+
+DELETE FROM `RATING_SUMMARY`;
+
+INSERT INTO `RATING_SUMMARY` (targetType, targetId, ratingCount, ratingSum, star1, star2, star3, star4, star5)
+SELECT 'merchant', merchantId, COUNT(*), SUM(rating),
+       SUM(rating = 1), SUM(rating = 2), SUM(rating = 3), SUM(rating = 4), SUM(rating = 5)
+FROM `MERCHANT_REVIEW`
+WHERE rating BETWEEN 1 AND 5
+GROUP BY merchantId;
+
+INSERT INTO `RATING_SUMMARY` (targetType, targetId, ratingCount, ratingSum, star1, star2, star3, star4, star5)
+SELECT 'dish', dishId, COUNT(*), SUM(rating),
+       SUM(rating = 1), SUM(rating = 2), SUM(rating = 3), SUM(rating = 4), SUM(rating = 5)
+FROM `USER_COMMENT`
+WHERE dishId IS NOT NULL AND rating BETWEEN 1 AND 5
+GROUP BY dishId;
+
+UPDATE `DISH` d JOIN `RATING_SUMMARY` s ON s.targetType = 'dish' AND s.targetId = d.dishId
+SET d.rating = ROUND(s.ratingSum / s.ratingCount, 1);
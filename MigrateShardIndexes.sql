@@ -0,0 +1,27 @@
+-- 订单分片的索引调整迁移脚本：在每个 order_shards 节点的库中执行一次
+-- 与 MigrateIndexes.sql 相同的调整；分片上没有指向主库表的外键，addressId、dishId 的索引一并去掉。
+-- 先建新索引再删除旧索引，都是在线 DDL，执行期间读写不阻塞。
+USE TakeAwayDatabase;
+
+-- 用户订单分页与商家最近订单、订单统计
+ALTER TABLE `ORDER`
+  ADD INDEX `idx_userId_orderTime` (`userId`, `orderTime`, `orderId`),
+  ADD INDEX `idx_merchantId_orderTime` (`merchantId`, `orderTime`, `orderId`, `totalPrice`),
+  ALGORITHM=INPLACE, LOCK=NONE;
+
+-- 与主键重复、没有查询使用或已被复合索引覆盖的索引
+ALTER TABLE `ORDER`
+  DROP INDEX `idx_orderId`, DROP INDEX `idx_userId`, DROP INDEX `idx_merchantId`, DROP INDEX `idx_status`,
+  DROP INDEX `idx_orderTime`, DROP INDEX `idx_paymentTime`, DROP INDEX `idx_estimatedDeliveryTime`,
+  DROP INDEX `idx_actualDeliveryTime`, DROP INDEX `idx_addressId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `ORDER_ITEM`
+  DROP INDEX `idx_orderItemId`, DROP INDEX `idx_dishId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `PAYMENT_RECORD`
+  DROP INDEX `idx_paymentId`, DROP INDEX `idx_paymentTime`, DROP INDEX `idx_status`,
+  ALGORITHM=INPLACE, LOCK=NONE;
+ALTER TABLE `DELIVERY_INFO`
+  DROP INDEX `idx_deliveryId`, DROP INDEX `idx_deliveryStatus`, DROP INDEX `idx_estimatedDeliveryTime`,
+  DROP INDEX `idx_actualDeliveryTime`, DROP INDEX `idx_deliveryPersonId`,
+  ALGORITHM=INPLACE, LOCK=NONE;
@@ -0,0 +1,66 @@
+#pragma once
+
+// 替换全局 operator new / delete，统计每个线程的堆分配次数与字节数
+// 替换函数不能是 inline 的：每个基准程序只能在一个源文件里包含本文件
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "bench_util.h"
+
+
+namespace
+{
+    void* counted_allocate(std::size_t size, std::size_t alignment)
+    {
+        TakeAwayBench::threadAllocations.calls += 1;
+        TakeAwayBench::threadAllocations.bytes += size;
+
+        if (size == 0) {
+            size = 1;
+        }
+        void* pointer = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            pointer = std::malloc(size);
+        } else if (posix_memalign(&pointer, alignment, size) != 0) {
+            pointer = nullptr;
+        }
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+
+    const bool allocationCounterRegistered = (TakeAwayBench::allocationCounterInstalled = true);
+}
+
+void* operator new(std::size_t size)
+{
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
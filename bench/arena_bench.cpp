@@ -0,0 +1,137 @@
+// 请求内临时对象分配：全局堆与 RequestArena 对比
+// 每次迭代按 /order/create 与 /order/query 的方式构造绑定参数和 orderId 索引，
+//   heap  - 不打开 RequestArena::Scope，RequestArena::resource() 返回默认的堆分配器
+//   arena - 每次迭代打开一个 Scope，结束时整体释放
+// 先单线程输出每次的耗时与堆分配次数，再用多个线程同时运行，观察全局堆的竞争。
+// mysqlx::Value 内部的字符串不经过 arena，两种方式都计入分配次数。
+//
+// 用法: bench_arena [order_items] [page_size] [iterations] [threads]
+
+#include <cstdlib>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "db_handler.h"
+#include "request_arena.h"
+
+using namespace TakeAwayBench;
+using namespace TakeAwayPlatform;
+
+
+namespace
+{
+    struct Workload
+    {
+        std::vector<std::string> dishIds;
+        std::vector<std::string> orderIds;
+    };
+
+    Workload make_workload(size_t items, size_t pageSize)
+    {
+        Workload workload;
+        for (size_t index = 0; index < items; ++index) {
+            workload.dishIds.push_back("d0000000-0000-0000-0000-" + std::to_string(100000000000 + index));
+        }
+        for (size_t index = 0; index < pageSize; ++index) {
+            workload.orderIds.push_back("o0000000-0000-0000-0000-" + std::to_string(100000000000 + index));
+        }
+        return workload;
+    }
+
+    // 一次请求的临时对象，与 RestServer 中的写法一致
+    size_t handle(const Workload& workload)
+    {
+        std::pmr::memory_resource* arena = RequestArena::resource();
+
+        // /order/create：订单项与库存扣减的绑定参数
+        BoundValues itemParams(arena);
+        itemParams.reserve(workload.dishIds.size() * 6);
+        BoundValues stockParams(arena);
+        stockParams.reserve(workload.dishIds.size() * 2);
+        for (const std::string& dishId : workload.dishIds) {
+            itemParams.emplace_back(workload.orderIds.front());
+            itemParams.emplace_back(workload.orderIds.back());
+            itemParams.emplace_back(dishId);
+            itemParams.emplace_back("招牌菜品");
+            itemParams.emplace_back(18.5);
+            itemParams.emplace_back(2);
+            stockParams.emplace_back(dishId);
+            stockParams.emplace_back(2);
+        }
+
+        // /order/query：本页 orderId 的绑定参数与归组索引
+        BoundValues orderIds(arena);
+        orderIds.reserve(workload.orderIds.size());
+        std::pmr::unordered_map<std::pmr::string, size_t> orderIndex(arena);
+        for (size_t index = 0; index < workload.orderIds.size(); ++index) {
+            orderIndex.emplace(std::pmr::string(workload.orderIds[index], arena), index);
+            orderIds.emplace_back(workload.orderIds[index]);
+        }
+
+        size_t found = 0;
+        std::pmr::string key(arena);
+        for (const std::string& orderId : workload.orderIds) {
+            key = orderId;
+            found += orderIndex.count(key);
+        }
+        return itemParams.size() + stockParams.size() + orderIds.size() + found;
+    }
+
+    size_t handle_in_arena(const Workload& workload)
+    {
+        RequestArena::Scope scope;
+        return handle(workload);
+    }
+
+    // threads 个线程各自运行 iterations 次，返回总吞吐（次/秒）
+    template<typename Fn>
+    double run_threads(size_t threads, size_t iterations, Fn fn)
+    {
+        std::vector<std::thread> workers;
+        const auto start = Clock::now();
+        for (size_t index = 0; index < threads; ++index) {
+            workers.emplace_back([&] {
+                for (size_t iteration = 0; iteration < iterations; ++iteration) {
+                    do_not_optimize(fn());
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return seconds > 0 ? threads * iterations / seconds : 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t items = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+    const size_t pageSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+    const size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100000;
+    const size_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+
+    std::printf("order_items=%zu page_size=%zu iterations=%zu threads=%zu\n", items, pageSize, iterations, threads);
+
+    const Workload workload = make_workload(items, pageSize);
+
+    measure("heap", iterations, [&] { do_not_optimize(handle(workload)); });
+    measure("arena", iterations, [&] { do_not_optimize(handle_in_arena(workload)); });
+
+    for (size_t count = 1; count <= threads; count *= 2) {
+        const double heap = run_threads(count, iterations, [&] { return handle(workload); });
+        const double arena = run_threads(count, iterations, [&] { return handle_in_arena(workload); });
+        std::printf("threads=%-3zu heap %12.0f ops/s   arena %12.0f ops/s\n", count, heap, arena);
+    }
+
+    const RequestArenaStats stats = RequestArena::stats();
+    std::printf("arena scopes %llu, overflows %llu, reserved %zu bytes\n",
+                static_cast<unsigned long long>(stats.requests),
+                static_cast<unsigned long long>(stats.overflows), stats.reservedBytes);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// 基准程序共用的计时与统计工具
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+namespace TakeAwayBench
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 当前线程调用全局 operator new 的次数与字节数，由 alloc_counter.h 中替换的 operator new 累加
+    struct AllocationCount
+    {
+        uint64_t calls = 0;
+        uint64_t bytes = 0;
+    };
+
+    inline thread_local AllocationCount threadAllocations;
+
+    // 程序包含了 alloc_counter.h 时为 true，measure 才输出每次的分配次数
+    inline bool allocationCounterInstalled = false;
+
+    // 防止被测结果被编译器优化掉
+    template<typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // 单线程微基准：先预热，再计时 iterations 次，打印每次耗时
+    template<typename Fn>
+    double measure(const char* name, size_t iterations, Fn&& fn)
+    {
+        for (size_t index = 0; index < iterations / 10 + 1; ++index) {
+            fn();
+        }
+
+        const AllocationCount before = threadAllocations;
+        const auto start = Clock::now();
+        for (size_t index = 0; index < iterations; ++index) {
+            fn();
+        }
+        const double nanos = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+        if (allocationCounterInstalled) {
+            const double calls = static_cast<double>(threadAllocations.calls - before.calls) / iterations;
+            const double bytes = static_cast<double>(threadAllocations.bytes - before.bytes) / iterations;
+            std::printf("%-36s %10.1f ns/op  %12.0f ops/s  %8.1f allocs/op  %10.0f B/op\n",
+                        name, nanos, 1e9 / nanos, calls, bytes);
+        } else {
+            std::printf("%-36s %10.1f ns/op  %12.0f ops/s\n", name, nanos, 1e9 / nanos);
+        }
+        return nanos;
+    }
+
+    struct LatencySummary
+    {
+        size_t count = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double p999 = 0;
+        double max = 0;
+        double throughput = 0;      // 每秒请求数
+    };
+
+    // latencies 单位微秒，会被排序
+    inline LatencySummary summarize(std::vector<double>& latencies, double seconds)
+    {
+        LatencySummary summary;
+        summary.count = latencies.size();
+        if (latencies.empty()) {
+            return summary;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        auto at = [&](double q) {
+            return latencies[static_cast<size_t>(q * (latencies.size() - 1))];
+        };
+        summary.p50 = at(0.50);
+        summary.p99 = at(0.99);
+        summary.p999 = at(0.999);
+        summary.max = latencies.back();
+        summary.throughput = seconds > 0 ? latencies.size() / seconds : 0;
+        return summary;
+    }
+
+    inline void print_summary(const char* name, const LatencySummary& s)
+    {
+        std::printf("%-20s n=%8zu  p50=%9.1fus  p99=%9.1fus  p999=%9.1fus  max=%10.1fus  %9.0f req/s\n",
+                    name, s.count, s.p50, s.p99, s.p999, s.max, s.throughput);
+    }
+}
@@ -0,0 +1,89 @@
+// JSON 编解码与 ID 生成的单线程微基准
+//   build_rows  - 按 parse_result 的方式为每行构造 Json::Value 对象
+//   to_json     - 把菜单形状的结果数组序列化为紧凑 JSON
+//   parse_json  - 解析带 N 个订单项的 /order/create 请求体
+//   generate_*  - 订单、地址、管理员 ID 生成
+//
+// 用法: bench_codec [rows] [order_items] [iterations]
+
+#include <cstdlib>
+#include <string>
+
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "common.h"
+#include "id_generator.h"
+
+using namespace TakeAwayBench;
+using namespace TakeAwayPlatform;
+
+
+namespace
+{
+    // 与 DISH 表列一致的一行菜单数据
+    Json::Value build_rows(size_t rows)
+    {
+        Json::Value result(Json::arrayValue);
+        for (size_t index = 0; index < rows; ++index) {
+            Json::Value row(Json::objectValue);
+            row["dishId"] = "d0000000-0000-0000-0000-" + std::to_string(100000000000 + index);
+            row["merchantId"] = "m0000000-0000-0000-0000-000000000001";
+            row["categoryId"] = "c" + std::to_string(index % 12);
+            row["name"] = "招牌菜品 " + std::to_string(index);
+            row["price"] = 18.5 + static_cast<double>(index % 40);
+            row["description"] = "精选食材，现点现做，\"好评\"如潮";
+            row["imageUrl"] = "https://img.example.com/dish/" + std::to_string(index) + ".jpg";
+            row["stock"] = static_cast<int>(1000 - index % 1000);
+            row["sales"] = static_cast<int>(index * 7);
+            row["rating"] = 4.0 + static_cast<double>(index % 10) / 10.0;
+            row["status"] = 1;
+            result.append(row);
+        }
+        return result;
+    }
+
+    std::string order_body(size_t items)
+    {
+        Json::Value order(Json::objectValue);
+        order["userId"] = "u0000000-0000-0000-0000-000000000001";
+        order["merchantId"] = "m0000000-0000-0000-0000-000000000001";
+        order["addressId"] = "a1b2";
+        order["remark"] = "少放辣，谢谢";
+        order["totalPrice"] = 88.8;
+        for (size_t index = 0; index < items; ++index) {
+            Json::Value item(Json::objectValue);
+            item["dishId"] = "d0000000-0000-0000-0000-" + std::to_string(100000000000 + index);
+            item["dishName"] = "招牌菜品 " + std::to_string(index);
+            item["price"] = 18.5;
+            item["quantity"] = 2;
+            order["items"].append(item);
+        }
+        return to_json(order);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const size_t items = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+    const size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2000;
+
+    std::printf("rows=%zu order_items=%zu iterations=%zu\n", rows, items, iterations);
+
+    const Json::Value menu = build_rows(rows);
+    const std::string menuJson = to_json(menu);
+    const std::string body = order_body(items);
+    std::printf("menu json %zu bytes, order body %zu bytes\n", menuJson.size(), body.size());
+
+    measure("build_rows", iterations, [&] { do_not_optimize(build_rows(rows)); });
+    measure("to_json(menu)", iterations, [&] { do_not_optimize(to_json(menu)); });
+    measure("parse_json(menu)", iterations, [&] { do_not_optimize(parse_json(menuJson)); });
+    measure("parse_json(order body)", iterations * 10, [&] { do_not_optimize(parse_json(body)); });
+
+    measure("generate_uuid", iterations * 50, [] { do_not_optimize(generate_uuid()); });
+    measure("generate_uuid_v4", iterations * 50, [] { do_not_optimize(generate_uuid_v4()); });
+    measure("generate_uuid_v7", iterations * 50, [] { do_not_optimize(generate_uuid_v7()); });
+    measure("generate_short_id", iterations * 50, [] { do_not_optimize(generate_short_id()); });
+    measure("generate_admin_id", iterations * 50, [] { do_not_optimize(generate_admin_id()); });
+    return 0;
+}
@@ -0,0 +1,135 @@
+// 请求分发模型对比：
+//   handoff - 工作线程把处理函数包装成 packaged_task 投递到 ThreadPool，再阻塞在 future.get()
+//   direct  - 处理函数直接在工作线程上执行
+// 每个客户端线程模拟一个 httplib 工作线程，处理函数由一段 CPU 计算和一次模拟的数据库等待组成。
+//
+// 用法: bench_dispatch [workers] [requests_per_worker] [cpu_us] [io_us] [pool_threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        size_t workers = 16;
+        size_t requests = 500;
+        int cpuMicros = 20;
+        int ioMicros = 200;
+        size_t poolThreads = std::thread::hardware_concurrency();
+    };
+
+    // 模拟处理函数：先做一段 CPU 计算，再模拟一次数据库往返
+    std::string handle_request(const Options& options)
+    {
+        const auto until = Clock::now() + std::chrono::microseconds(options.cpuMicros);
+        unsigned value = 0;
+        while (Clock::now() < until) {
+            value = value * 31 + 7;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(options.ioMicros));
+        return std::to_string(value);
+    }
+
+    struct Summary
+    {
+        double p50;
+        double p99;
+        double p999;
+        double max;
+        double throughput;
+    };
+
+    Summary summarize(std::vector<double>& latencies, double seconds)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        auto at = [&](double q) {
+            size_t index = static_cast<size_t>(q * (latencies.size() - 1));
+            return latencies[index];
+        };
+        return { at(0.50), at(0.99), at(0.999), latencies.back(), latencies.size() / seconds };
+    }
+
+    template<typename Dispatch>
+    Summary run(const Options& options, Dispatch dispatch)
+    {
+        std::vector<std::vector<double>> perWorker(options.workers);
+        std::vector<std::thread> workers;
+
+        const auto start = Clock::now();
+        for (size_t w = 0; w < options.workers; ++w)
+        {
+            workers.emplace_back([&, w] {
+                auto& samples = perWorker[w];
+                samples.reserve(options.requests);
+                for (size_t index = 0; index < options.requests; ++index)
+                {
+                    const auto begin = Clock::now();
+                    dispatch();
+                    samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<double> all;
+        for (auto& samples : perWorker) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        return summarize(all, seconds);
+    }
+
+    void print(const char* name, const Summary& s)
+    {
+        std::printf("%-8s p50=%8.1fus p99=%8.1fus p999=%8.1fus max=%9.1fus  %9.0f req/s\n",
+                    name, s.p50, s.p99, s.p999, s.max, s.throughput);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (argc > 1) options.workers = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) options.requests = std::strtoul(argv[2], nullptr, 10);
+    if (argc > 3) options.cpuMicros = std::atoi(argv[3]);
+    if (argc > 4) options.ioMicros = std::atoi(argv[4]);
+    if (argc > 5) options.poolThreads = std::strtoul(argv[5], nullptr, 10);
+
+    std::printf("workers=%zu requests/worker=%zu cpu=%dus io=%dus pool=%zu\n",
+                options.workers, options.requests, options.cpuMicros, options.ioMicros,
+                options.poolThreads);
+
+    Summary direct = run(options, [&] {
+        std::string body = handle_request(options);
+        (void)body;
+    });
+
+    // 与旧实现一致：共享 ThreadPool，默认线程数为 hardware_concurrency
+    auto pool = std::make_unique<TakeAwayPlatform::ThreadPool>(options.poolThreads);
+    Summary handoff = run(options, [&] {
+        auto task = std::make_shared<std::packaged_task<std::string()>>([&] { return handle_request(options); });
+        std::future<std::string> result = task->get_future();
+        pool->enqueue([task] { (*task)(); });
+        std::string body = result.get();
+        (void)body;
+    });
+
+    print("direct", direct);
+    print("handoff", handoff);
+    return 0;
+}
@@ -0,0 +1,316 @@
+// 索引审计：用 EXPLAIN 检查服务端实际执行的查询，并测量查询与写入吞吐，需要可连接的数据库
+//   explain - 对每条预定义查询和运行时拼出的语句执行 EXPLAIN，
+//             全表扫描（预期扫描的全量加载除外）、filesort、临时表记为问题，存在问题时退出码为 2
+//   query   - 逐条重复执行上面的查询，输出每次的耗时
+//   write   - 加 --write 时测量下单（订单 + 3 个订单项 + 扣减库存，一个事务）与新增菜品的吞吐，
+//             测试数据以 remark / name 标记，结束后删除并恢复库存；只在测试库上使用
+// 示例参数取自库中已有的订单和菜品，空库上只能检查执行计划的形状。
+//
+// 对比索引调整前后：在同一份数据上先运行一次，执行 MigrateIndexes.sql 后再运行一次，
+// 两次使用相同的 iterations 与 --write 行数，比较 EXPLAIN 的 key / rows 与各项 ops/s。
+// 订单分片节点用指向该节点的配置文件另行运行（主库上的订单表为空时 explain 结果没有参考价值）。
+//
+// 用法: bench_index <config.json> [iterations] [--write rows]
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "common.h"
+#include "db_handler.h"
+#include "id_generator.h"
+
+using namespace TakeAwayBench;
+using namespace TakeAwayPlatform;
+
+
+namespace
+{
+    // 测试数据的标记
+    const char* const BENCH_MARKER = "bench-index";
+
+    // 写入测试使用的固定时间，不出现在真实数据的第一页
+    const char* const BENCH_TIME = "2000-01-01 00:00:00";
+
+    struct Samples
+    {
+        std::string userId = "no-user";
+        std::string merchantId = "no-merchant";
+        std::string addressId;
+        std::string orderId = "no-order";
+        std::string orderTime = "2099-01-01 00:00:00";
+        std::string dishId = "no-dish";
+        std::string dishName;
+        std::string categoryId;
+        std::vector<std::string> pageOrderIds;
+
+        bool writable() const { return !addressId.empty() && !categoryId.empty(); }
+    };
+
+    struct Check
+    {
+        std::string name;
+        std::string sql;
+        BoundValues params;
+        bool scanExpected = false;      // 全量加载与 LIKE '%...%'，本来就要扫描全表
+    };
+
+    std::string text(const Json::Value& value)
+    {
+        return value.isNull() ? "" : value.asString();
+    }
+
+    template<typename... Args>
+    BoundValues values(const Args&... params)
+    {
+        BoundValues bound;
+        (bound.emplace_back(params), ...);
+        return bound;
+    }
+
+    Samples load_samples(DatabaseHandler& db)
+    {
+        Samples samples;
+
+        const Json::Value orders = db.query(
+            "SELECT orderId, userId, merchantId, addressId, "
+            "DATE_FORMAT(orderTime, '%Y-%m-%d %H:%i:%s') AS orderTime "
+            "FROM `ORDER` ORDER BY orderTime DESC LIMIT 1");
+        if (orders.isArray() && !orders.empty()) {
+            samples.orderId = text(orders[0]["orderId"]);
+            samples.userId = text(orders[0]["userId"]);
+            samples.merchantId = text(orders[0]["merchantId"]);
+            samples.addressId = text(orders[0]["addressId"]);
+            samples.orderTime = text(orders[0]["orderTime"]);
+        } else {
+            std::printf("warning: ORDER is empty, order plans are not representative\n");
+        }
+
+        const Json::Value page = db.execute_sql(
+            "SELECT orderId FROM `ORDER` WHERE userId = ? LIMIT 20", values(samples.userId));
+        for (const Json::Value& row : page) {
+            samples.pageOrderIds.push_back(text(row["orderId"]));
+        }
+        if (samples.pageOrderIds.empty()) {
+            samples.pageOrderIds.push_back(samples.orderId);
+        }
+
+        const Json::Value dishes = db.query(
+            "SELECT dishId, merchantId, categoryId, name FROM DISH ORDER BY sales DESC LIMIT 1");
+        if (dishes.isArray() && !dishes.empty()) {
+            samples.dishId = text(dishes[0]["dishId"]);
+            samples.dishName = text(dishes[0]["name"]);
+            samples.categoryId = text(dishes[0]["categoryId"]);
+            if (samples.merchantId == "no-merchant") {
+                samples.merchantId = text(dishes[0]["merchantId"]);
+            }
+        } else {
+            std::printf("warning: DISH is empty, dish plans are not representative\n");
+        }
+        return samples;
+    }
+
+    // 服务端执行的每条读语句及示例参数；INSERT 没有可比较的执行计划，不在这里
+    std::vector<Check> build_checks(const Samples& s)
+    {
+        std::vector<Check> checks;
+        auto add = [&](StmtId id, BoundValues params, bool scanExpected = false) {
+            checks.push_back({statement_name(id), statement_sql(id), std::move(params), scanExpected});
+        };
+
+        add(StmtId::MenuAll, values(), true);
+        add(StmtId::UserLogin, values(s.userId, "bench", "bench"));
+        add(StmtId::AdminLogin, values("bench", "bench", "bench"));
+        add(StmtId::MerchantReviews, values(s.merchantId, 21));
+        add(StmtId::MerchantReviewsAfter, values(s.merchantId, s.orderTime, s.orderTime, "~", 21));
+        add(StmtId::MerchantDishes, values(s.merchantId));
+        add(StmtId::CategoriesByMerchant, values(s.merchantId));
+        add(StmtId::MerchantSearch, values("bench"), true);
+        add(StmtId::OrdersByUserFirstPage, values(s.userId, 21));
+        add(StmtId::OrdersByUserAfter, values(s.userId, s.orderTime, s.orderTime, s.orderId, 21));
+        add(StmtId::DishReviews, values(s.dishId, 21));
+        add(StmtId::DishReviewsAfter, values(s.dishId, s.orderTime, s.orderTime, "~", 21));
+        add(StmtId::SearchMerchantsAll, values(), true);
+        add(StmtId::SearchDishesAll, values(), true);
+        add(StmtId::OrderExists, values(s.orderId));
+        add(StmtId::MerchantOrdersRecent, values(s.merchantId, 20));
+        add(StmtId::MerchantOrderStats, values(s.merchantId));
+        add(StmtId::OpenMerchantIds, values(100));
+        add(StmtId::RatingSummaryGet, values("dish", s.dishId));
+        add(StmtId::DishRatingRefresh, values(s.dishId));
+        add(StmtId::OrderStatusSnapshot, values(s.orderId));
+
+        BoundValues stock;
+        BoundValues dishIds;
+        for (int index = 0; index < 3; ++index) {
+            stock.emplace_back(s.dishId);
+            stock.emplace_back(1);
+            dishIds.emplace_back(s.dishId);
+        }
+        checks.push_back({"dish_stock_deduct x3", dish_stock_deduct_sql(3), stock, false});
+        checks.push_back({"dish_stock_by_ids x3", dish_stock_by_ids_sql(3), dishIds, false});
+
+        BoundValues orderIds;
+        for (const std::string& orderId : s.pageOrderIds) {
+            orderIds.emplace_back(orderId);
+        }
+        checks.push_back({"order_items_by_orders x" + std::to_string(orderIds.size()),
+                          order_items_by_orders_sql(orderIds.size()), orderIds, false});
+        return checks;
+    }
+
+    bool is_read(const std::string& sql)
+    {
+        return sql.compare(0, 6, "SELECT") == 0;
+    }
+
+    // 输出执行计划，返回发现的问题数
+    int explain(DatabaseHandler& db, const Check& check)
+    {
+        const Json::Value plan = db.execute_sql("EXPLAIN " + check.sql, check.params);
+
+        int problems = 0;
+        std::printf("%s\n", check.name.c_str());
+        for (const Json::Value& row : plan) {
+            const std::string table = text(row["table"]);
+            const std::string type = text(row["type"]);
+            const std::string extra = text(row["Extra"]);
+
+            std::string issues;
+            // <derived2> 之类是语句内的派生表（例如参数拼成的 UNION），不是问题
+            const bool realTable = !table.empty() && table[0] != '<';
+            if (realTable && type == "ALL" && !check.scanExpected) {
+                issues += " [full scan]";
+            }
+            if (extra.find("Using filesort") != std::string::npos) {
+                issues += " [filesort]";
+            }
+            if (extra.find("Using temporary") != std::string::npos) {
+                issues += " [temporary]";
+            }
+            if (!issues.empty()) {
+                ++problems;
+            }
+
+            std::printf("    %-16s type=%-7s key=%-28s rows=%-8s %s%s\n",
+                        table.c_str(), type.c_str(), text(row["key"]).c_str(), text(row["rows"]).c_str(),
+                        extra.c_str(), issues.c_str());
+        }
+        return problems;
+    }
+
+    // 一次下单：订单、3 个订单项的多行插入、扣减库存，与 /order/create 的写入相同；返回扣减的库存
+    uint64_t create_order(DatabaseHandler& db, const Samples& s)
+    {
+        const std::string orderId = generate_uuid();
+
+        BoundValues items;
+        for (int index = 0; index < 3; ++index) {
+            items.emplace_back(generate_uuid());
+            items.emplace_back(orderId);
+            items.emplace_back(s.dishId);
+            items.emplace_back(s.dishName);
+            items.emplace_back(18.5);
+            items.emplace_back(1);
+        }
+
+        Transaction transaction(db);
+        db.execute(StmtId::OrderInsert, orderId, s.userId, s.merchantId, 55.5,
+            BENCH_TIME, BENCH_TIME, BENCH_TIME, BENCH_TIME, s.addressId, BENCH_MARKER);
+        db.update_sql(multi_row_sql(StmtId::OrderItemInsert, 3), items);
+        const uint64_t deducted = db.update_sql(dish_stock_deduct_sql(1), values(s.dishId, 1));
+        transaction.commit();
+        return deducted;
+    }
+
+    // 新增菜品，与 /merchant/add_dish 的写入相同
+    void create_dish(DatabaseHandler& db, const Samples& s)
+    {
+        db.execute(StmtId::DishInsert, generate_uuid(), s.merchantId, s.categoryId,
+            std::string(BENCH_MARKER) + "-" + generate_short_id(), "", 18.5, "", 100, 0, 0.0, 1);
+    }
+
+    void remove_test_rows(DatabaseHandler& db, const Samples& s, uint64_t deducted)
+    {
+        if (deducted > 0) {
+            db.update_sql(dish_stock_restore_sql(1), values(s.dishId, static_cast<int64_t>(deducted)));
+        }
+        const uint64_t orders = db.update_sql("DELETE FROM `ORDER` WHERE remark = ?", values(BENCH_MARKER));
+        const uint64_t dishes = db.update_sql("DELETE FROM DISH WHERE merchantId = ? AND name LIKE ?",
+            values(s.merchantId, std::string(BENCH_MARKER) + "-%"));
+        std::printf("removed %llu test orders, %llu test dishes\n",
+                    static_cast<unsigned long long>(orders), static_cast<unsigned long long>(dishes));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <config.json> [iterations] [--write rows]\n", argv[0]);
+        return 1;
+    }
+
+    size_t iterations = 200;
+    size_t writeRows = 0;
+    for (int index = 2; index < argc; ++index) {
+        if (std::strcmp(argv[index], "--write") == 0 && index + 1 < argc) {
+            writeRows = std::strtoul(argv[++index], nullptr, 10);
+        } else {
+            iterations = std::strtoul(argv[index], nullptr, 10);
+        }
+    }
+
+    const Json::Value config = load_config(argv[1])["database"];
+    const DBConfig dbConfig {
+        config["host"].asString(),
+        config["port"].asInt(),
+        config["user"].asString(),
+        config["password"].asString(),
+        config["name"].asString()
+    };
+
+    int problems = 0;
+    try {
+        DatabaseHandler db(dbConfig);
+        const Samples samples = load_samples(db);
+        const std::vector<Check> checks = build_checks(samples);
+
+        std::printf("== explain\n");
+        for (const Check& check : checks) {
+            problems += explain(db, check);
+        }
+        std::printf("%d problem(s)\n", problems);
+
+        std::printf("== query, iterations=%zu\n", iterations);
+        for (const Check& check : checks) {
+            if (!is_read(check.sql)) {
+                continue;
+            }
+            measure(check.name.c_str(), iterations, [&] {
+                do_not_optimize(db.execute_sql(check.sql, check.params));
+            });
+        }
+
+        if (writeRows > 0) {
+            if (!samples.writable()) {
+                std::printf("== write skipped: no existing order/dish to copy user, address and category from\n");
+            } else {
+                std::printf("== write, rows=%zu\n", writeRows);
+                uint64_t deducted = 0;
+                try {
+                    measure("order_create", writeRows, [&] { deducted += create_order(db, samples); });
+                    measure("dish_insert", writeRows, [&] { create_dish(db, samples); });
+                } catch (const std::exception& e) {
+                    std::fprintf(stderr, "write failed: %s\n", e.what());
+                }
+                remove_test_rows(db, samples, deducted);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "bench_index failed: %s\n", e.what());
+        return 1;
+    }
+    return problems > 0 ? 2 : 0;
+}
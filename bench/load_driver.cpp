@@ -0,0 +1,322 @@
+// HTTP 压测驱动：按给定比例混合浏览与下单请求，报告各接口吞吐量和 p50/p99/p999
+//
+//   menu          GET  /menu
+//   dishes        GET  /merchant/dishes      随机选一个商家
+//   order_create  POST /order/create         随机选同一商家的 N 个菜品
+//   order_query   GET  /order/query          首页订单
+//
+// 启动时先请求一次 /menu，得到商家与菜品列表。下单需要已存在的用户与地址，
+// 未指定 --user / --address 时不发送 order_create，未指定 --user 时不发送 order_query。
+//
+// 用法: bench_load [--host 127.0.0.1] [--port 9090] [--threads 8] [--duration 30] [--warmup 3]
+//                  [--items 3] [--user userId] [--address addressId]
+//                  [--mix menu:20,dishes:50,order_create:10,order_query:20] [--seed 1]
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <httplib.h>
+
+#include "bench_util.h"
+#include "common.h"
+
+using namespace TakeAwayBench;
+using TakeAwayPlatform::to_json;
+
+
+namespace
+{
+    enum Route
+    {
+        Menu = 0,
+        Dishes,
+        OrderCreate,
+        OrderQuery,
+        RouteCount
+    };
+
+    const char* const ROUTE_NAMES[RouteCount] = {"menu", "dishes", "order_create", "order_query"};
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 9090;
+        size_t threads = 8;
+        int duration = 30;          // 秒，不含预热
+        int warmup = 3;             // 秒，预热期间的请求不计入统计
+        size_t items = 3;
+        std::string userId;
+        std::string addressId;
+        unsigned weights[RouteCount] = {20, 50, 10, 20};
+        unsigned seed = 1;
+    };
+
+    struct Dish
+    {
+        std::string dishId;
+        std::string name;
+        double price;
+    };
+
+    // 商家 -> 菜品
+    using Catalog = std::map<std::string, std::vector<Dish>>;
+
+    struct WorkerResult
+    {
+        std::vector<double> latencies[RouteCount];
+        size_t errors[RouteCount] = {};
+    };
+
+    bool parse_mix(const std::string& text, unsigned (&weights)[RouteCount])
+    {
+        unsigned parsed[RouteCount] = {};
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(',', pos);
+            if (end == std::string::npos) end = text.size();
+            const std::string entry = text.substr(pos, end - pos);
+            const size_t colon = entry.find(':');
+            if (colon == std::string::npos) return false;
+
+            const std::string name = entry.substr(0, colon);
+            size_t route = 0;
+            while (route < RouteCount && name != ROUTE_NAMES[route]) ++route;
+            if (route == RouteCount) return false;
+
+            parsed[route] = static_cast<unsigned>(std::strtoul(entry.c_str() + colon + 1, nullptr, 10));
+            pos = end + 1;
+        }
+        std::memcpy(weights, parsed, sizeof(parsed));
+        return true;
+    }
+
+    bool parse_options(int argc, char** argv, Options& options)
+    {
+        for (int index = 1; index + 1 < argc; index += 2) {
+            const std::string key = argv[index];
+            const std::string value = argv[index + 1];
+            if (key == "--host") options.host = value;
+            else if (key == "--port") options.port = std::atoi(value.c_str());
+            else if (key == "--threads") options.threads = std::max<size_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+            else if (key == "--duration") options.duration = std::atoi(value.c_str());
+            else if (key == "--warmup") options.warmup = std::atoi(value.c_str());
+            else if (key == "--items") options.items = std::max<size_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+            else if (key == "--user") options.userId = value;
+            else if (key == "--address") options.addressId = value;
+            else if (key == "--seed") options.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+            else if (key == "--mix") {
+                if (!parse_mix(value, options.weights)) return false;
+            }
+            else return false;
+        }
+        return (argc % 2) == 1;
+    }
+
+    double as_price(const Json::Value& value)
+    {
+        // DECIMAL 列可能以字符串形式返回
+        return value.isString() ? std::atof(value.asCString()) : value.asDouble();
+    }
+
+    bool load_catalog(const Options& options, Catalog& catalog)
+    {
+        httplib::Client client(options.host, options.port);
+        client.set_read_timeout(30);
+        auto result = client.Get("/menu");
+        if (!result || result->status != 200) {
+            std::fprintf(stderr, "GET /menu failed\n");
+            return false;
+        }
+
+        Json::Value rows;
+        if (!TakeAwayPlatform::parse_json(result->body.data(), result->body.data() + result->body.size(), rows)
+            || !rows.isArray()) {
+            std::fprintf(stderr, "GET /menu returned an unexpected body\n");
+            return false;
+        }
+
+        for (const auto& row : rows) {
+            catalog[row["merchantId"].asString()].push_back({
+                row["dishId"].asString(), row["name"].asString(), as_price(row["price"])});
+        }
+        return !catalog.empty();
+    }
+
+    std::string order_body(const Options& options, const std::string& merchantId,
+                           const std::vector<Dish>& dishes, std::mt19937& rng)
+    {
+        Json::Value order(Json::objectValue);
+        order["userId"] = options.userId;
+        order["merchantId"] = merchantId;
+        order["addressId"] = options.addressId;
+        order["remark"] = "bench";
+        order["items"] = Json::Value(Json::arrayValue);
+
+        double total = 0;
+        std::uniform_int_distribution<size_t> pick(0, dishes.size() - 1);
+        for (size_t index = 0; index < options.items; ++index) {
+            const Dish& dish = dishes[pick(rng)];
+            Json::Value item(Json::objectValue);
+            item["dishId"] = dish.dishId;
+            item["dishName"] = dish.name;
+            item["price"] = dish.price;
+            item["quantity"] = 1;
+            order["items"].append(item);
+            total += dish.price;
+        }
+        order["totalPrice"] = total;
+        return to_json(order);
+    }
+
+    // 服务端部分 GET 接口从请求体读取参数，这里统一构造带 JSON 体的请求
+    httplib::Request json_request(const char* method, const std::string& path, std::string body)
+    {
+        httplib::Request request;
+        request.method = method;
+        request.path = path;
+        request.body = std::move(body);
+        request.set_header("Content-Type", "application/json");
+        return request;
+    }
+
+    void worker(const Options& options, const Catalog& catalog, const std::vector<const std::string*>& merchants,
+                Clock::time_point measureFrom, Clock::time_point until, size_t index, WorkerResult& out)
+    {
+        httplib::Client client(options.host, options.port);
+        client.set_keep_alive(true);
+        client.set_read_timeout(30);
+
+        std::mt19937 rng(options.seed * 7919u + static_cast<unsigned>(index));
+        std::discrete_distribution<int> routes(std::begin(options.weights), std::end(options.weights));
+        std::uniform_int_distribution<size_t> pickMerchant(0, merchants.size() - 1);
+
+        for (auto& latencies : out.latencies) {
+            latencies.reserve(1 << 16);
+        }
+
+        while (true) {
+            const auto begin = Clock::now();
+            if (begin >= until) {
+                break;
+            }
+
+            const Route route = static_cast<Route>(routes(rng));
+            const std::string& merchantId = *merchants[pickMerchant(rng)];
+
+            httplib::Result result;
+            switch (route)
+            {
+                case Menu:
+                    result = client.Get("/menu");
+                    break;
+                case Dishes: {
+                    Json::Value body(Json::objectValue);
+                    body["merchantId"] = merchantId;
+                    result = client.send(json_request("GET", "/merchant/dishes", to_json(body)));
+                    break;
+                }
+                case OrderCreate:
+                    result = client.Post("/order/create",
+                        order_body(options, merchantId, catalog.at(merchantId), rng), "application/json");
+                    break;
+                case OrderQuery:
+                    result = client.Get("/order/query?userId=" + options.userId + "&pageSize=20");
+                    break;
+                default:
+                    break;
+            }
+
+            const auto end = Clock::now();
+            if (begin < measureFrom) {
+                continue;
+            }
+
+            out.latencies[route].push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+            if (!result || result->status < 200 || result->status >= 300) {
+                ++out.errors[route];
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--host h] [--port p] [--threads n] [--duration s] [--warmup s] "
+                             "[--items n] [--user id] [--address id] [--mix name:weight,...] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    if (options.userId.empty() || options.addressId.empty()) {
+        options.weights[OrderCreate] = 0;
+    }
+    if (options.userId.empty()) {
+        options.weights[OrderQuery] = 0;
+    }
+    if (std::accumulate(std::begin(options.weights), std::end(options.weights), 0u) == 0) {
+        std::fprintf(stderr, "request mix is empty\n");
+        return 1;
+    }
+
+    Catalog catalog;
+    if (!load_catalog(options, catalog)) {
+        return 1;
+    }
+    std::vector<const std::string*> merchants;
+    for (const auto& entry : catalog) {
+        merchants.push_back(&entry.first);
+    }
+
+    std::printf("target=%s:%d threads=%zu duration=%ds warmup=%ds items=%zu merchants=%zu mix=",
+                options.host.c_str(), options.port, options.threads, options.duration, options.warmup,
+                options.items, merchants.size());
+    for (size_t route = 0; route < RouteCount; ++route) {
+        std::printf("%s%s:%u", route ? "," : "", ROUTE_NAMES[route], options.weights[route]);
+    }
+    std::printf("\n");
+
+    const auto start = Clock::now();
+    const auto measureFrom = start + std::chrono::seconds(options.warmup);
+    const auto until = measureFrom + std::chrono::seconds(options.duration);
+
+    std::vector<WorkerResult> results(options.threads);
+    std::vector<std::thread> threads;
+    for (size_t index = 0; index < options.threads; ++index) {
+        threads.emplace_back([&, index] {
+            worker(options, catalog, merchants, measureFrom, until, index, results[index]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - measureFrom).count();
+
+    std::vector<double> all;
+    for (size_t route = 0; route < RouteCount; ++route) {
+        std::vector<double> latencies;
+        size_t errors = 0;
+        for (auto& result : results) {
+            latencies.insert(latencies.end(), result.latencies[route].begin(), result.latencies[route].end());
+            errors += result.errors[route];
+        }
+        if (latencies.empty()) {
+            continue;
+        }
+        all.insert(all.end(), latencies.begin(), latencies.end());
+
+        print_summary(ROUTE_NAMES[route], summarize(latencies, seconds));
+        if (errors > 0) {
+            std::printf("%-20s errors=%zu\n", "", errors);
+        }
+    }
+    print_summary("total", summarize(all, seconds));
+    return 0;
+}
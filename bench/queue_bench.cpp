@@ -0,0 +1,145 @@
+// TaskQueue / ThreadPool 吞吐量
+//   queue  - 多生产者多消费者直接读写无锁注入队列
+//   pool   - 外部线程向 ThreadPool 提交空任务，等待全部执行完
+//   nested - 任务在工作线程内部再提交子任务（走本地队列与窃取）
+//
+// 用法: bench_queue [producers] [consumers] [tasks] [pool_threads]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "task_queue.h"
+#include "thread_pool.h"
+
+using namespace TakeAwayBench;
+using TakeAwayPlatform::Task;
+using TakeAwayPlatform::TaskQueue;
+using TakeAwayPlatform::ThreadPool;
+
+
+namespace
+{
+    struct Options
+    {
+        size_t producers = 4;
+        size_t consumers = 4;
+        size_t tasks = 1000000;
+        size_t poolThreads = std::thread::hardware_concurrency();
+    };
+
+    void report(const char* name, size_t tasks, Clock::time_point start)
+    {
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("%-8s %10zu tasks  %8.3fs  %8.2f Mops/s  %7.1f ns/task\n",
+                    name, tasks, seconds, tasks / seconds / 1e6, seconds * 1e9 / tasks);
+    }
+
+    void bench_queue(const Options& options)
+    {
+        TaskQueue queue(4096);
+        std::atomic<size_t> consumed {0};
+        std::atomic<uint64_t> checksum {0};
+        const size_t perProducer = options.tasks / options.producers;
+        const size_t total = perProducer * options.producers;
+
+        const auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < options.producers; ++p) {
+            threads.emplace_back([&] {
+                for (size_t index = 0; index < perProducer; ++index) {
+                    Task task([] {});
+                    while (!queue.try_push(task)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (size_t c = 0; c < options.consumers; ++c) {
+            threads.emplace_back([&] {
+                Task task;
+                uint64_t local = 0;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (queue.try_pop(task)) {
+                        task();
+                        task.reset();
+                        ++local;
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                checksum.fetch_add(local);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        report("queue", total, start);
+        do_not_optimize(checksum.load());
+    }
+
+    void bench_pool(const Options& options)
+    {
+        std::atomic<size_t> done {0};
+        const auto start = Clock::now();
+        {
+            ThreadPool pool(options.poolThreads);
+            const size_t perProducer = options.tasks / options.producers;
+
+            std::vector<std::thread> producers;
+            for (size_t p = 0; p < options.producers; ++p) {
+                producers.emplace_back([&] {
+                    for (size_t index = 0; index < perProducer; ++index) {
+                        pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            // 析构时执行完剩余任务
+        }
+        report("pool", done.load(), start);
+    }
+
+    void bench_nested(const Options& options)
+    {
+        constexpr size_t FANOUT = 16;
+        std::atomic<size_t> done {0};
+        const auto start = Clock::now();
+        {
+            ThreadPool pool(options.poolThreads);
+            const size_t roots = options.tasks / FANOUT;
+            for (size_t index = 0; index < roots; ++index) {
+                pool.enqueue([&pool, &done] {
+                    for (size_t child = 0; child < FANOUT - 1; ++child) {
+                        pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                    }
+                    done.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        }
+        report("nested", done.load(), start);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (argc > 1) options.producers = std::max<size_t>(1, std::strtoul(argv[1], nullptr, 10));
+    if (argc > 2) options.consumers = std::max<size_t>(1, std::strtoul(argv[2], nullptr, 10));
+    if (argc > 3) options.tasks = std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) options.poolThreads = std::strtoul(argv[4], nullptr, 10);
+
+    std::printf("producers=%zu consumers=%zu tasks=%zu pool=%zu\n",
+                options.producers, options.consumers, options.tasks, options.poolThreads);
+
+    bench_queue(options);
+    bench_pool(options);
+    bench_nested(options);
+    return 0;
+}
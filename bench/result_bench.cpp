@@ -0,0 +1,65 @@
+// 结果集转 JSON 的两种方式对比，需要可连接的数据库
+//   parse_result - execute() 为每行构造 Json::Value，再 to_json
+//   row_writer   - execute_result() 后由 JsonRowWriter 直接写出 JSON 文本
+// 两者执行同一条 MenuAll 查询，耗时包含数据库往返。
+//
+// 用法: bench_result <config.json> [iterations]
+
+#include <cstdlib>
+#include <string>
+
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "common.h"
+#include "db_handler.h"
+#include "json_row_writer.h"
+
+using namespace TakeAwayBench;
+using namespace TakeAwayPlatform;
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <config.json> [iterations]\n", argv[0]);
+        return 1;
+    }
+    const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+
+    const Json::Value config = load_config(argv[1])["database"];
+    const DBConfig dbConfig {
+        config["host"].asString(),
+        config["port"].asInt(),
+        config["user"].asString(),
+        config["password"].asString(),
+        config["name"].asString()
+    };
+
+    try {
+        DatabaseHandler db(dbConfig);
+
+        std::string body;
+        {
+            mysqlx::SqlResult result = db.execute_result(StmtId::MenuAll);
+            JsonRowWriter writer(result);
+            writer.write_all(body);
+            std::printf("MenuAll: %zu rows, %zu bytes, iterations=%zu\n", writer.rows(), body.size(), iterations);
+        }
+
+        measure("parse_result + to_json", iterations, [&] {
+            do_not_optimize(to_json(db.execute(StmtId::MenuAll)));
+        });
+
+        measure("execute_result + JsonRowWriter", iterations, [&] {
+            std::string out;
+            mysqlx::SqlResult result = db.execute_result(StmtId::MenuAll);
+            JsonRowWriter writer(result);
+            writer.write_all(out);
+            do_not_optimize(out);
+        });
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "bench_result failed: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
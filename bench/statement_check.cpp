@@ -0,0 +1,108 @@
+// 参数绑定冒烟检查，需要可连接的数据库
+// 在同一连接上把带参数的语句各执行多轮，每轮换一组参数：
+// 若某一轮带上了上一轮的参数，会因参数过多失败或返回上一轮的结果。
+// 只执行只读语句。
+//
+// 用法: bench_statements <config.json> [rounds]
+// 全部通过返回 0，有失败返回 2
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "db_handler.h"
+
+using namespace TakeAwayPlatform;
+
+
+namespace
+{
+    struct Check
+    {
+        std::string name;
+        std::function<bool(DatabaseHandler&, int)> run;   // 参数为轮次，返回结果是否符合这一轮的参数
+    };
+
+    std::vector<Check> make_checks()
+    {
+        std::vector<Check> checks;
+
+        // LIMIT 随轮次变化，行数超过本轮的 LIMIT 说明用的是旧参数
+        checks.push_back({"open_merchant_ids", [](DatabaseHandler& db, int round) {
+            return db.execute(StmtId::OpenMerchantIds, round).size() <= static_cast<Json::ArrayIndex>(round);
+        }});
+        checks.push_back({"order_exists", [](DatabaseHandler& db, int round) {
+            return db.execute(StmtId::OrderExists, "statement-check-" + std::to_string(round)).empty();
+        }});
+        checks.push_back({"merchant_search", [](DatabaseHandler& db, int round) {
+            db.execute(StmtId::MerchantSearch, "statement-check-" + std::to_string(round));
+            return true;
+        }});
+
+        // 动态语句走 execute_sql，返回值直接反映本轮绑定的参数
+        checks.push_back({"dynamic", [](DatabaseHandler& db, int round) {
+            BoundValues params;
+            params.emplace_back(round);
+            const Json::Value rows = db.execute_sql("SELECT ? AS round", params);
+            return rows.size() == 1 && rows[0]["round"].asInt() == round;
+        }});
+        return checks;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <config.json> [rounds]\n", argv[0]);
+        return 1;
+    }
+    const int rounds = argc > 2 ? std::max(2, std::atoi(argv[2])) : 3;
+
+    const Json::Value config = load_config(argv[1])["database"];
+    const DBConfig dbConfig {
+        config["host"].asString(),
+        config["port"].asInt(),
+        config["user"].asString(),
+        config["password"].asString(),
+        config["name"].asString()
+    };
+
+    DatabaseHandler db(dbConfig);
+    if (!db.is_open()) {
+        std::fprintf(stderr, "bench_statements: cannot connect to %s:%d\n", dbConfig.host.c_str(), dbConfig.port);
+        return 1;
+    }
+
+    int failures = 0;
+    for (const Check& check : make_checks()) {
+        bool failed = false;
+        for (int round = 1; round <= rounds && !failed; ++round) {
+            try {
+                if (!check.run(db, round)) {
+                    std::printf("FAIL %-20s round %d: result does not match the bound parameters\n", check.name.c_str(), round);
+                    failed = true;
+                }
+            } catch (const std::exception& e) {
+                std::printf("FAIL %-20s round %d: %s\n", check.name.c_str(), round, e.what());
+                failed = true;
+            }
+        }
+        // 出错时连接会被标记为可疑，换到下一项检查前恢复
+        if (db.is_suspect()) {
+            std::printf("FAIL %-20s connection marked suspect\n", check.name.c_str());
+            failed = true;
+            db.clear_suspect();
+        }
+        if (!failed) {
+            std::printf("ok   %-20s %d rounds\n", check.name.c_str(), rounds);
+        }
+        failures += failed ? 1 : 0;
+    }
+
+    std::printf("%s: %d check(s) failed, %d round(s) each\n", failures ? "FAILED" : "OK", failures, rounds);
+    return failures ? 2 : 0;
+}
@@ -21,6 +21,19 @@ namespace TakeAwayPlatform
     Json::Value load_config(const std::string& path);
 
 
+    // ====================== JSON 编解码 ======================
+    // 解析器与输出器按线程缓存，重复调用不再重新构造
+
+    // 解析 [begin, end) 中的 JSON，失败时返回 false 并写入错误信息
+    bool parse_json(const char* begin, const char* end, Json::Value& root, std::string* errors = nullptr);
+
+    // 解析 JSON 文本，失败抛出 std::runtime_error
+    Json::Value parse_json(const std::string& text);
+
+    // 紧凑格式输出（无缩进、无换行，中文原样输出）
+    std::string to_json(const Json::Value& value);
+
+
     // 数据库配置结构
     struct DBConfig {
         std::string host;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include <json/json.h>
+
+
+namespace TakeAwayPlatform
+{
+    // ID 生成参数
+    struct IdOptions
+    {
+        // generate_uuid 输出按时间递增的 UUIDv7；
+        // 主键按插入顺序写到聚簇索引末尾，减少 ORDER / ORDER_ITEM 等表的页分裂
+        bool timeOrdered = true;
+    };
+
+    // 从 config.json 的 id 节读取参数
+    IdOptions load_id_options(const Json::Value& config);
+
+    // 进程启动时调用一次
+    void configure_ids(const IdOptions& options);
+
+    // 长度 36 的 UUID，按配置输出 v7 或 v4
+    std::string generate_uuid();
+
+    // 随机 UUID（RFC 4122 v4）
+    std::string generate_uuid_v4();
+
+    // 时间有序 UUID（RFC 9562 v7）：48 位毫秒时间戳 + 12 位序号 + 62 位随机数
+    // 同一进程内严格递增，十六进制小写，按字符串比较即按时间排序
+    std::string generate_uuid_v7();
+
+    // 地址、配送、支付记录使用的短 ID，字符取自 [a-z0-9]
+    std::string generate_short_id(int length = 4);
+
+    // 管理员 ID，十六进制字符
+    std::string generate_admin_id(int length = 6);
+}
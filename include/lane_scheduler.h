@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <json/json.h>
+
+
+namespace TakeAwayPlatform
+{
+
+    // 请求调度通道：不同类别的路由各自限制并发，互不挤占
+    enum class Lane
+    {
+        Checkout = 0,   // 下单、支付
+        Write,          // 其他写操作
+        Browse,         // 浏览类只读查询
+        Auth,           // 登录：校验密码的开销不占用其他通道
+
+        Count
+    };
+
+    constexpr size_t LANE_COUNT = static_cast<size_t>(Lane::Count);
+
+    const char* lane_name(Lane lane);
+
+    struct LaneOptions
+    {
+        size_t maxConcurrency = 1;                  // 同时执行的请求数上限
+        size_t maxQueue = 0;                        // 允许排队等待的请求数
+        std::chrono::milliseconds maxWait {0};      // 排队最长等待时间
+        bool adaptive = true;                       // 按延迟梯度在 [minConcurrency, maxConcurrency] 内调整并发
+        size_t minConcurrency = 1;
+    };
+
+    struct LaneStats
+    {
+        uint64_t admitted = 0;
+        uint64_t rejected = 0;      // 队列已满直接拒绝
+        uint64_t timeouts = 0;      // 排队超时
+        size_t active = 0;
+        size_t waiting = 0;
+        size_t limit = 0;           // 当前并发上限
+    };
+
+    // 按通道的并发准入控制
+    // 工作线程进入处理函数前先申请许可，超出并发上限时在有限队列里等待，
+    // 队列满或等待超时则立即拒绝，浏览流量的突发不会占满工作线程和数据库连接。
+    // adaptive 通道的并发上限按梯度法调整：比较近期平均处理时间与无排队时的最短处理时间，
+    // 近期明显变慢说明下游开始排队，上限按比例收缩；延迟恢复后再以 sqrt(limit) 的余量回升。
+    class LaneScheduler
+    {
+    public:
+        class Permit
+        {
+        public:
+            Permit() = default;
+            Permit(LaneScheduler* scheduler, Lane lane)
+                : scheduler(scheduler), lane(lane), admittedAt(std::chrono::steady_clock::now()) {}
+            ~Permit() { release(); }
+
+            Permit(Permit&& other) noexcept
+                : scheduler(other.scheduler), lane(other.lane), admittedAt(other.admittedAt) {
+                other.scheduler = nullptr;
+            }
+            Permit& operator=(Permit&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    scheduler = other.scheduler;
+                    lane = other.lane;
+                    admittedAt = other.admittedAt;
+                    other.scheduler = nullptr;
+                }
+                return *this;
+            }
+
+            Permit(const Permit&) = delete;
+            Permit& operator=(const Permit&) = delete;
+
+            explicit operator bool() const { return scheduler != nullptr; }
+
+            // 归还许可，持有时长作为一次延迟采样
+            void release() {
+                if (scheduler) {
+                    scheduler->release(lane, std::chrono::steady_clock::now() - admittedAt);
+                    scheduler = nullptr;
+                }
+            }
+
+        private:
+            LaneScheduler* scheduler = nullptr;
+            Lane lane = Lane::Browse;
+            std::chrono::steady_clock::time_point admittedAt;
+        };
+
+        // workerCount 为 HTTP 工作线程数，用于推导未配置通道的默认值
+        LaneScheduler(const Json::Value& config, size_t workerCount);
+
+        LaneScheduler(const LaneScheduler&) = delete;
+        LaneScheduler& operator=(const LaneScheduler&) = delete;
+
+        // 申请许可，失败时返回空许可；排队不超过 maxWait，也不超过 deadline
+        Permit admit(Lane lane,
+                     std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+        LaneStats stats(Lane lane) const;
+
+        const LaneOptions& options(Lane lane) const;
+
+    private:
+        struct LaneState
+        {
+            LaneOptions options;
+
+            mutable std::mutex mtx;
+            std::condition_variable available;
+            size_t active = 0;
+            size_t waiting = 0;
+
+            // 梯度法状态，受 mtx 保护
+            double limit = 1.0;
+            double shortRtt = 0.0;      // 近期平均处理时间（秒）
+            double minRtt = 0.0;        // 上一个采样窗口内的最短处理时间，视为无排队时的基线
+            double windowMinRtt = 0.0;
+            size_t windowSamples = 0;
+
+            std::atomic<uint64_t> admitted {0};
+            std::atomic<uint64_t> rejected {0};
+            std::atomic<uint64_t> timeouts {0};
+        };
+
+        void release(Lane lane, std::chrono::steady_clock::duration held);
+
+        static void update_limit(LaneState& state, double rtt, size_t inflight);
+
+        static size_t current_limit(const LaneState& state);
+
+        std::array<LaneState, LANE_COUNT> lanes;
+    };
+
+}
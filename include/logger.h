@@ -0,0 +1,244 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// 编译期最低日志级别：0 DEBUG、1 INFO、2 WARN、3 ERROR
+// 低于该级别的日志语句只做类型检查，不生成任何代码
+#ifndef TAKEAWAY_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define TAKEAWAY_LOG_MIN_LEVEL 1
+#else
+#define TAKEAWAY_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+
+namespace TakeAwayPlatform
+{
+    enum class LogLevel : uint8_t
+    {
+        Debug = 0,
+        Info,
+        Warn,
+        Error,
+        Off
+    };
+
+    const char* log_level_name(LogLevel level);
+
+    // 解析 "debug" / "info" / "warn" / "error" / "off"，无法识别时返回 fallback
+    LogLevel parse_log_level(const std::string& name, LogLevel fallback);
+
+    // 日志参数
+    struct LogOptions
+    {
+        LogLevel level = LogLevel::Info;
+        std::string file;                                   // 为空时输出到 stdout
+        std::chrono::milliseconds flushInterval {20};       // 后台线程的最长等待时间
+    };
+
+    // 异步日志
+    // 每个线程第一次写日志时登记一个单生产者单消费者的无锁环形缓冲区，
+    // 写日志只是格式化后拷贝进自己的缓冲区；后台线程统一取出、写文件并按批刷新。
+    // 缓冲区满时丢弃新日志并计数，不会阻塞业务线程。
+    class Logger
+    {
+    public:
+        static Logger& instance();
+
+        void configure(const LogOptions& options);
+
+        bool enabled(LogLevel level) const
+        {
+            return static_cast<uint8_t>(level) >= minLevel.load(std::memory_order_relaxed);
+        }
+
+        void write(LogLevel level, const std::string& message);
+
+        // 阻塞直到当前已写入的日志全部输出
+        void flush();
+
+        // 停止后台线程；之后的日志直接同步输出
+        void shutdown();
+
+        uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t SLOT_TEXT = 480;
+        static constexpr size_t RING_SLOTS = 1024;     // 必须是 2 的幂
+
+        struct Slot
+        {
+            int64_t timeMicros;
+            LogLevel level;
+            uint16_t length;
+            char text[SLOT_TEXT];
+        };
+
+        struct Ring
+        {
+            explicit Ring(uint32_t id) : threadId(id) {}
+
+            const uint32_t threadId;
+            alignas(64) std::atomic<uint64_t> head {0};     // 生产者写
+            alignas(64) std::atomic<uint64_t> tail {0};     // 消费者写
+            std::atomic<bool> retired {false};              // 线程已退出，取空后移除
+            Slot slots[RING_SLOTS];
+        };
+
+        // 线程退出时标记缓冲区退役
+        struct RingHandle
+        {
+            std::shared_ptr<Ring> ring;
+            ~RingHandle();
+        };
+
+        Logger();
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        Ring* local_ring();
+
+        void writer_loop();
+
+        // 取出全部缓冲区中的日志并输出，返回输出条数
+        size_t drain();
+
+        void format_line(uint32_t threadId, const Slot& slot, std::string& out) const;
+
+        void write_sync(LogLevel level, const std::string& message);
+
+    private:
+        std::atomic<uint8_t> minLevel {static_cast<uint8_t>(LogLevel::Info)};
+        std::atomic<uint64_t> droppedCount {0};
+        std::atomic<uint64_t> writtenCount {0};
+        std::atomic<uint64_t> drainedCount {0};
+
+        std::mutex ringsMtx;            // 只在登记缓冲区和后台取日志时使用
+        std::vector<std::shared_ptr<Ring>> rings;
+        uint32_t nextThreadId = 1;
+
+        std::mutex outputMtx;
+        FILE* output = stdout;
+        bool ownsOutput = false;
+        std::chrono::milliseconds flushInterval {20};
+
+        std::mutex wakeMtx;
+        std::condition_variable wakeCv;
+        std::condition_variable drainedCv;
+        std::atomic<bool> running {false};
+        std::thread writer;
+        std::string lineBuffer;         // 仅后台线程使用
+        uint64_t reportedDrops = 0;     // 仅后台线程使用
+    };
+
+    // 单条日志的格式化缓冲，按线程复用
+    class LogLine
+    {
+    public:
+        explicit LogLine(LogLevel level) : level(level)
+        {
+            std::ostringstream& out = stream();
+            out.str(std::string());
+            out.clear();
+        }
+
+        ~LogLine()
+        {
+            Logger::instance().write(level, stream().str());
+        }
+
+        static std::ostringstream& stream()
+        {
+            thread_local std::ostringstream out;
+            return out;
+        }
+
+    private:
+        LogLevel level;
+    };
+
+    // 按调用点限速：每秒最多放行 limit 条，其余计数，下次放行时附带被抑制的条数
+    class LogRateLimiter
+    {
+    public:
+        // 放行时返回 true，suppressed 为上一个窗口内被抑制的条数
+        bool allow(uint32_t limit, uint64_t& suppressed);
+
+    private:
+        std::atomic<int64_t> windowStart {0};
+        std::atomic<uint32_t> count {0};
+        std::atomic<uint64_t> suppressedCount {0};
+    };
+}
+
+
+#define TAKEAWAY_LOG(level, expr)                                                   \
+    do {                                                                            \
+        if (::TakeAwayPlatform::Logger::instance().enabled(level)) {                \
+            ::TakeAwayPlatform::LogLine takeawayLogLine(level);                     \
+            ::TakeAwayPlatform::LogLine::stream() << expr;                          \
+        }                                                                           \
+    } while (0)
+
+#define TAKEAWAY_LOG_RATE(level, limit, expr)                                       \
+    do {                                                                            \
+        if (::TakeAwayPlatform::Logger::instance().enabled(level)) {                \
+            static ::TakeAwayPlatform::LogRateLimiter takeawayLimiter;             \
+            uint64_t takeawaySuppressed = 0;                                        \
+            if (takeawayLimiter.allow(limit, takeawaySuppressed)) {                 \
+                ::TakeAwayPlatform::LogLine takeawayLogLine(level);                 \
+                ::TakeAwayPlatform::LogLine::stream() << expr;                      \
+                if (takeawaySuppressed > 0) {                                       \
+                    ::TakeAwayPlatform::LogLine::stream()                           \
+                        << " (suppressed " << takeawaySuppressed << ")";            \
+                }                                                                   \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+// 被编译期级别排除的日志：保留类型检查，优化后不生成代码
+#define TAKEAWAY_LOG_DISABLED(expr)                                                 \
+    do {                                                                            \
+        if (false) {                                                                \
+            ::TakeAwayPlatform::LogLine::stream() << expr;                          \
+        }                                                                           \
+    } while (0)
+
+#if TAKEAWAY_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(expr) TAKEAWAY_LOG(::TakeAwayPlatform::LogLevel::Debug, expr)
+#else
+#define LOG_DEBUG(expr) TAKEAWAY_LOG_DISABLED(expr)
+#endif
+
+#if TAKEAWAY_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(expr) TAKEAWAY_LOG(::TakeAwayPlatform::LogLevel::Info, expr)
+#define LOG_INFO_RATE(limit, expr) TAKEAWAY_LOG_RATE(::TakeAwayPlatform::LogLevel::Info, limit, expr)
+#else
+#define LOG_INFO(expr) TAKEAWAY_LOG_DISABLED(expr)
+#define LOG_INFO_RATE(limit, expr) TAKEAWAY_LOG_DISABLED(expr)
+#endif
+
+#if TAKEAWAY_LOG_MIN_LEVEL <= 2
+#define LOG_WARN(expr) TAKEAWAY_LOG(::TakeAwayPlatform::LogLevel::Warn, expr)
+#define LOG_WARN_RATE(limit, expr) TAKEAWAY_LOG_RATE(::TakeAwayPlatform::LogLevel::Warn, limit, expr)
+#else
+#define LOG_WARN(expr) TAKEAWAY_LOG_DISABLED(expr)
+#define LOG_WARN_RATE(limit, expr) TAKEAWAY_LOG_DISABLED(expr)
+#endif
+
+#define LOG_ERROR(expr) TAKEAWAY_LOG(::TakeAwayPlatform::LogLevel::Error, expr)
+#define LOG_ERROR_RATE(limit, expr) TAKEAWAY_LOG_RATE(::TakeAwayPlatform::LogLevel::Error, limit, expr)
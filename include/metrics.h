@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace TakeAwayPlatform
+{
+    // 指标分片数：每个线程固定写入其中一片，采集时再汇总
+    constexpr size_t METRIC_SHARDS = 8;
+
+    // 当前线程使用的分片下标
+    size_t metric_shard();
+
+    using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+    // 分片计数器：热路径上只有一次 relaxed 原子加法，且各线程写不同的缓存行
+    class Counter
+    {
+    public:
+        void add(uint64_t value = 1)
+        {
+            shards[metric_shard()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        uint64_t value() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> value {0};
+        };
+
+        std::array<Shard, METRIC_SHARDS> shards;
+    };
+
+    // 对数-线性分桶的延迟直方图（HDR 风格），单位微秒
+    // 每个 2 的幂区间再等分 8 个子桶，相对误差不超过 12.5%
+    class Histogram
+    {
+    public:
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr unsigned SUB_COUNT = 1u << SUB_BITS;
+        static constexpr unsigned MAX_BITS = 40;                    // 约 12 天
+        static constexpr size_t BUCKET_COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+        void record(uint64_t micros);
+
+        void record(std::chrono::steady_clock::duration elapsed)
+        {
+            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            record(static_cast<uint64_t>(micros > 0 ? micros : 0));
+        }
+
+        // 汇总后的快照
+        struct Snapshot
+        {
+            std::array<uint64_t, BUCKET_COUNT> buckets {};
+            uint64_t count = 0;
+            uint64_t sumMicros = 0;
+
+            // q 取 0~1，返回对应分位的桶上界（微秒）
+            uint64_t quantile(double q) const;
+
+            // 不超过 micros 的样本数
+            uint64_t count_at_most(uint64_t micros) const;
+        };
+
+        Snapshot snapshot() const;
+
+        static size_t bucket_index(uint64_t micros);
+
+        static uint64_t bucket_upper(size_t index);
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets {};
+            std::atomic<uint64_t> count {0};
+            std::atomic<uint64_t> sumMicros {0};
+        };
+
+        std::array<Shard, METRIC_SHARDS> shards;
+    };
+
+    // 采集回调使用的输出器，按 Prometheus 文本格式写入
+    class MetricsWriter
+    {
+    public:
+        explicit MetricsWriter(std::string& out) : out(out) {}
+
+        void counter(const std::string& name, const std::string& help, double value, const MetricLabels& labels = {});
+
+        void gauge(const std::string& name, const std::string& help, double value, const MetricLabels& labels = {});
+
+        void histogram(const std::string& name, const std::string& help,
+                       const Histogram::Snapshot& snapshot, const MetricLabels& labels = {});
+
+    private:
+        void header(const std::string& name, const std::string& help, const char* type);
+
+        void sample(const std::string& name, const MetricLabels& labels, double value,
+                    const char* extraKey = nullptr, const std::string& extraValue = std::string());
+
+    private:
+        std::string& out;
+        std::set<std::string> described;
+    };
+
+    // 进程内指标注册表
+    // 指标对象在注册时创建，之后地址不变，调用方保存引用直接更新；
+    // 只有注册与采集需要加锁，更新路径上没有锁
+    class MetricsRegistry
+    {
+    public:
+        using Collector = std::function<void(MetricsWriter&)>;
+
+        static MetricsRegistry& instance();
+
+        Counter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+        Histogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+        // 采集时调用的回调，用于输出连接池、队列深度等现算的指标
+        size_t add_collector(Collector collector);
+
+        void remove_collector(size_t id);
+
+        // Prometheus 文本格式
+        std::string render();
+
+    private:
+        MetricsRegistry() = default;
+
+        template<typename T>
+        struct Family
+        {
+            std::string help;
+            std::vector<std::pair<MetricLabels, std::unique_ptr<T>>> series;
+        };
+
+        template<typename T>
+        T& find_or_create(std::map<std::string, Family<T>>& families, const std::string& name,
+                          const std::string& help, const MetricLabels& labels);
+
+    private:
+        std::mutex mtx;
+        std::map<std::string, Family<Counter>> counters;
+        std::map<std::string, Family<Histogram>> histograms;
+        std::map<size_t, Collector> collectors;
+        size_t nextCollectorId = 1;
+    };
+
+    // 计时作用域：析构时把耗时记入直方图
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram)
+            : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopedTimer()
+        {
+            histogram.record(std::chrono::steady_clock::now() - start);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& histogram;
+        std::chrono::steady_clock::time_point start;
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+
+namespace TakeAwayPlatform
+{
+    struct RequestArenaStats
+    {
+        uint64_t requests = 0;          // 在 arena 作用域内处理的请求
+        uint64_t overflows = 0;         // 线程缓冲不够用、向堆申请过内存的请求
+        uint64_t overflowBytes = 0;     // 这些请求向堆申请的字节数
+        size_t reservedBytes = 0;       // 全部工作线程缓冲的总大小
+    };
+
+    // 请求内临时对象的内存（monotonic arena）
+    // 每个工作线程持有一块可复用的缓冲，dispatch 在进入处理函数前打开 Scope，
+    // 绑定参数、列名表等临时容器从这里分配，请求结束时整体丢弃，不逐个释放，也不经过全局堆的锁。
+    // 缓冲用完后向堆申请，请求结束后把线程缓冲扩大到本次的用量（不超过上限），之后同样大小的请求不再访问堆。
+    // 只能用于处理函数返回前销毁的对象：分块输出的 content provider 在 Scope 结束后才执行，
+    // 交给其他线程的对象（写后队列、缓存、事件）也不能从这里分配。
+    class RequestArena
+    {
+    public:
+        // 当前线程的 arena；不在 Scope 内时返回默认的堆分配器
+        static std::pmr::memory_resource* resource();
+
+        // 线程缓冲的初始大小与上限，已经分配的缓冲在下一个请求时按新值调整
+        static void configure(size_t initialBytes, size_t maxBytes);
+
+        static RequestArenaStats stats();
+
+        // 作用域内的分配进入当前线程的 arena，退出时全部释放；嵌套的 Scope 不起作用
+        class Scope
+        {
+        public:
+            Scope();
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            bool active = false;
+        };
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+
+
+namespace TakeAwayPlatform
+{
+    // 当前线程正在处理的请求的截止时间
+    // dispatch 在进入处理函数前设置，连接池等待等阻塞操作不会越过它；
+    // 后台线程没有设置，取值为 time_point::max()
+    class RequestDeadline
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static Clock::time_point current() { return slot(); }
+
+        static bool expired() { return Clock::now() >= slot(); }
+
+        // 作用域内设置截止时间，退出时恢复
+        class Scope
+        {
+        public:
+            explicit Scope(Clock::time_point deadline) : previous(slot()) { slot() = deadline; }
+            ~Scope() { slot() = previous; }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Clock::time_point previous;
+        };
+
+    private:
+        static Clock::time_point& slot()
+        {
+            thread_local Clock::time_point deadline = Clock::time_point::max();
+            return deadline;
+        }
+    };
+}
@@ -1,45 +1,215 @@
 #pragma once
 
-#include <queue>
-#include <mutex>
-#include <condition_variable>
-#include <functional>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 namespace TakeAwayPlatform
 {
 
-    class TaskQueue 
+    // 只可移动的任务对象，小闭包直接存放在内部缓冲区，避免 std::function 的堆分配
+    class Task
     {
     public:
-        using Task = std::function<void()>;
+        static constexpr size_t INLINE_SIZE = 64;
 
-        void push(Task task) {
+        Task() noexcept = default;
+
+        template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+        Task(F&& fn)
+        {
+            using Fn = std::decay_t<F>;
+            if constexpr (sizeof(Fn) <= INLINE_SIZE
+                          && alignof(Fn) <= alignof(std::max_align_t)
+                          && std::is_nothrow_move_constructible<Fn>::value)
+            {
+                new (&storage) Fn(std::forward<F>(fn));
+                ops = &inline_ops<Fn>;
+            }
+            else
             {
-                std::lock_guard<std::mutex> lock(mtx);
-                tasks.push(std::move(task));
+                new (&storage) Fn*(new Fn(std::forward<F>(fn)));
+                ops = &heap_ops<Fn>;
+            }
+        }
+
+        Task(Task&& other) noexcept
+        {
+            move_from(other);
+        }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                move_from(other);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task()
+        {
+            reset();
+        }
+
+        explicit operator bool() const noexcept { return ops != nullptr; }
+
+        void operator()()
+        {
+            ops->invoke(&storage);
+        }
+
+        void reset() noexcept
+        {
+            if (ops) {
+                ops->destroy(&storage);
+                ops = nullptr;
             }
-            condition.notify_one();
         }
 
-        Task pop() {
-            std::unique_lock<std::mutex> lock(mtx);
-            condition.wait(lock, [this] { return !tasks.empty(); });
-            
-            Task task = std::move(tasks.front());
-            tasks.pop();
-            return task;
+    private:
+        struct Ops
+        {
+            void (*invoke)(void*);
+            void (*move)(void* from, void* to) noexcept;
+            void (*destroy)(void*) noexcept;
+        };
+
+        template<typename Fn>
+        static constexpr Ops inline_ops = {
+            [](void* p) { (*static_cast<Fn*>(p))(); },
+            [](void* from, void* to) noexcept {
+                new (to) Fn(std::move(*static_cast<Fn*>(from)));
+                static_cast<Fn*>(from)->~Fn();
+            },
+            [](void* p) noexcept { static_cast<Fn*>(p)->~Fn(); }
+        };
+
+        template<typename Fn>
+        static constexpr Ops heap_ops = {
+            [](void* p) { (**static_cast<Fn**>(p))(); },
+            [](void* from, void* to) noexcept {
+                new (to) Fn*(*static_cast<Fn**>(from));
+            },
+            [](void* p) noexcept { delete *static_cast<Fn**>(p); }
+        };
+
+        void move_from(Task& other) noexcept
+        {
+            ops = other.ops;
+            if (ops) {
+                ops->move(&other.storage, &storage);
+                other.ops = nullptr;
+            }
+        }
+
+    private:
+        std::aligned_storage_t<INLINE_SIZE, alignof(std::max_align_t)> storage;
+        const Ops* ops = nullptr;
+    };
+
+
+    // 有界无锁多生产者多消费者队列（Vyukov 环形队列）
+    // 作为线程池的全局注入队列，容量向上取整为 2 的幂
+    class TaskQueue
+    {
+    public:
+        explicit TaskQueue(size_t capacity = 4096)
+        {
+            size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+
+            mask = size - 1;
+            cells = std::make_unique<Cell[]>(size);
+            for (size_t index = 0; index < size; ++index) {
+                cells[index].sequence.store(index, std::memory_order_relaxed);
+            }
+        }
+
+        TaskQueue(const TaskQueue&) = delete;
+        TaskQueue& operator=(const TaskQueue&) = delete;
+
+        // 队列已满时返回 false，task 保持不变
+        bool try_push(Task& task)
+        {
+            Cell* cell;
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell = &cells[pos & mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->task = std::move(task);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 队列为空时返回 false
+        bool try_pop(Task& task)
+        {
+            Cell* cell;
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell = &cells[pos & mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            task = std::move(cell->task);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+            return true;
         }
 
         bool empty() const {
-            std::lock_guard<std::mutex> lock(mtx);
-            return tasks.empty();
+            return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
         }
 
+        size_t capacity() const { return mask + 1; }
+
     private:
-        std::queue<Task> tasks;
-        mutable std::mutex mtx;
-        std::condition_variable condition;
+        struct Cell
+        {
+            std::atomic<size_t> sequence {0};
+            Task task;
+        };
+
+        static constexpr size_t CACHE_LINE = 64;
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask = 0;
+        alignas(CACHE_LINE) std::atomic<size_t> enqueuePos {0};
+        alignas(CACHE_LINE) std::atomic<size_t> dequeuePos {0};
     };
 
-} 
\ No newline at end of file
+}
@@ -1,54 +1,194 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
 #include "task_queue.h"
 
 
 namespace TakeAwayPlatform
 {
 
-    class ThreadPool 
+    // 工作窃取线程池
+    // 外部线程提交的任务进入无锁注入队列；工作线程内部提交的任务进入自己的本地双端队列。
+    // 工作线程优先从本地队列尾部取任务（LIFO，缓存友好），其次取注入队列，
+    // 最后从其他线程的本地队列头部窃取。没有任务时休眠，析构时执行完剩余任务再退出。
+    class ThreadPool
     {
     public:
-        explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency()) 
-            : running(true) {
+        explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency(),
+                            size_t queue_capacity = 4096)
+            : injectQueue(queue_capacity) {
+            if (thread_count == 0) {
+                thread_count = 1;
+            }
+
+            localQueues.reserve(thread_count);
+            for (size_t index = 0; index < thread_count; ++index) {
+                localQueues.push_back(std::make_unique<LocalQueue>());
+            }
+
             workers.reserve(thread_count);
             for (size_t index = 0; index < thread_count; ++index) {
-                workers.emplace_back([this] { worker_thread(); });
+                workers.emplace_back([this, index] { worker_thread(index); });
             }
         }
 
         ~ThreadPool() {
-            running = false;
-            condition.notify_all();
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                running.store(false, std::memory_order_seq_cst);
+            }
+            sleepCv.notify_all();
             for (auto& worker : workers) {
                 if (worker.joinable()) worker.join();
             }
         }
 
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
         template<typename F>
-        void enqueue(F&& task) {
-            taskQueue.push(std::forward<F>(task));
-            condition.notify_one();
+        void enqueue(F&& fn) {
+            Task task(std::forward<F>(fn));
+
+            // 先计数再入队，保证取走任务时计数不会下溢
+            pending.fetch_add(1, std::memory_order_seq_cst);
+
+            if (currentPool() == this) {
+                // 工作线程内部提交：放入本地队列，其他线程可以窃取
+                LocalQueue& local = *localQueues[currentIndex()];
+                std::lock_guard<SpinLock> lock(local.lock);
+                local.tasks.push_back(std::move(task));
+            } else {
+                // 注入队列满时让出时间片，形成背压
+                while (!injectQueue.try_push(task)) {
+                    std::this_thread::yield();
+                }
+            }
+
+            wake_one();
         }
 
+        size_t size() const { return workers.size(); }
+
+        // 已提交尚未开始执行的任务数
+        size_t queued() const { return pending.load(std::memory_order_relaxed); }
+
     private:
-        void worker_thread() {
-            while (running) {
-                auto task = taskQueue.pop();
-                if (task) task();
+        class SpinLock
+        {
+        public:
+            void lock() {
+                while (flag.test_and_set(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            }
+            void unlock() { flag.clear(std::memory_order_release); }
+
+        private:
+            std::atomic_flag flag = ATOMIC_FLAG_INIT;
+        };
+
+        struct alignas(64) LocalQueue
+        {
+            SpinLock lock;
+            std::deque<Task> tasks;
+        };
+
+        static ThreadPool*& currentPool() {
+            thread_local ThreadPool* pool = nullptr;
+            return pool;
+        }
+
+        static size_t& currentIndex() {
+            thread_local size_t index = 0;
+            return index;
+        }
+
+        void wake_one() {
+            if (sleepers.load(std::memory_order_seq_cst) > 0) {
+                // 持锁再通知，避免与即将进入等待的线程错过唤醒
+                { std::lock_guard<std::mutex> lock(sleepMtx); }
+                sleepCv.notify_one();
+            }
+        }
+
+        bool pop_local(size_t index, Task& task) {
+            LocalQueue& local = *localQueues[index];
+            std::lock_guard<SpinLock> lock(local.lock);
+            if (local.tasks.empty()) return false;
+            task = std::move(local.tasks.back());
+            local.tasks.pop_back();
+            return true;
+        }
+
+        bool steal(size_t self, Task& task) {
+            const size_t count = localQueues.size();
+            for (size_t offset = 1; offset < count; ++offset) {
+                LocalQueue& victim = *localQueues[(self + offset) % count];
+                std::lock_guard<SpinLock> lock(victim.lock);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool find_task(size_t index, Task& task) {
+            if (pop_local(index, task) || injectQueue.try_pop(task) || steal(index, task)) {
+                pending.fetch_sub(1, std::memory_order_seq_cst);
+                return true;
             }
+            return false;
+        }
+
+        void worker_thread(size_t index) {
+            currentPool() = this;
+            currentIndex() = index;
+
+            Task task;
+            while (true) {
+                if (find_task(index, task)) {
+                    task();
+                    task.reset();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(sleepMtx);
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                sleepCv.wait(lock, [this] {
+                    return pending.load(std::memory_order_seq_cst) > 0
+                        || !running.load(std::memory_order_seq_cst);
+                });
+                sleepers.fetch_sub(1, std::memory_order_seq_cst);
+
+                // 停止时先把剩余任务执行完
+                if (!running.load(std::memory_order_seq_cst)
+                    && pending.load(std::memory_order_seq_cst) == 0) {
+                    break;
+                }
+            }
+
+            currentPool() = nullptr;
         }
 
 private:
         std::vector<std::thread> workers;
-        TaskQueue taskQueue;
-        std::atomic<bool> running;
-        std::condition_variable condition;
-        std::mutex mtx;
+        std::vector<std::unique_ptr<LocalQueue>> localQueues;
+        TaskQueue injectQueue;
+
+        std::atomic<bool> running {true};
+        std::atomic<size_t> pending {0};
+        std::atomic<size_t> sleepers {0};
+        std::mutex sleepMtx;
+        std::condition_variable sleepCv;
     };
 
 }
-
@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "catalog_cache.h"
+
+
+namespace TakeAwayPlatform
+{
+    CatalogOptions load_catalog_options(const Json::Value& config)
+    {
+        CatalogOptions options;
+        options.enabled = config.get("catalog_enabled", true).asBool();
+        options.ttl = std::chrono::seconds(config.get("catalog_ttl_s", 60).asInt());
+        options.maxMerchants = std::max(1u, config.get("catalog_max_merchants", 10000).asUInt());
+        return options;
+    }
+
+    CatalogCache::CatalogCache(LeaseProvider provider, const CatalogOptions& cacheOptions)
+        : leaseProvider(std::move(provider)), options(cacheOptions),
+          merchants(options.maxMerchants, [this](const MerchantCatalog& catalog) { return !is_fresh(catalog.loadedAt); })
+    {
+    }
+
+    std::shared_ptr<const MerchantCatalog> CatalogCache::merchant(const std::string& merchantId)
+    {
+        if (!options.enabled) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return load_merchant(merchantId);
+        }
+
+        std::shared_ptr<const MerchantCatalog> current = merchants.find(merchantId);
+        if (current) {
+            if (is_fresh(current->loadedAt)) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return current;
+            }
+            expired.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return load_merchant(merchantId);
+    }
+
+    void CatalogCache::invalidate(const std::string& merchantId)
+    {
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+
+        merchants.erase(merchantId);
+    }
+
+    void CatalogCache::clear()
+    {
+        merchants.clear();
+    }
+
+    CatalogStats CatalogCache::stats() const
+    {
+        CatalogStats snapshot;
+        snapshot.hits = hits.load(std::memory_order_relaxed);
+        snapshot.misses = misses.load(std::memory_order_relaxed);
+        snapshot.expired = expired.load(std::memory_order_relaxed);
+        snapshot.invalidations = invalidations.load(std::memory_order_relaxed);
+        snapshot.evictions = merchants.evictions();
+        snapshot.entries = merchants.size();
+        return snapshot;
+    }
+
+    bool CatalogCache::is_fresh(std::chrono::steady_clock::time_point loadedAt) const
+    {
+        return std::chrono::steady_clock::now() - loadedAt < options.ttl;
+    }
+
+    std::shared_ptr<const MerchantCatalog> CatalogCache::load_merchant(const std::string& merchantId)
+    {
+        // 先记下代数再查库：查询期间若发生失效，结果只返回给本次请求，不写入缓存
+        const uint64_t generation = merchants.generation(merchantId);
+
+        auto catalog = std::make_shared<MerchantCatalog>();
+        catalog->merchantId = merchantId;
+        catalog->loadedAt = std::chrono::steady_clock::now();
+        {
+            DBLease db = leaseProvider(merchantId);
+            catalog->dishes = db->execute(StmtId::MerchantDishes, merchantId);
+            catalog->categories = db->execute(StmtId::CategoriesByMerchant, merchantId);
+        }
+
+        std::shared_ptr<const MerchantCatalog> published = std::move(catalog);
+
+        // 不存在的商家与还没有上架菜品的商家结果相同，都不缓存
+        if (!options.enabled || (published->dishes.empty() && published->categories.empty())) {
+            return published;
+        }
+
+        merchants.publish(merchantId, published, generation);
+        return published;
+    }
+}
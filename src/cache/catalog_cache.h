@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "common.h"
+#include "db_pool.h"
+#include "snapshot_map.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 菜品目录缓存参数
+    struct CatalogOptions
+    {
+        bool enabled = true;
+        std::chrono::seconds ttl {60};     // 兜底过期时间，正常情况下由写接口主动失效
+        size_t maxMerchants = 10000;       // 缓存的商家数上限，超出时淘汰最早加载的
+    };
+
+    // 从 config.json 的 cache 节读取参数
+    CatalogOptions load_catalog_options(const Json::Value& config);
+
+    // 单个商家的目录快照，发布后只读
+    struct MerchantCatalog
+    {
+        std::string merchantId;
+        Json::Value dishes;         // DISH，按名称排序
+        Json::Value categories;     // DISH_CATEGORY，按 sortOrder 排序
+        std::chrono::steady_clock::time_point loadedAt;
+    };
+
+    struct CatalogStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t expired = 0;
+        uint64_t invalidations = 0;
+        uint64_t evictions = 0;     // 过期或超出上限被清理
+        size_t entries = 0;
+    };
+
+    // 进程内菜品目录缓存（关闭时每次直接查库）
+    // 商家快照存放在 SnapshotMap 中，读路径无锁；查询期间发生失效的加载结果不会被发布。
+    // 键来自客户端传入的 merchantId：没有菜品也没有分类的结果不缓存，不存在的商家不会占用缓存
+    class CatalogCache
+    {
+    public:
+        // 参数为要加载的商家，调用方可据此选择数据库节点
+        using LeaseProvider = std::function<DBLease(const std::string& merchantId)>;
+
+        CatalogCache(LeaseProvider leaseProvider, const CatalogOptions& options);
+
+        CatalogCache(const CatalogCache&) = delete;
+        CatalogCache& operator=(const CatalogCache&) = delete;
+
+        // 未命中或已过期时从数据库加载，加载失败抛出异常
+        std::shared_ptr<const MerchantCatalog> merchant(const std::string& merchantId);
+
+        // 商家的菜品或分类发生变化
+        void invalidate(const std::string& merchantId);
+
+        void clear();
+
+        bool enabled() const { return options.enabled; }
+
+        CatalogStats stats() const;
+
+    private:
+        bool is_fresh(std::chrono::steady_clock::time_point loadedAt) const;
+
+        std::shared_ptr<const MerchantCatalog> load_merchant(const std::string& merchantId);
+
+    private:
+        const LeaseProvider leaseProvider;
+        const CatalogOptions options;
+
+        SnapshotMap<MerchantCatalog> merchants;
+
+        std::atomic<uint64_t> hits {0};
+        std::atomic<uint64_t> misses {0};
+        std::atomic<uint64_t> expired {0};
+        std::atomic<uint64_t> invalidations {0};
+    };
+}
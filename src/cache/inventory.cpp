@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "inventory.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // 一条写回语句最多包含的菜品数
+        constexpr size_t WRITE_BACK_CHUNK = 500;
+    }
+
+    InventoryOptions load_inventory_options(const Json::Value& config)
+    {
+        InventoryOptions options;
+        options.enabled = config.get("enabled", false).asBool();
+        options.writeBackInterval = std::chrono::milliseconds(config.get("write_back_interval_ms", 200).asInt());
+        options.reservationTtl = std::chrono::seconds(config.get("reservation_ttl_s", 900).asInt());
+        return options;
+    }
+
+    Inventory::Inventory(LeaseProvider provider, const InventoryOptions& inventoryOptions)
+        : leaseProvider(std::move(provider)), options(inventoryOptions)
+    {
+        if (options.enabled) {
+            writer = std::thread([this] { write_back_loop(); });
+        }
+    }
+
+    Inventory::~Inventory()
+    {
+        shutdown();
+    }
+
+    bool Inventory::reserve(const std::string& orderId, const Quantities& quantities)
+    {
+        std::vector<std::string> missing;
+        for (const auto& entry : quantities) {
+            if (!find(entry.first)) {
+                missing.push_back(entry.first);
+            }
+        }
+        if (!missing.empty()) {
+            load(missing);
+        }
+
+        Reservation reservation;
+        reservation.expiresAt = std::chrono::steady_clock::now() + options.reservationTtl;
+
+        // 逐个菜品 CAS 扣减，不足时不会把计数减成负数
+        for (const auto& entry : quantities)
+        {
+            Counter* counter = find(entry.first);
+            const int quantity = entry.second;
+            if (!counter || quantity <= 0) {
+                give_back(reservation);
+                rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            int64_t current = counter->available.load(std::memory_order_relaxed);
+            do {
+                if (current < quantity) {
+                    give_back(reservation);
+                    rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (!counter->available.compare_exchange_weak(current, current - quantity,
+                                                               std::memory_order_acq_rel, std::memory_order_relaxed));
+            reservation.items.emplace_back(counter, quantity);
+        }
+
+        ReservationShard& shard = reservation_shard(orderId);
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        if (shard.reservations.count(orderId) > 0) {
+            lock.unlock();
+            give_back(reservation);
+            throw std::invalid_argument("订单已存在: " + orderId);
+        }
+        shard.reservations.emplace(orderId, std::move(reservation));
+        lock.unlock();
+
+        reservedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Inventory::confirm(const std::string& orderId)
+    {
+        Reservation reservation;
+        if (!take(orderId, reservation)) {
+            return false;
+        }
+
+        for (const auto& item : reservation.items) {
+            item.first->unflushed.fetch_add(item.second, std::memory_order_relaxed);
+        }
+        confirmedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Inventory::commit_direct(const Quantities& quantities)
+    {
+        std::vector<std::string> missing;
+        for (const auto& entry : quantities) {
+            if (!find(entry.first)) {
+                missing.push_back(entry.first);
+            }
+        }
+        if (!missing.empty()) {
+            load(missing);
+        }
+
+        // 不检查库存：这些数量已经卖出，可用库存可能因此变为负数
+        for (const auto& entry : quantities) {
+            Counter* counter = find(entry.first);
+            if (counter) {
+                counter->available.fetch_sub(entry.second, std::memory_order_relaxed);
+                counter->unflushed.fetch_add(entry.second, std::memory_order_relaxed);
+            }
+        }
+        confirmedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool Inventory::release(const std::string& orderId)
+    {
+        Reservation reservation;
+        if (!take(orderId, reservation)) {
+            return false;
+        }
+
+        give_back(reservation);
+        releasedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Inventory::flush()
+    {
+        std::lock_guard<std::mutex> flushLock(flushMtx);
+
+        std::vector<std::pair<Counter*, int64_t>> deltas;
+        BoundValues params;
+        for (CounterShard& shard : counters) {
+            std::shared_lock<std::shared_mutex> lock(shard.mtx);
+            for (const auto& entry : shard.counters) {
+                const int64_t delta = entry.second->unflushed.exchange(0, std::memory_order_relaxed);
+                if (delta != 0) {
+                    deltas.emplace_back(entry.second.get(), delta);
+                    params.emplace_back(entry.first);
+                    params.emplace_back(delta);
+                }
+            }
+        }
+        if (deltas.empty()) {
+            return;
+        }
+
+        size_t done = 0;
+        try {
+            DBLease db = leaseProvider();
+            while (done < deltas.size()) {
+                const size_t count = std::min(WRITE_BACK_CHUNK, deltas.size() - done);
+                const BoundValues chunk(params.begin() + done * 2, params.begin() + (done + count) * 2);
+                db->update_sql(dish_stock_commit_sql(count), chunk);
+                writeBacks.fetch_add(1, std::memory_order_relaxed);
+                done += count;
+            }
+        } catch (const std::exception& e) {
+            // 没写成功的部分留到下一轮
+            writeBackFailures.fetch_add(1, std::memory_order_relaxed);
+            for (size_t index = done; index < deltas.size(); ++index) {
+                deltas[index].first->unflushed.fetch_add(deltas[index].second, std::memory_order_relaxed);
+            }
+            LOG_WARN_RATE(1, "Inventory write-back failed for " << (deltas.size() - done) << " dishes: " << e.what());
+        }
+    }
+
+    void Inventory::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(stopMtx);
+            stopping = true;
+        }
+        stopCv.notify_all();
+
+        if (writer.joinable())
+        {
+            writer.join();
+            flush();
+
+            const InventoryStats snapshot = stats();
+            LOG_INFO("Inventory stopped - reserved: " << snapshot.reserved
+                << ", confirmed: " << snapshot.confirmed
+                << ", released: " << snapshot.released
+                << ", expired: " << snapshot.expired
+                << ", open reservations: " << snapshot.reservations);
+        }
+    }
+
+    InventoryStats Inventory::stats() const
+    {
+        InventoryStats snapshot;
+        snapshot.reserved = reservedCount.load(std::memory_order_relaxed);
+        snapshot.rejected = rejectedCount.load(std::memory_order_relaxed);
+        snapshot.confirmed = confirmedCount.load(std::memory_order_relaxed);
+        snapshot.released = releasedCount.load(std::memory_order_relaxed);
+        snapshot.expired = expiredCount.load(std::memory_order_relaxed);
+        snapshot.writeBacks = writeBacks.load(std::memory_order_relaxed);
+        snapshot.writeBackFailures = writeBackFailures.load(std::memory_order_relaxed);
+
+        for (const CounterShard& shard : counters) {
+            std::shared_lock<std::shared_mutex> lock(shard.mtx);
+            snapshot.dishes += shard.counters.size();
+        }
+        for (const ReservationShard& shard : reservations) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            snapshot.reservations += shard.reservations.size();
+        }
+        return snapshot;
+    }
+
+    Inventory::Counter* Inventory::find(const std::string& dishId) const
+    {
+        CounterShard& shard = counter_shard(dishId);
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+        auto found = shard.counters.find(dishId);
+        return found != shard.counters.end() ? found->second.get() : nullptr;
+    }
+
+    void Inventory::load(const std::vector<std::string>& dishIds)
+    {
+        BoundValues params(dishIds.begin(), dishIds.end(), RequestArena::resource());
+
+        Json::Value rows;
+        {
+            DBLease db = leaseProvider();
+            rows = db->execute_sql(dish_stock_by_ids_sql(dishIds.size()), params);
+        }
+
+        for (const auto& row : rows)
+        {
+            const std::string dishId = row["dishId"].asString();
+            CounterShard& shard = counter_shard(dishId);
+            std::unique_lock<std::shared_mutex> lock(shard.mtx);
+            auto& counter = shard.counters[dishId];
+            if (!counter) {
+                // 其他线程可能已经加载过，已有的计数不覆盖
+                counter = std::make_unique<Counter>();
+                counter->available.store(row["stock"].asInt64(), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Inventory::take(const std::string& orderId, Reservation& out)
+    {
+        ReservationShard& shard = reservation_shard(orderId);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.reservations.find(orderId);
+        if (found == shard.reservations.end()) {
+            return false;
+        }
+        out = std::move(found->second);
+        shard.reservations.erase(found);
+        return true;
+    }
+
+    void Inventory::give_back(const Reservation& reservation)
+    {
+        for (const auto& item : reservation.items) {
+            item.first->available.fetch_add(item.second, std::memory_order_relaxed);
+        }
+    }
+
+    void Inventory::write_back_loop()
+    {
+        std::unique_lock<std::mutex> lock(stopMtx);
+        while (!stopping)
+        {
+            stopCv.wait_for(lock, options.writeBackInterval, [this] { return stopping; });
+            if (stopping) {
+                break;
+            }
+
+            lock.unlock();
+            flush();
+            expire_reservations();
+            lock.lock();
+        }
+    }
+
+    void Inventory::expire_reservations()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        for (ReservationShard& shard : reservations)
+        {
+            std::vector<Reservation> expired;
+            {
+                std::lock_guard<std::mutex> lock(shard.mtx);
+                for (auto it = shard.reservations.begin(); it != shard.reservations.end();) {
+                    if (it->second.expiresAt <= now) {
+                        expired.push_back(std::move(it->second));
+                        it = shard.reservations.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            for (const Reservation& reservation : expired) {
+                give_back(reservation);
+            }
+            expiredCount.fetch_add(expired.size(), std::memory_order_relaxed);
+        }
+    }
+
+    Inventory::CounterShard& Inventory::counter_shard(const std::string& dishId) const
+    {
+        return counters[std::hash<std::string>()(dishId) % SHARD_COUNT];
+    }
+
+    Inventory::ReservationShard& Inventory::reservation_shard(const std::string& orderId)
+    {
+        return reservations[std::hash<std::string>()(orderId) % SHARD_COUNT];
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "db_pool.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 内存库存参数
+    struct InventoryOptions
+    {
+        bool enabled = false;
+        std::chrono::milliseconds writeBackInterval {200};  // 售出量写回 DISH 的间隔
+        std::chrono::seconds reservationTtl {900};          // 下单后未支付的预留保留时长
+    };
+
+    // 从 config.json 的 inventory 节读取参数
+    InventoryOptions load_inventory_options(const Json::Value& config);
+
+    struct InventoryStats
+    {
+        uint64_t reserved = 0;          // 成功预留的订单
+        uint64_t rejected = 0;          // 库存不足或菜品不存在
+        uint64_t confirmed = 0;
+        uint64_t released = 0;
+        uint64_t expired = 0;           // 超时未支付而自动归还
+        uint64_t writeBacks = 0;        // 写回 DISH 的语句数
+        uint64_t writeBackFailures = 0;
+        size_t dishes = 0;              // 已加载的菜品
+        size_t reservations = 0;        // 尚未确认或归还的预留
+    };
+
+    // 热点菜品库存：每个菜品一个原子计数，下单时预留、支付成功时确认、取消或超时归还，
+    // 售出量由后台线程按 writeBackInterval 合并成一条 UPDATE 写回 DISH.stock / sales，
+    // 下单路径上不再对 DISH 行加锁。菜品在第一次预留时从数据库加载。
+    // 计数只在本进程内有效：同一批菜品只能由一个服务实例负责下单，否则会超卖。
+    class Inventory
+    {
+    public:
+        using LeaseProvider = std::function<DBLease()>;
+        using Quantities = std::map<std::string, int>;      // dishId -> 数量
+
+        Inventory(LeaseProvider leaseProvider, const InventoryOptions& options);
+        ~Inventory();
+
+        Inventory(const Inventory&) = delete;
+        Inventory& operator=(const Inventory&) = delete;
+
+        bool enabled() const { return options.enabled; }
+
+        // 为订单预留库存；任一菜品不足或不存在时撤销已预留的部分并返回 false
+        // 加载菜品失败时抛出异常
+        bool reserve(const std::string& orderId, const Quantities& quantities);
+
+        // 支付成功：预留转为售出，等待写回；没有该订单的预留时返回 false
+        bool confirm(const std::string& orderId);
+
+        // 已经售出但没有预留记录（例如预留已超时或进程重启过），直接计入售出
+        void commit_direct(const Quantities& quantities);
+
+        // 订单取消或支付失败：归还预留，没有该订单的预留时返回 false
+        bool release(const std::string& orderId);
+
+        // 立即写回累计的售出量
+        void flush();
+
+        // 停止后台线程并写回剩余售出量
+        void shutdown();
+
+        InventoryStats stats() const;
+
+    private:
+        struct Counter
+        {
+            std::atomic<int64_t> available {0};     // 数据库库存减去未写回的售出与未确认的预留
+            std::atomic<int64_t> unflushed {0};     // 已售出、尚未写回的数量
+        };
+
+        struct CounterShard
+        {
+            mutable std::shared_mutex mtx;
+            std::unordered_map<std::string, std::unique_ptr<Counter>> counters;    // 指针稳定，加载后不删除
+        };
+
+        struct Reservation
+        {
+            std::vector<std::pair<Counter*, int>> items;
+            std::chrono::steady_clock::time_point expiresAt;
+        };
+
+        struct ReservationShard
+        {
+            mutable std::mutex mtx;
+            std::unordered_map<std::string, Reservation> reservations;
+        };
+
+        static constexpr size_t SHARD_COUNT = 16;
+
+        Counter* find(const std::string& dishId) const;
+
+        // 从数据库加载尚未加载的菜品，不存在的菜品不会出现在结果中
+        void load(const std::vector<std::string>& dishIds);
+
+        bool take(const std::string& orderId, Reservation& out);
+
+        void give_back(const Reservation& reservation);
+
+        void write_back_loop();
+
+        void expire_reservations();
+
+        CounterShard& counter_shard(const std::string& dishId) const;
+
+        ReservationShard& reservation_shard(const std::string& orderId);
+
+    private:
+        const LeaseProvider leaseProvider;
+        const InventoryOptions options;
+
+        mutable std::array<CounterShard, SHARD_COUNT> counters;
+        std::array<ReservationShard, SHARD_COUNT> reservations;
+
+        std::mutex flushMtx;            // 同一时间只有一个线程写回
+
+        std::mutex stopMtx;
+        std::condition_variable stopCv;
+        bool stopping = false;
+        std::thread writer;
+
+        std::atomic<uint64_t> reservedCount {0};
+        std::atomic<uint64_t> rejectedCount {0};
+        std::atomic<uint64_t> confirmedCount {0};
+        std::atomic<uint64_t> releasedCount {0};
+        std::atomic<uint64_t> expiredCount {0};
+        std::atomic<uint64_t> writeBacks {0};
+        std::atomic<uint64_t> writeBackFailures {0};
+    };
+}
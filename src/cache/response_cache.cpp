@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstdio>
+#include <zlib.h>
+
+#include "response_cache.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // FNV-1a 64 位，用于生成 ETag
+        uint64_t fnv1a(const std::string& data)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char byte : data) {
+                hash ^= byte;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        std::string make_etag(const std::string& body)
+        {
+            char buffer[24];
+            std::snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(fnv1a(body)));
+            return buffer;
+        }
+    }
+
+    ResponseCacheOptions load_response_cache_options(const Json::Value& config)
+    {
+        ResponseCacheOptions options;
+        options.enabled = config.get("response_enabled", true).asBool();
+        options.ttl = std::chrono::seconds(config.get("response_ttl_s", 30).asInt());
+        options.gzip = config.get("response_gzip", true).asBool();
+        options.gzipMinBytes = config.get("response_gzip_min_bytes", 1024).asUInt();
+        options.singleFlight = config.get("response_single_flight", true).asBool();
+        options.maxBytes = static_cast<size_t>(std::max(1u, config.get("response_max_mb", 64).asUInt())) * 1024 * 1024;
+        return options;
+    }
+
+    ResponseCache::ResponseCache(const ResponseCacheOptions& cacheOptions)
+        : options(cacheOptions),
+          entries(options.maxBytes, [this](const CachedResponse& response) {
+              return std::chrono::steady_clock::now() - response.createdAt >= options.ttl;
+          })
+    {
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::get(const std::string& key, const Builder& builder,
+                                                             const Storable& storable)
+    {
+        return lookup(key, [&builder, &storable](bool& store) {
+            const Json::Value value = builder();
+            store = !storable || storable(value);
+            return to_json(value);
+        });
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::get_body(const std::string& key, const BodyBuilder& builder)
+    {
+        return lookup(key, [&builder](bool&) { return builder(); });
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::lookup(const std::string& key, const StoringBuilder& builder)
+    {
+        if (options.enabled) {
+            std::shared_ptr<const CachedResponse> current = entries.find(key);
+            if (current && std::chrono::steady_clock::now() - current->createdAt < options.ttl) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return current;
+            }
+        }
+
+        misses.fetch_add(1, std::memory_order_relaxed);
+
+        const uint64_t generation = entries.generation(key);
+        auto build = [&] {
+            bool store = true;
+            std::shared_ptr<const CachedResponse> created = make_response(builder(store));
+            if (!store) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+            } else if (options.enabled) {
+                entries.publish(key, created, generation, response_bytes(key, *created));
+            }
+            return created;
+        };
+        if (!options.singleFlight) {
+            return build();
+        }
+
+        // 代数也作为合并键的一部分：失效之后到达的请求不会加入失效之前开始的加载
+        return flights.run(key + '\n' + std::to_string(generation), build);
+    }
+
+    void ResponseCache::invalidate(const std::string& key)
+    {
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+        entries.erase(key);
+    }
+
+    void ResponseCache::clear()
+    {
+        entries.clear();
+    }
+
+    ResponseCacheStats ResponseCache::stats() const
+    {
+        ResponseCacheStats snapshot;
+        snapshot.hits = hits.load(std::memory_order_relaxed);
+        snapshot.misses = misses.load(std::memory_order_relaxed);
+        snapshot.invalidations = invalidations.load(std::memory_order_relaxed);
+        snapshot.coalesced = flights.stats().coalesced;
+        snapshot.evictions = entries.evictions();
+        snapshot.skipped = skipped.load(std::memory_order_relaxed);
+        snapshot.entries = entries.size();
+        snapshot.bytes = entries.cost();
+        return snapshot;
+    }
+
+    size_t ResponseCache::response_bytes(const std::string& key, const CachedResponse& response)
+    {
+        return key.size() + response.body.size() + response.gzipBody.size() + response.etag.size() + sizeof(CachedResponse);
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::make_response(std::string body) const
+    {
+        auto response = std::make_shared<CachedResponse>();
+        response->body = std::move(body);
+        response->etag = make_etag(response->body);
+        response->createdAt = std::chrono::steady_clock::now();
+        if (options.gzip && response->body.size() >= options.gzipMinBytes) {
+            response->gzipBody = gzip_compress(response->body);
+        }
+        return response;
+    }
+
+    std::string gzip_compress(const std::string& data)
+    {
+        z_stream stream {};
+        // windowBits 加 16 输出 gzip 格式
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return std::string();
+        }
+
+        std::string compressed;
+        compressed.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+        stream.avail_out = static_cast<uInt>(compressed.size());
+
+        const int status = deflate(&stream, Z_FINISH);
+        const size_t written = stream.total_out;
+        deflateEnd(&stream);
+
+        if (status != Z_STREAM_END) {
+            return std::string();
+        }
+        compressed.resize(written);
+        return compressed;
+    }
+}
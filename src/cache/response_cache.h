@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "common.h"
+#include "single_flight.h"
+#include "snapshot_map.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 响应缓存参数
+    struct ResponseCacheOptions
+    {
+        bool enabled = true;
+        std::chrono::seconds ttl {30};
+        bool gzip = true;               // 是否额外保存 gzip 压缩后的副本
+        size_t gzipMinBytes = 1024;     // 小于该长度的响应不压缩
+        bool singleFlight = true;       // 同一个键的并发未命中只生成一次
+        size_t maxBytes = 64 * 1024 * 1024;     // 缓存的响应（含压缩副本）总字节数上限
+    };
+
+    // 从 config.json 的 cache 节读取参数
+    ResponseCacheOptions load_response_cache_options(const Json::Value& config);
+
+    // 序列化完成的响应，发布后只读，多个请求共享同一份缓冲区
+    struct CachedResponse
+    {
+        std::string body;           // 紧凑格式的 JSON
+        std::string gzipBody;       // 为空表示没有压缩副本
+        std::string etag;           // 带引号的强校验 ETag
+        std::chrono::steady_clock::time_point createdAt;
+    };
+
+    struct ResponseCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t invalidations = 0;
+        uint64_t coalesced = 0;         // 未命中但复用了并发请求生成的结果
+        uint64_t evictions = 0;         // 过期或超出容量被清理
+        uint64_t skipped = 0;           // 生成后按调用方要求不缓存
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    // 热点读接口的响应缓存，按调用方给定的键保存最终字节
+    // 写接口通过 invalidate 使对应的键失效，TTL 作为兜底；按字节数限制容量，超出时淘汰最早写入的响应
+    class ResponseCache
+    {
+    public:
+        using Builder = std::function<Json::Value()>;
+        using BodyBuilder = std::function<std::string()>;
+
+        // 生成的结果是否写入缓存；键来自客户端输入时，用它跳过不存在的对象，避免缓存被随意的键占满
+        using Storable = std::function<bool(const Json::Value&)>;
+
+        explicit ResponseCache(const ResponseCacheOptions& options);
+
+        ResponseCache(const ResponseCache&) = delete;
+        ResponseCache& operator=(const ResponseCache&) = delete;
+
+        // 命中直接返回；否则调用 builder 生成并序列化，builder 抛出的异常原样传出
+        // 同一个键同时未命中的请求只有一个调用 builder，其余等待并共享它的结果（缓存关闭时同样生效）
+        std::shared_ptr<const CachedResponse> get(const std::string& key, const Builder& builder,
+                                                  const Storable& storable = nullptr);
+
+        // 同上，builder 直接给出序列化好的 JSON 文本
+        std::shared_ptr<const CachedResponse> get_body(const std::string& key, const BodyBuilder& builder);
+
+        void invalidate(const std::string& key);
+
+        void clear();
+
+        bool enabled() const { return options.enabled; }
+
+        ResponseCacheStats stats() const;
+
+        // 为序列化好的 JSON 生成 ETag 与压缩副本
+        std::shared_ptr<const CachedResponse> make_response(std::string body) const;
+
+    private:
+        // builder 通过第二个参数决定结果是否写入缓存
+        using StoringBuilder = std::function<std::string(bool& store)>;
+
+        std::shared_ptr<const CachedResponse> lookup(const std::string& key, const StoringBuilder& builder);
+
+        static size_t response_bytes(const std::string& key, const CachedResponse& response);
+
+    private:
+        const ResponseCacheOptions options;
+
+        SnapshotMap<CachedResponse> entries;
+        SingleFlight<CachedResponse> flights;
+
+        std::atomic<uint64_t> hits {0};
+        std::atomic<uint64_t> misses {0};
+        std::atomic<uint64_t> invalidations {0};
+        std::atomic<uint64_t> skipped {0};
+    };
+
+    // gzip 压缩，失败时返回空串
+    std::string gzip_compress(const std::string& data);
+}
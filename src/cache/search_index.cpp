@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "search_index.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // 单字与双字的倒排键，码点不超过 21 位
+        uint64_t unigram_key(char32_t c)
+        {
+            return (uint64_t(1) << 63) | static_cast<uint64_t>(c);
+        }
+
+        uint64_t bigram_key(char32_t first, char32_t second)
+        {
+            return (static_cast<uint64_t>(first) << 21) | static_cast<uint64_t>(second);
+        }
+
+        char32_t fold(char32_t c)
+        {
+            // 全角 ASCII 转半角
+            if (c >= 0xFF01 && c <= 0xFF5E) {
+                c -= 0xFEE0;
+            }
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            return c;
+        }
+
+        // DECIMAL 列可能以字符串形式返回
+        double number(const Json::Value& value)
+        {
+            if (value.isString()) {
+                return std::atof(value.asCString());
+            }
+            return value.isNumeric() || value.isBool() ? value.asDouble() : 0.0;
+        }
+    }
+
+    SearchOptions load_search_options(const Json::Value& config)
+    {
+        SearchOptions options;
+        options.enabled = config.get("search_enabled", true).asBool();
+        options.refresh = std::chrono::seconds(config.get("search_refresh_s", 300).asInt());
+        options.defaultLimit = config.get("search_default_limit", 20).asUInt();
+        options.maxLimit = config.get("search_max_limit", 100).asUInt();
+        options.retryBackoff = std::chrono::seconds(std::max(1, config.get("search_retry_s", 5).asInt()));
+        options.maxRetryBackoff = std::max(options.retryBackoff,
+            std::chrono::seconds(config.get("search_retry_max_s", 60).asInt()));
+        return options;
+    }
+
+    std::u32string SearchIndex::normalize(const std::string& text)
+    {
+        std::u32string out;
+        out.reserve(text.size());
+
+        const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+        const size_t size = text.size();
+        size_t pos = 0;
+        while (pos < size) {
+            const unsigned char lead = bytes[pos];
+            size_t length = 0;
+            char32_t c = 0;
+            if (lead < 0x80) {
+                length = 1;
+                c = lead;
+            } else if ((lead & 0xE0) == 0xC0) {
+                length = 2;
+                c = lead & 0x1F;
+            } else if ((lead & 0xF0) == 0xE0) {
+                length = 3;
+                c = lead & 0x0F;
+            } else if ((lead & 0xF8) == 0xF0) {
+                length = 4;
+                c = lead & 0x07;
+            }
+
+            bool valid = length > 0 && pos + length <= size;
+            for (size_t index = 1; valid && index < length; ++index) {
+                const unsigned char next = bytes[pos + index];
+                valid = (next & 0xC0) == 0x80;
+                c = (c << 6) | (next & 0x3F);
+            }
+
+            if (!valid) {
+                out.push_back(lead);
+                pos += 1;
+                continue;
+            }
+            out.push_back(fold(c));
+            pos += length;
+        }
+        return out;
+    }
+
+    uint32_t SearchIndex::Corpus::upsert(Document doc)
+    {
+        auto existing = byId.find(doc.id);
+        if (existing != byId.end()) {
+            docs[existing->second].alive = false;
+            ++dead;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(docs.size());
+        byId[doc.id] = index;
+        docs.push_back(std::move(doc));
+        index_document(index);
+
+        // 删除的文档过多时整体重排，释放倒排表中的无效项
+        if (dead > 1024 && dead * 2 > docs.size()) {
+            compact();
+            return byId[docs.back().id];
+        }
+        return index;
+    }
+
+    const SearchIndex::Document* SearchIndex::Corpus::find(const std::string& id) const
+    {
+        auto found = byId.find(id);
+        return found == byId.end() ? nullptr : &docs[found->second];
+    }
+
+    SearchIndex::Document* SearchIndex::Corpus::find(const std::string& id)
+    {
+        auto found = byId.find(id);
+        return found == byId.end() ? nullptr : &docs[found->second];
+    }
+
+    void SearchIndex::Corpus::index_document(uint32_t index)
+    {
+        const std::u32string& key = docs[index].key;
+
+        std::vector<uint64_t> keys;
+        keys.reserve(key.size() * 2);
+        for (size_t pos = 0; pos < key.size(); ++pos) {
+            keys.push_back(unigram_key(key[pos]));
+            if (pos + 1 < key.size()) {
+                keys.push_back(bigram_key(key[pos], key[pos + 1]));
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        for (uint64_t gram : keys) {
+            postings[gram].push_back(index);
+        }
+    }
+
+    void SearchIndex::Corpus::compact()
+    {
+        std::vector<Document> live;
+        live.reserve(docs.size() - dead);
+        for (Document& doc : docs) {
+            if (doc.alive) {
+                live.push_back(std::move(doc));
+            }
+        }
+
+        docs = std::move(live);
+        byId.clear();
+        postings.clear();
+        dead = 0;
+        for (uint32_t index = 0; index < docs.size(); ++index) {
+            byId[docs[index].id] = index;
+            index_document(index);
+        }
+    }
+
+    std::vector<uint32_t> SearchIndex::Corpus::search(const std::u32string& query, SearchMode mode, size_t limit) const
+    {
+        if (query.empty() || limit == 0) {
+            return {};
+        }
+
+        // 关键字的全部双字（单字关键字取单字）对应的倒排表，从最短的开始求交集
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (size_t pos = 0; pos < query.size(); ++pos) {
+            const uint64_t gram = query.size() == 1 ? unigram_key(query[0]) : bigram_key(query[pos], query[pos + 1]);
+            auto found = postings.find(gram);
+            if (found == postings.end()) {
+                return {};
+            }
+            lists.push_back(&found->second);
+            if (query.size() == 1 || pos + 2 == query.size()) {
+                break;
+            }
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+        std::vector<uint32_t> candidates = *lists[0];
+        std::vector<uint32_t> scratch;
+        for (size_t index = 1; index < lists.size() && !candidates.empty(); ++index) {
+            if (lists[index] == lists[index - 1]) {
+                continue;
+            }
+            scratch.clear();
+            std::set_intersection(candidates.begin(), candidates.end(),
+                                  lists[index]->begin(), lists[index]->end(), std::back_inserter(scratch));
+            candidates.swap(scratch);
+        }
+
+        // 倒排表只保证每个双字都出现，这里核对整个关键字
+        struct Hit
+        {
+            uint32_t index;
+            bool prefix;
+        };
+        std::vector<Hit> hits;
+        for (uint32_t index : candidates) {
+            const Document& doc = docs[index];
+            if (!doc.alive) {
+                continue;
+            }
+            const size_t pos = doc.key.find(query);
+            if (pos == std::u32string::npos || (mode == SearchMode::Prefix && pos != 0)) {
+                continue;
+            }
+            hits.push_back({index, pos == 0});
+        }
+
+        auto better = [this](const Hit& a, const Hit& b) {
+            const Document& left = docs[a.index];
+            const Document& right = docs[b.index];
+            if (a.prefix != b.prefix) return a.prefix;
+            if (left.sales != right.sales) return left.sales > right.sales;
+            const double leftRating = left.rating();
+            const double rightRating = right.rating();
+            if (leftRating != rightRating) return leftRating > rightRating;
+            if (left.key.size() != right.key.size()) return left.key.size() < right.key.size();
+            return a.index < b.index;
+        };
+
+        const size_t count = std::min(limit, hits.size());
+        std::partial_sort(hits.begin(), hits.begin() + count, hits.end(), better);
+
+        std::vector<uint32_t> result;
+        result.reserve(count);
+        for (size_t index = 0; index < count; ++index) {
+            result.push_back(hits[index].index);
+        }
+        return result;
+    }
+
+    void SearchIndex::Index::apply_merchant(const Json::Value& row)
+    {
+        Document doc;
+        doc.id = row["merchantId"].asString();
+        doc.merchantId = doc.id;
+        doc.key = normalize(row["name"].asString());
+        doc.row = row;
+
+        // 保留由菜品汇总的销量与评分
+        if (const Document* previous = merchants.find(doc.id)) {
+            doc.sales = previous->sales;
+            doc.ratingSum = previous->ratingSum;
+            doc.ratingCount = previous->ratingCount;
+        }
+        merchants.upsert(std::move(doc));
+    }
+
+    void SearchIndex::Index::apply_dish(const Json::Value& row)
+    {
+        Document doc;
+        doc.id = row["dishId"].asString();
+        doc.merchantId = row["merchantId"].asString();
+        doc.key = normalize(row["name"].asString());
+        doc.row = row;
+        doc.sales = static_cast<int64_t>(number(row["sales"]));
+        doc.ratingSum = number(row["rating"]);
+        doc.ratingCount = 1;
+
+        // 更新所属商家的汇总：先减去旧记录，再加上新记录
+        if (const Document* previous = dishes.find(doc.id)) {
+            if (Document* merchant = merchants.find(previous->merchantId)) {
+                merchant->sales -= previous->sales;
+                if (previous->ratingSum > 0) {
+                    merchant->ratingSum -= previous->ratingSum;
+                    merchant->ratingCount -= 1;
+                }
+            }
+        }
+        if (Document* merchant = merchants.find(doc.merchantId)) {
+            merchant->sales += doc.sales;
+            if (doc.ratingSum > 0) {
+                merchant->ratingSum += doc.ratingSum;
+                merchant->ratingCount += 1;
+            }
+        }
+        dishes.upsert(std::move(doc));
+    }
+
+    SearchIndex::SearchIndex(LeaseProvider provider, const SearchOptions& searchOptions)
+        : leaseProvider(std::move(provider)), options(searchOptions)
+    {
+    }
+
+    Json::Value SearchIndex::merchants(const std::string& keyword, SearchMode mode, size_t limit)
+    {
+        return collect(false, keyword, mode, limit);
+    }
+
+    Json::Value SearchIndex::dishes(const std::string& keyword, SearchMode mode, size_t limit)
+    {
+        return collect(true, keyword, mode, limit);
+    }
+
+    Json::Value SearchIndex::collect(bool dishes, const std::string& keyword, SearchMode mode, size_t limit)
+    {
+        queries.fetch_add(1, std::memory_order_relaxed);
+        ensure_loaded();
+
+        const std::u32string query = normalize(keyword);
+        Json::Value result(Json::arrayValue);
+
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        const Corpus& corpus = dishes ? index->dishes : index->merchants;
+        for (uint32_t position : corpus.search(query, mode, clamp_limit(limit))) {
+            result.append(corpus.docs[position].row);
+        }
+        return result;
+    }
+
+    void SearchIndex::upsert_merchant(const Json::Value& row)
+    {
+        upserts.fetch_add(1, std::memory_order_relaxed);
+
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        if (index) {
+            index->apply_merchant(row);
+        }
+        if (recording) {
+            pending.push_back({false, row});
+        }
+    }
+
+    void SearchIndex::upsert_dish(const Json::Value& row)
+    {
+        upserts.fetch_add(1, std::memory_order_relaxed);
+
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        if (index) {
+            index->apply_dish(row);
+        }
+        if (recording) {
+            pending.push_back({true, row});
+        }
+    }
+
+    void SearchIndex::rebuild()
+    {
+        std::lock_guard<std::mutex> lock(rebuildMtx);
+        rebuild_locked();
+    }
+
+    size_t SearchIndex::clamp_limit(size_t requested) const
+    {
+        if (requested == 0) {
+            requested = options.defaultLimit;
+        }
+        return std::min(requested, options.maxLimit);
+    }
+
+    SearchStats SearchIndex::stats() const
+    {
+        SearchStats snapshot;
+        snapshot.queries = queries.load(std::memory_order_relaxed);
+        snapshot.rebuilds = rebuilds.load(std::memory_order_relaxed);
+        snapshot.upserts = upserts.load(std::memory_order_relaxed);
+        snapshot.loadFailures = loadFailures.load(std::memory_order_relaxed);
+        snapshot.rejected = rejected.load(std::memory_order_relaxed);
+
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        if (index) {
+            snapshot.merchants = index->merchants.size();
+            snapshot.dishes = index->dishes.size();
+        }
+        return snapshot;
+    }
+
+    void SearchIndex::ensure_loaded()
+    {
+        if (!loaded.load(std::memory_order_acquire)) {
+            // 首次加载：其他请求等待加载完成；加载失败后在退避期内直接失败，
+            // 等在锁上的请求拿到锁后同样先检查，不会排队依次重试
+            check_retry();
+            std::lock_guard<std::mutex> lock(rebuildMtx);
+            if (!loaded.load(std::memory_order_acquire)) {
+                check_retry();
+                rebuild_locked();
+            }
+            return;
+        }
+
+        bool stale;
+        {
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            stale = std::chrono::steady_clock::now() - index->loadedAt >= options.refresh;
+        }
+        if (!stale || !rebuildMtx.try_lock()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(rebuildMtx, std::adopt_lock);
+        try {
+            rebuild_locked();
+        } catch (const std::exception& e) {
+            // 重建失败继续使用旧索引，下一个周期再试
+            LOG_WARN_RATE(1, "Search index rebuild failed: " << e.what());
+            std::unique_lock<std::shared_mutex> writeLock(mtx);
+            index->loadedAt = std::chrono::steady_clock::now();
+        }
+    }
+
+    void SearchIndex::rebuild_locked()
+    {
+        {
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            recording = true;
+            pending.clear();
+        }
+
+        std::unique_ptr<Index> fresh;
+        try {
+            fresh = load();
+        } catch (...) {
+            {
+                std::unique_lock<std::shared_mutex> lock(mtx);
+                recording = false;
+                pending.clear();
+            }
+            if (!loaded.load(std::memory_order_acquire)) {
+                // 还没有可用的索引：记下下次重试的时间，退避时间逐次加倍
+                currentBackoff = currentBackoff.count() == 0
+                    ? std::chrono::milliseconds(options.retryBackoff)
+                    : std::min<std::chrono::milliseconds>(currentBackoff * 2, options.maxRetryBackoff);
+                retryAtMillis.store(now_millis() + currentBackoff.count(), std::memory_order_release);
+                loadFailures.fetch_add(1, std::memory_order_relaxed);
+                LOG_WARN_RATE(1, "Search index load failed, retry in " << currentBackoff.count() << "ms");
+            }
+            throw;
+        }
+        currentBackoff = std::chrono::milliseconds(0);
+        retryAtMillis.store(0, std::memory_order_release);
+
+        std::unique_ptr<Index> previous;
+        {
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            // 查库期间到达的写入可能不在结果中，按顺序重放一遍
+            for (const PendingWrite& write : pending) {
+                if (write.dish) {
+                    fresh->apply_dish(write.row);
+                } else {
+                    fresh->apply_merchant(write.row);
+                }
+            }
+            pending.clear();
+            recording = false;
+            previous = std::move(index);
+            index = std::move(fresh);
+        }
+
+        loaded.store(true, std::memory_order_release);
+        rebuilds.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void SearchIndex::check_retry() const
+    {
+        const int64_t retryAt = retryAtMillis.load(std::memory_order_acquire);
+        if (retryAt != 0 && now_millis() < retryAt) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            throw SearchUnavailableError("搜索索引暂不可用，请稍后重试");
+        }
+    }
+
+    int64_t SearchIndex::retry_after_seconds() const
+    {
+        const int64_t remaining = retryAtMillis.load(std::memory_order_acquire) - now_millis();
+        return std::max<int64_t>(1, (remaining + 999) / 1000);
+    }
+
+    int64_t SearchIndex::now_millis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::unique_ptr<SearchIndex::Index> SearchIndex::load()
+    {
+        Json::Value merchantRows;
+        Json::Value dishRows;
+        {
+            DBLease db = leaseProvider();
+            merchantRows = db->execute(StmtId::SearchMerchantsAll);
+            dishRows = db->execute(StmtId::SearchDishesAll);
+        }
+
+        auto fresh = std::make_unique<Index>();
+        fresh->merchants.docs.reserve(merchantRows.size());
+        fresh->dishes.docs.reserve(dishRows.size());
+
+        // 先加载商家，菜品加载时汇总到所属商家
+        for (const auto& row : merchantRows) {
+            fresh->apply_merchant(row);
+        }
+        for (const auto& row : dishRows) {
+            fresh->apply_dish(row);
+        }
+        fresh->loadedAt = std::chrono::steady_clock::now();
+
+        LOG_INFO("Search index loaded: " << fresh->merchants.size() << " merchants, "
+            << fresh->dishes.size() << " dishes");
+        return fresh;
+    }
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "db_pool.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 搜索索引参数
+    struct SearchOptions
+    {
+        bool enabled = true;
+        std::chrono::seconds refresh {300};     // 全量重建间隔，用于同步其他实例的写入
+        size_t defaultLimit = 20;
+        size_t maxLimit = 100;
+        std::chrono::seconds retryBackoff {5};        // 首次加载失败后多久再试，之后每次失败加倍
+        std::chrono::seconds maxRetryBackoff {60};
+    };
+
+    // 从 config.json 的 cache 节读取参数
+    SearchOptions load_search_options(const Json::Value& config);
+
+    // 索引尚未加载成功，且距离下一次重试还有一段时间
+    class SearchUnavailableError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    enum class SearchMode
+    {
+        Substring,      // 名称包含关键字，前缀匹配排在前面
+        Prefix          // 名称以关键字开头
+    };
+
+    struct SearchStats
+    {
+        uint64_t queries = 0;
+        uint64_t rebuilds = 0;
+        uint64_t upserts = 0;
+        uint64_t loadFailures = 0;      // 首次加载失败次数
+        uint64_t rejected = 0;          // 等待重试期间直接拒绝的查询
+        size_t merchants = 0;
+        size_t dishes = 0;
+    };
+
+    // 商家名与菜品名的进程内搜索索引
+    // 名称按 UTF-8 解码为码点（ASCII 转小写）后建立单字与相邻双字的倒排表：
+    // 查询取关键字全部双字的倒排表求交集，再逐条核对子串，中文不需要分词。
+    // 结果按销量、评分排序取前 limit 条；商家的销量与评分由其菜品汇总。
+    // 写接口调用 upsert 同步更新，另按 refresh 间隔从数据库全量重建。
+    class SearchIndex
+    {
+    public:
+        using LeaseProvider = std::function<DBLease()>;
+
+        SearchIndex(LeaseProvider leaseProvider, const SearchOptions& options);
+
+        SearchIndex(const SearchIndex&) = delete;
+        SearchIndex& operator=(const SearchIndex&) = delete;
+
+        // 返回 MERCHANT 表的行组成的数组；索引首次加载失败时抛出异常，
+        // 之后按 retryBackoff 退避，退避期间不再查库，直接抛出 SearchUnavailableError
+        Json::Value merchants(const std::string& keyword, SearchMode mode, size_t limit);
+
+        // 返回 dishId、merchantId、name、price、imageUrl、sales、rating、isOnSale 组成的数组
+        Json::Value dishes(const std::string& keyword, SearchMode mode, size_t limit);
+
+        // 新增或更新一条记录，字段与上面返回的行相同
+        void upsert_merchant(const Json::Value& row);
+
+        void upsert_dish(const Json::Value& row);
+
+        // 从数据库全量加载，失败时保留原索引并抛出异常
+        void rebuild();
+
+        bool enabled() const { return options.enabled; }
+
+        // 退避期内距离下一次重试的秒数（至少 1），用于 Retry-After
+        int64_t retry_after_seconds() const;
+
+        size_t clamp_limit(size_t requested) const;
+
+        SearchStats stats() const;
+
+        // UTF-8 解码为码点，ASCII 字母转小写；非法字节按单字节保留
+        static std::u32string normalize(const std::string& text);
+
+    private:
+        struct Document
+        {
+            std::string id;
+            std::string merchantId;
+            std::u32string key;         // normalize 后的名称
+            Json::Value row;
+            int64_t sales = 0;
+            double ratingSum = 0;
+            uint32_t ratingCount = 0;
+            bool alive = true;
+
+            double rating() const { return ratingCount > 0 ? ratingSum / ratingCount : 0.0; }
+        };
+
+        // 一类记录（商家或菜品）的倒排索引
+        struct Corpus
+        {
+            std::vector<Document> docs;
+            std::unordered_map<std::string, uint32_t> byId;
+            std::unordered_map<uint64_t, std::vector<uint32_t>> postings;   // 文档下标递增
+            size_t dead = 0;
+
+            // 返回新文档下标；同 id 的旧文档标记删除
+            uint32_t upsert(Document doc);
+
+            const Document* find(const std::string& id) const;
+
+            Document* find(const std::string& id);
+
+            std::vector<uint32_t> search(const std::u32string& query, SearchMode mode, size_t limit) const;
+
+            size_t size() const { return byId.size(); }
+
+        private:
+            void index_document(uint32_t index);
+
+            void compact();
+        };
+
+        struct Index
+        {
+            Corpus merchants;
+            Corpus dishes;
+            std::chrono::steady_clock::time_point loadedAt;
+
+            void apply_merchant(const Json::Value& row);
+
+            void apply_dish(const Json::Value& row);
+        };
+
+        struct PendingWrite
+        {
+            bool dish;
+            Json::Value row;
+        };
+
+        // 保证索引已加载，过期时由一个请求线程重建，其余请求继续使用旧索引
+        void ensure_loaded();
+
+        // 首次加载处于退避期时抛出 SearchUnavailableError
+        void check_retry() const;
+
+        static int64_t now_millis();
+
+        // 调用方持有 rebuildMtx
+        void rebuild_locked();
+
+        std::unique_ptr<Index> load();
+
+        Json::Value collect(bool dishes, const std::string& keyword, SearchMode mode, size_t limit);
+
+    private:
+        const LeaseProvider leaseProvider;
+        const SearchOptions options;
+
+        mutable std::shared_mutex mtx;          // 保护 index、pending、recording
+        std::unique_ptr<Index> index;
+        std::vector<PendingWrite> pending;      // 重建期间到达的写入，换入新索引前重放
+        bool recording = false;
+
+        std::mutex rebuildMtx;                  // 同一时间只有一个线程重建
+        std::atomic<bool> loaded {false};
+        std::atomic<int64_t> retryAtMillis {0};                 // 首次加载失败后，此前不再重试
+        std::chrono::milliseconds currentBackoff {0};           // rebuildMtx 保护
+
+        std::atomic<uint64_t> queries {0};
+        std::atomic<uint64_t> rebuilds {0};
+        std::atomic<uint64_t> upserts {0};
+        std::atomic<uint64_t> loadFailures {0};
+        mutable std::atomic<uint64_t> rejected {0};
+    };
+}
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "session_cache.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+        // 载荷各字段之间的分隔符
+        constexpr char FIELD_SEPARATOR = '\n';
+
+        std::string base64url_encode(const unsigned char* data, size_t length)
+        {
+            std::string out;
+            out.reserve((length + 2) / 3 * 4);
+            for (size_t index = 0; index < length; index += 3) {
+                const uint32_t chunk = (static_cast<uint32_t>(data[index]) << 16)
+                    | (index + 1 < length ? static_cast<uint32_t>(data[index + 1]) << 8 : 0)
+                    | (index + 2 < length ? static_cast<uint32_t>(data[index + 2]) : 0);
+                out += BASE64URL[(chunk >> 18) & 0x3F];
+                out += BASE64URL[(chunk >> 12) & 0x3F];
+                if (index + 1 < length) {
+                    out += BASE64URL[(chunk >> 6) & 0x3F];
+                }
+                if (index + 2 < length) {
+                    out += BASE64URL[chunk & 0x3F];
+                }
+            }
+            return out;
+        }
+
+        // 非法字符返回 false
+        bool base64url_decode(const std::string& text, std::string& out)
+        {
+            out.clear();
+            uint32_t buffer = 0;
+            int bits = 0;
+            for (char c : text) {
+                const char* found = std::strchr(BASE64URL, c);
+                if (c == '\0' || !found) {
+                    return false;
+                }
+                buffer = (buffer << 6) | static_cast<uint32_t>(found - BASE64URL);
+                bits += 6;
+                if (bits >= 8) {
+                    bits -= 8;
+                    out += static_cast<char>((buffer >> bits) & 0xFF);
+                }
+            }
+            return true;
+        }
+
+        std::string random_hex(size_t bytes)
+        {
+            std::vector<unsigned char> buffer(bytes);
+            if (RAND_bytes(buffer.data(), static_cast<int>(buffer.size())) != 1) {
+                throw std::runtime_error("RAND_bytes failed");
+            }
+
+            static const char HEX[] = "0123456789abcdef";
+            std::string out;
+            out.reserve(bytes * 2);
+            for (unsigned char byte : buffer) {
+                out += HEX[byte >> 4];
+                out += HEX[byte & 0x0F];
+            }
+            return out;
+        }
+
+        int64_t unix_now()
+        {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    SessionOptions load_session_options(const Json::Value& config)
+    {
+        SessionOptions options;
+        options.secret = config.get("secret", "").asString();
+        options.ttl = std::chrono::seconds(config.get("token_ttl_s", 86400).asInt());
+        options.maxSessions = std::max(1u, config.get("max_sessions", 100000).asUInt());
+        return options;
+    }
+
+    SessionCache::SessionCache(const SessionOptions& sessionOptions)
+        : options(sessionOptions)
+    {
+        if (options.secret.empty()) {
+            LOG_WARN("auth.secret is not set, using a random key: tokens will not survive a restart");
+            options.secret = random_hex(32);
+        }
+    }
+
+    std::string SessionCache::issue(const std::string& kind, const std::string& subjectId)
+    {
+        if (subjectId.empty() || subjectId.find(FIELD_SEPARATOR) != std::string::npos) {
+            throw std::invalid_argument("无效的登录身份");
+        }
+
+        Session session;
+        session.sessionId = random_hex(16);
+        session.kind = kind;
+        session.subjectId = subjectId;
+        session.expiresAt = unix_now() + options.ttl.count();
+
+        const std::string payload = kind + FIELD_SEPARATOR + subjectId + FIELD_SEPARATOR
+            + session.sessionId + FIELD_SEPARATOR + std::to_string(session.expiresAt);
+        const std::string encoded = base64url_encode(reinterpret_cast<const unsigned char*>(payload.data()), payload.size());
+        const std::string token = encoded + "." + sign(encoded);
+
+        // 每个分片达到上限时先清理过期会话，仍然满则淘汰最早过期的一个
+        const size_t capacity = std::max<size_t>(1, options.maxSessions / SHARD_COUNT);
+        SessionShard& shard = shard_for(session.sessionId);
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            if (shard.sessions.size() >= capacity) {
+                const int64_t now = unix_now();
+                for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+                    it = it->second.expiresAt <= now ? shard.sessions.erase(it) : std::next(it);
+                }
+            }
+            if (shard.sessions.size() >= capacity) {
+                auto oldest = std::min_element(shard.sessions.begin(), shard.sessions.end(),
+                    [](const auto& a, const auto& b) { return a.second.expiresAt < b.second.expiresAt; });
+                shard.sessions.erase(oldest);
+                evictedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            shard.sessions.emplace(session.sessionId, session);
+        }
+
+        issuedCount.fetch_add(1, std::memory_order_relaxed);
+        return token;
+    }
+
+    std::optional<Session> SessionCache::validate(const std::string& token)
+    {
+        const std::optional<Session> claimed = decode(token);
+        if (!claimed || claimed->expiresAt <= unix_now()) {
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        SessionShard& shard = shard_for(claimed->sessionId);
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        auto found = shard.sessions.find(claimed->sessionId);
+        if (found == shard.sessions.end()) {
+            lock.unlock();
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        Session session = found->second;
+        lock.unlock();
+
+        validatedCount.fetch_add(1, std::memory_order_relaxed);
+        return session;
+    }
+
+    std::string SessionCache::bearer_token(const std::string& authorization)
+    {
+        static const std::string PREFIX = "Bearer ";
+        if (authorization.size() <= PREFIX.size() || authorization.compare(0, PREFIX.size(), PREFIX) != 0) {
+            return "";
+        }
+        return authorization.substr(PREFIX.size());
+    }
+
+    bool SessionCache::revoke(const std::string& token)
+    {
+        const std::optional<Session> claimed = decode(token);
+        if (!claimed) {
+            return false;
+        }
+
+        SessionShard& shard = shard_for(claimed->sessionId);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        if (shard.sessions.erase(claimed->sessionId) == 0) {
+            return false;
+        }
+        revokedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    SessionStats SessionCache::stats() const
+    {
+        SessionStats snapshot;
+        snapshot.issued = issuedCount.load(std::memory_order_relaxed);
+        snapshot.validated = validatedCount.load(std::memory_order_relaxed);
+        snapshot.rejected = rejectedCount.load(std::memory_order_relaxed);
+        snapshot.revoked = revokedCount.load(std::memory_order_relaxed);
+        snapshot.evicted = evictedCount.load(std::memory_order_relaxed);
+        for (const SessionShard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            snapshot.sessions += shard.sessions.size();
+        }
+        return snapshot;
+    }
+
+    std::string SessionCache::sign(const std::string& payload) const
+    {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        if (!HMAC(EVP_sha256(), options.secret.data(), static_cast<int>(options.secret.size()),
+                  reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), digest, &length)) {
+            throw std::runtime_error("HMAC failed");
+        }
+        return base64url_encode(digest, length);
+    }
+
+    std::optional<Session> SessionCache::decode(const std::string& token) const
+    {
+        const size_t dot = token.find('.');
+        if (dot == std::string::npos || dot == 0) {
+            return std::nullopt;
+        }
+
+        // 常量时间比较签名
+        const std::string encoded = token.substr(0, dot);
+        const std::string signature = token.substr(dot + 1);
+        const std::string expected = sign(encoded);
+        if (signature.size() != expected.size()
+            || CRYPTO_memcmp(signature.data(), expected.data(), expected.size()) != 0) {
+            return std::nullopt;
+        }
+
+        std::string payload;
+        if (!base64url_decode(encoded, payload)) {
+            return std::nullopt;
+        }
+
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            const size_t end = payload.find(FIELD_SEPARATOR, start);
+            fields.push_back(payload.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        if (fields.size() != 4) {
+            return std::nullopt;
+        }
+
+        Session session;
+        session.kind = fields[0];
+        session.subjectId = fields[1];
+        session.sessionId = fields[2];
+        try {
+            session.expiresAt = std::stoll(fields[3]);
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+        return session;
+    }
+
+    SessionCache::SessionShard& SessionCache::shard_for(const std::string& sessionId)
+    {
+        return shards[std::hash<std::string>()(sessionId) % SHARD_COUNT];
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "common.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 登录会话参数
+    struct SessionOptions
+    {
+        std::string secret;                 // HMAC 密钥，为空时启动时随机生成（重启后旧令牌失效）
+        std::chrono::seconds ttl {86400};   // 令牌与会话的有效期
+        size_t maxSessions = 100000;        // 会话数上限，超出时淘汰最早过期的会话
+    };
+
+    // 从 config.json 的 auth 节读取参数
+    SessionOptions load_session_options(const Json::Value& config);
+
+    // 已登录的身份
+    struct Session
+    {
+        std::string sessionId;
+        std::string kind;           // "user" 或 "admin"
+        std::string subjectId;      // userId 或 adminId
+        int64_t expiresAt = 0;      // Unix 秒
+    };
+
+    struct SessionStats
+    {
+        uint64_t issued = 0;
+        uint64_t validated = 0;
+        uint64_t rejected = 0;      // 签名错误、过期、已注销或不在缓存中
+        uint64_t revoked = 0;
+        uint64_t evicted = 0;
+        size_t sessions = 0;
+    };
+
+    // 登录令牌与进程内会话缓存
+    // 令牌为 base64url(载荷).base64url(HMAC-SHA256(载荷))，载荷包含会话、身份与过期时间。
+    // 校验时先验签名和过期时间，再在按 sessionId 分片的缓存中查找会话，之后的请求不再查库；
+    // 注销即从缓存中删除。会话只保存在签发它的进程中，其他实例签发的令牌会被拒绝。
+    class SessionCache
+    {
+    public:
+        explicit SessionCache(const SessionOptions& options);
+
+        SessionCache(const SessionCache&) = delete;
+        SessionCache& operator=(const SessionCache&) = delete;
+
+        // 登录成功后调用，返回令牌
+        std::string issue(const std::string& kind, const std::string& subjectId);
+
+        // 令牌无效时返回空
+        std::optional<Session> validate(const std::string& token);
+
+        // 从 "Authorization: Bearer <token>" 的取值中取出令牌，格式不对时返回空串
+        static std::string bearer_token(const std::string& authorization);
+
+        // 注销令牌对应的会话，令牌无效时返回 false
+        bool revoke(const std::string& token);
+
+        std::chrono::seconds ttl() const { return options.ttl; }
+
+        SessionStats stats() const;
+
+    private:
+        struct SessionShard
+        {
+            mutable std::mutex mtx;
+            std::unordered_map<std::string, Session> sessions;
+        };
+
+        static constexpr size_t SHARD_COUNT = 16;
+
+        std::string sign(const std::string& payload) const;
+
+        // 验签并解析载荷，不查缓存
+        std::optional<Session> decode(const std::string& token) const;
+
+        SessionShard& shard_for(const std::string& sessionId);
+
+    private:
+        SessionOptions options;
+
+        std::array<SessionShard, SHARD_COUNT> shards;
+
+        std::atomic<uint64_t> issuedCount {0};
+        std::atomic<uint64_t> validatedCount {0};
+        std::atomic<uint64_t> rejectedCount {0};
+        std::atomic<uint64_t> revokedCount {0};
+        std::atomic<uint64_t> evictedCount {0};
+    };
+}
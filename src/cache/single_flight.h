@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "request_deadline.h"
+
+
+namespace TakeAwayPlatform
+{
+    struct SingleFlightStats
+    {
+        uint64_t leaders = 0;       // 实际执行加载的请求
+        uint64_t coalesced = 0;     // 等待并复用其他请求结果的请求
+    };
+
+    // 相同键的并发加载合并为一次（single-flight）
+    // 第一个到达的请求执行 loader，同一时间到达的其他请求等待并共享它的结果；
+    // loader 抛出的异常同样交给所有等待者。加载结束后立即移除该键，之后到达的请求重新加载；
+    // 本类不保存结果，缓存由调用方负责。
+    template<typename V, size_t ShardCount = 16>
+    class SingleFlight
+    {
+    public:
+        using Result = std::shared_ptr<const V>;
+        using Loader = std::function<Result()>;
+
+        SingleFlight() = default;
+
+        SingleFlight(const SingleFlight&) = delete;
+        SingleFlight& operator=(const SingleFlight&) = delete;
+
+        // 等待其他请求的结果时不会越过当前请求的截止时间，超时抛出 std::runtime_error
+        Result run(const std::string& key, const Loader& loader)
+        {
+            Shard& shard = shard_for(key);
+            std::shared_ptr<Flight> flight;
+            bool leader = false;
+            {
+                std::lock_guard<std::mutex> lock(shard.mtx);
+                std::shared_ptr<Flight>& slot = shard.flights[key];
+                if (!slot) {
+                    slot = std::make_shared<Flight>();
+                    leader = true;
+                }
+                flight = slot;
+            }
+
+            if (!leader) {
+                coalescedCount.fetch_add(1, std::memory_order_relaxed);
+                return wait(*flight);
+            }
+
+            leaderCount.fetch_add(1, std::memory_order_relaxed);
+            try {
+                Result result = loader();
+                finish(shard, key, flight);
+                flight->promise.set_value(result);
+                return result;
+            } catch (...) {
+                finish(shard, key, flight);
+                flight->promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        SingleFlightStats stats() const
+        {
+            SingleFlightStats snapshot;
+            snapshot.leaders = leaderCount.load(std::memory_order_relaxed);
+            snapshot.coalesced = coalescedCount.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+    private:
+        struct Flight
+        {
+            std::promise<Result> promise;
+            std::shared_future<Result> future = promise.get_future().share();
+        };
+
+        struct Shard
+        {
+            std::mutex mtx;
+            std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+        };
+
+        static Result wait(const Flight& flight)
+        {
+            const RequestDeadline::Clock::time_point deadline = RequestDeadline::current();
+            if (deadline != RequestDeadline::Clock::time_point::max()
+                && flight.future.wait_until(deadline) != std::future_status::ready) {
+                throw std::runtime_error("等待相同请求的结果超时");
+            }
+            return flight.future.get();
+        }
+
+        // 先移除再发布结果，发布之后到达的请求会开始新的加载
+        static void finish(Shard& shard, const std::string& key, const std::shared_ptr<Flight>& flight)
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto found = shard.flights.find(key);
+            if (found != shard.flights.end() && found->second == flight) {
+                shard.flights.erase(found);
+            }
+        }
+
+        Shard& shard_for(const std::string& key)
+        {
+            return shards[std::hash<std::string>{}(key) % ShardCount];
+        }
+
+    private:
+        std::array<Shard, ShardCount> shards;
+
+        std::atomic<uint64_t> leaderCount {0};
+        std::atomic<uint64_t> coalescedCount {0};
+    };
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace TakeAwayPlatform
+{
+    // 以字符串为键的只读快照表
+    // 读路径只做一次 shared_ptr 原子加载，不持有任何互斥锁；
+    // 写入与删除时复制分片内的映射表并整体替换（RCU 方式）。
+    // 删除会推进分片代数，调用方在加载前记下代数，发布时代数已变化则放弃发布，避免旧数据回填。
+    // 容量按调用方给出的代价（条数或字节数）计，平均分给各分片。发布时反正要复制整个分片，
+    // 顺带清掉分片内过期的条目，仍然超出容量时按写入顺序淘汰最早的条目；单条代价超过分片容量的值不缓存。
+    template<typename V, size_t ShardCount = 16>
+    class SnapshotMap
+    {
+    public:
+        // 条目是否已过期，发布时据此清理
+        using StalePredicate = std::function<bool(const V&)>;
+
+        // capacity 为 0 表示不限制
+        explicit SnapshotMap(size_t capacity = 0, StalePredicate stale = nullptr)
+            : shardCapacity(capacity == 0 ? 0 : (capacity + ShardCount - 1) / ShardCount),
+              isStale(std::move(stale)) {}
+
+        SnapshotMap(const SnapshotMap&) = delete;
+        SnapshotMap& operator=(const SnapshotMap&) = delete;
+
+        std::shared_ptr<const V> find(const std::string& key) const
+        {
+            const Shard& shard = shard_for(key);
+            std::shared_ptr<const EntryMap> entries = std::atomic_load(&shard.entries);
+            auto found = entries->find(key);
+            return found != entries->end() ? found->second.value : nullptr;
+        }
+
+        // 加载前调用，结果交给 publish
+        uint64_t generation(const std::string& key) const
+        {
+            return shard_for(key).generation.load(std::memory_order_acquire);
+        }
+
+        // 期间没有发生删除时才写入，返回是否写入
+        bool publish(const std::string& key, std::shared_ptr<const V> value, uint64_t expectedGeneration, size_t cost = 1)
+        {
+            if (shardCapacity > 0 && cost > shardCapacity) {
+                return false;
+            }
+
+            Shard& shard = shard_for(key);
+            std::lock_guard<std::mutex> lock(shard.writeMtx);
+            if (shard.generation.load(std::memory_order_relaxed) != expectedGeneration) {
+                return false;
+            }
+
+            auto updated = std::make_shared<EntryMap>(*std::atomic_load(&shard.entries));
+            size_t total = shard.cost.load(std::memory_order_relaxed);
+            auto existing = updated->find(key);
+            if (existing != updated->end()) {
+                total -= existing->second.cost;
+                updated->erase(existing);
+            }
+            total = remove_stale(*updated, total);
+            if (shardCapacity > 0 && total + cost > shardCapacity) {
+                total = evict_oldest(*updated, total, shardCapacity - cost);
+            }
+
+            updated->emplace(key, Entry {std::move(value), cost, ++shard.sequence});
+            shard.cost.store(total + cost, std::memory_order_relaxed);
+            shard.size.store(updated->size(), std::memory_order_relaxed);
+            std::atomic_store(&shard.entries, std::shared_ptr<const EntryMap>(std::move(updated)));
+            return true;
+        }
+
+        void erase(const std::string& key)
+        {
+            Shard& shard = shard_for(key);
+            std::lock_guard<std::mutex> lock(shard.writeMtx);
+            shard.generation.fetch_add(1, std::memory_order_acq_rel);
+
+            std::shared_ptr<const EntryMap> entries = std::atomic_load(&shard.entries);
+            auto found = entries->find(key);
+            if (found != entries->end()) {
+                const size_t cost = found->second.cost;
+                auto updated = std::make_shared<EntryMap>(*entries);
+                updated->erase(key);
+                shard.cost.fetch_sub(cost, std::memory_order_relaxed);
+                shard.size.store(updated->size(), std::memory_order_relaxed);
+                std::atomic_store(&shard.entries, std::shared_ptr<const EntryMap>(std::move(updated)));
+            }
+        }
+
+        void clear()
+        {
+            for (Shard& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard.writeMtx);
+                shard.generation.fetch_add(1, std::memory_order_acq_rel);
+                shard.cost.store(0, std::memory_order_relaxed);
+                shard.size.store(0, std::memory_order_relaxed);
+                std::atomic_store(&shard.entries, std::make_shared<const EntryMap>());
+            }
+        }
+
+        // 条目数与代价合计，各分片分别读取，只用于监控
+        size_t size() const
+        {
+            size_t total = 0;
+            for (const Shard& shard : shards) {
+                total += shard.size.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        size_t cost() const
+        {
+            size_t total = 0;
+            for (const Shard& shard : shards) {
+                total += shard.cost.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        // 因过期或超出容量被清理的条目数
+        uint64_t evictions() const
+        {
+            return evicted.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const V> value;
+            size_t cost = 1;
+            uint64_t sequence = 0;      // 写入顺序，超出容量时先淘汰最早的
+        };
+
+        using EntryMap = std::unordered_map<std::string, Entry>;
+
+        struct Shard
+        {
+            std::shared_ptr<const EntryMap> entries = std::make_shared<const EntryMap>();
+            std::mutex writeMtx;                 // 只串行化写者
+            std::atomic<uint64_t> generation {0};
+            std::atomic<size_t> cost {0};        // 由写者在 writeMtx 下修改
+            std::atomic<size_t> size {0};
+            uint64_t sequence = 0;
+        };
+
+        // 以下两个函数在复制出的映射表上执行，返回清理后的代价合计
+
+        size_t remove_stale(EntryMap& entries, size_t total)
+        {
+            if (!isStale) {
+                return total;
+            }
+            for (auto it = entries.begin(); it != entries.end();) {
+                if (isStale(*it->second.value)) {
+                    total -= it->second.cost;
+                    it = entries.erase(it);
+                    evicted.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    ++it;
+                }
+            }
+            return total;
+        }
+
+        // 按写入顺序淘汰，直到合计不超过 limit
+        size_t evict_oldest(EntryMap& entries, size_t total, size_t limit)
+        {
+            std::vector<std::pair<uint64_t, const std::string*>> order;
+            order.reserve(entries.size());
+            for (const auto& entry : entries) {
+                order.emplace_back(entry.second.sequence, &entry.first);
+            }
+            std::sort(order.begin(), order.end());
+
+            std::vector<std::string> victims;
+            for (const auto& candidate : order) {
+                if (total <= limit) {
+                    break;
+                }
+                total -= entries.at(*candidate.second).cost;
+                victims.push_back(*candidate.second);
+            }
+            for (const std::string& victim : victims) {
+                entries.erase(victim);
+            }
+            evicted.fetch_add(victims.size(), std::memory_order_relaxed);
+            return total;
+        }
+
+        Shard& shard_for(const std::string& key)
+        {
+            return shards[std::hash<std::string>{}(key) % ShardCount];
+        }
+
+        const Shard& shard_for(const std::string& key) const
+        {
+            return shards[std::hash<std::string>{}(key) % ShardCount];
+        }
+
+    private:
+        const size_t shardCapacity;
+        const StalePredicate isStale;
+        std::array<Shard, ShardCount> shards;
+        std::atomic<uint64_t> evicted {0};
+    };
+}
@@ -1,6 +1,9 @@
-#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
 
 #include "db_handler.h"
+#include "logger.h"
+#include "metrics.h"
 
 
 namespace TakeAwayPlatform
@@ -14,8 +17,7 @@ namespace TakeAwayPlatform
     {
         try 
         {
-            std::cout << "DatabaseHandler::query sql:" << sql << std::endl;
-            std::cout.flush();
+            LOG_DEBUG("DatabaseHandler::query sql:" << sql);
 
             mysqlx::SqlResult result = session->sql(sql).execute();
             return parse_result(result);
@@ -23,11 +25,142 @@ namespace TakeAwayPlatform
         catch (const mysqlx::Error& e) 
         {
             // 处理数据库错误
-            std::cerr << "Database error: " << e.what() << std::endl;
+            LOG_ERROR_RATE(20, "Database error: " << e.what());
+            suspect = true;
             return Json::Value(Json::objectValue);
         }
     }
 
+    namespace
+    {
+        struct StatementMetrics
+        {
+            Histogram* duration;
+            Counter* errors;
+        };
+
+        // 按语句名取指标，语句名是静态字符串，按指针缓存在线程本地，热路径上不查注册表
+        StatementMetrics& statement_metrics(const char* name)
+        {
+            thread_local std::unordered_map<const char*, StatementMetrics> cache;
+            auto found = cache.find(name);
+            if (found != cache.end()) {
+                return found->second;
+            }
+
+            MetricsRegistry& registry = MetricsRegistry::instance();
+            const MetricLabels labels {{"statement", name}};
+            StatementMetrics metrics {
+                &registry.histogram("takeaway_db_statement_duration_seconds",
+                    "Time from bind to the first result packet, per statement", labels),
+                &registry.counter("takeaway_db_errors_total", "Statements that failed with a database error", labels)
+            };
+            return cache.emplace(name, metrics).first->second;
+        }
+    }
+
+    mysqlx::SqlResult DatabaseHandler::run(const std::string& sql,
+                                           const BoundValues& params,
+                                           const char* name)
+    {
+        StatementMetrics& metrics = statement_metrics(name);
+        ScopedTimer timer(*metrics.duration);
+
+        try 
+        {
+            mysqlx::SqlStatement statement = prepare(sql);
+            for (const auto& value : params) {
+                statement.bind(value);
+            }
+            return statement.execute();
+        } 
+        catch (const mysqlx::Error& e) 
+        {
+            // 与 query 不同，这里把错误抛给调用方，避免写入失败被当作成功
+            metrics.errors->add();
+            LOG_ERROR_RATE(20, "Database error in " << name << ": " << e.what());
+            suspect = true;
+            throw;
+        }
+    }
+
+    Json::Value DatabaseHandler::execute_bound(StmtId id, const BoundValues& params)
+    {
+        mysqlx::SqlResult result = result_bound(id, params);
+        return parse_result(result);
+    }
+
+    mysqlx::SqlResult DatabaseHandler::result_bound(StmtId id, const BoundValues& params)
+    {
+        return run(statement_sql(id), params, statement_name(id));
+    }
+
+    uint64_t DatabaseHandler::update_bound(StmtId id, const BoundValues& params)
+    {
+        mysqlx::SqlResult result = run(statement_sql(id), params, statement_name(id));
+        return result.getAffectedItemsCount();
+    }
+
+    Json::Value DatabaseHandler::execute_sql(const std::string& sql, const BoundValues& params)
+    {
+        mysqlx::SqlResult result = run(sql, params, "dynamic");
+        return parse_result(result);
+    }
+
+    uint64_t DatabaseHandler::update_sql(const std::string& sql, const BoundValues& params)
+    {
+        mysqlx::SqlResult result = run(sql, params, "dynamic");
+        return result.getAffectedItemsCount();
+    }
+
+    void DatabaseHandler::begin()
+    {
+        if (!session) {
+            throw std::runtime_error("Database session is not available");
+        }
+
+        try {
+            session->startTransaction();
+            inTransaction = true;
+        } catch (const mysqlx::Error& e) {
+            LOG_ERROR_RATE(20, "Database error in begin: " << e.what());
+            suspect = true;
+            throw;
+        }
+    }
+
+    void DatabaseHandler::commit()
+    {
+        try {
+            session->commit();
+            inTransaction = false;
+        } catch (const mysqlx::Error& e) {
+            LOG_ERROR_RATE(20, "Database error in commit: " << e.what());
+            suspect = true;
+            throw;
+        }
+    }
+
+    void DatabaseHandler::rollback()
+    {
+        try {
+            session->rollback();
+            inTransaction = false;
+        } catch (const mysqlx::Error& e) {
+            LOG_ERROR_RATE(20, "Database error in rollback: " << e.what());
+            suspect = true;
+            throw;
+        }
+    }
+
+    mysqlx::SqlStatement DatabaseHandler::prepare(const std::string& sql)
+    {
+        if (!session) {
+            throw std::runtime_error("Database session is not available");
+        }
+        return session->sql(sql);
+    }
+
     bool DatabaseHandler::is_connected() const 
     {
         if (!session) {
@@ -45,6 +178,21 @@ namespace TakeAwayPlatform
         }
     }
 
+    bool DatabaseHandler::recover()
+    {
+        // 残留的事务必须回滚，否则下一个使用者会在别人的事务里执行
+        if (inTransaction)
+        {
+            try {
+                rollback();
+            } catch (const mysqlx::Error&) {
+                return false;
+            }
+        }
+
+        return is_connected();
+    }
+
     void DatabaseHandler::reconnect() 
     {
         if (session) 
@@ -58,30 +206,27 @@ namespace TakeAwayPlatform
     void DatabaseHandler::connect(const DBConfig& config)
     {
         dbConfig = config;
+
+        inTransaction = false;
         
         try 
         {
-            std::cout << "DatabaseHandler::connect host:" << config.host << std::endl;
-            std::cout << "DatabaseHandler::connect port:" << config.port << std::endl;
-            std::cout << "DatabaseHandler::connect user:" << config.user << std::endl;
-            std::cout << "DatabaseHandler::connect password:" << config.password << std::endl;
-            std::cout.flush();
+            LOG_DEBUG("DatabaseHandler::connect " << config.user << "@"
+                << config.host << ":" << config.port);
 
             // 基于X Protocol，使用URI连接
             // 显示禁止ssl连接，因为MySQL 8.0默认不支持ssl连接
+            // 默认库直接放在URI中，省去握手后的 USE 往返
             std::string uri = "mysqlx://" + config.user + ":" + config.password + 
                             "@" + config.host + ":" + std::to_string(config.port) + 
-                            "?ssl-mode=DISABLED";
+                            "/" + config.database + "?ssl-mode=DISABLED";
             session = std::make_unique<mysqlx::Session>(uri);
 
-            session->sql("USE " + config.database).execute();
-
-            std::cout << "Database connection successful." << std::endl;
-            std::cout.flush();
+            LOG_DEBUG("Database connection successful.");
         } 
         catch (const mysqlx::Error& e) 
         {
-            std::cerr << "Database connection failed: " << e.what() << std::endl;
+            LOG_ERROR("Database connection failed: " << e.what());
             session.reset();
         }
     }
@@ -89,14 +234,27 @@ namespace TakeAwayPlatform
     Json::Value DatabaseHandler::parse_result(mysqlx::SqlResult& result) 
     {
         Json::Value json_result(Json::arrayValue);
+
+        // INSERT 等语句没有结果集
+        if (!result.hasData()) {
+            return json_result;
+        }
         
+        // 列名只取一次，每行复用
+        const unsigned column_count = result.getColumnCount();
+        std::vector<std::string> column_names;
+        column_names.reserve(column_count);
+        for (unsigned index = 0; index < column_count; ++index) {
+            column_names.push_back(result.getColumn(index).getColumnName());
+        }
+
         for(mysqlx::Row row : result.fetchAll()) 
         {
-            Json::Value json_row;
-            for(unsigned index = 0; index < row.colCount(); ++index) 
+            Json::Value json_row(Json::objectValue);
+            for(unsigned index = 0; index < row.colCount() && index < column_count; ++index) 
             {
                 mysqlx::Value value = row[index];
-                std::string column_name = result.getColumn(index).getColumnName();
+                const std::string& column_name = column_names[index];
 
                 switch(value.getType()) 
                 {
@@ -1,10 +1,18 @@
 #pragma once
 
+#include <vector>
+#include <memory>
+#include <memory_resource>
+
 #include "common.h"
+#include "request_arena.h"
+#include "sql_statements.h"
 #include <mysqlx/xdevapi.h>
 
 namespace TakeAwayPlatform
 {
+    // 按顺序绑定到 ? 占位符的参数；请求内构造时从 RequestArena 分配
+    using BoundValues = std::pmr::vector<mysqlx::Value>;
 
     class DatabaseHandler 
     {
@@ -13,20 +21,136 @@ namespace TakeAwayPlatform
 
         Json::Value query(const std::string& sql);
 
+        // 执行预定义语句，参数按顺序绑定到 ? 占位符
+        // 语句对象每次执行时新建，不在连接上缓存
+        template<typename... Args>
+        Json::Value execute(StmtId id, const Args&... params)
+        {
+            return execute_bound(id, bind_values(params...));
+        }
+
+        // 执行预定义的写语句，返回受影响行数
+        template<typename... Args>
+        uint64_t execute_update(StmtId id, const Args&... params)
+        {
+            return update_bound(id, bind_values(params...));
+        }
+
+        // 执行预定义查询并返回原始结果集，由调用方逐行读取（见 JsonRowWriter）
+        // 结果读完之前不要在同一连接上执行其他语句
+        template<typename... Args>
+        mysqlx::SqlResult execute_result(StmtId id, const Args&... params)
+        {
+            return result_bound(id, bind_values(params...));
+        }
+
+        Json::Value execute_bound(StmtId id, const BoundValues& params);
+
+        mysqlx::SqlResult result_bound(StmtId id, const BoundValues& params);
+
+        uint64_t update_bound(StmtId id, const BoundValues& params);
+
+        // 执行运行时拼出的语句（例如行数不定的批量插入）
+        // 文本中只能出现占位符，不允许拼接用户输入
+        Json::Value execute_sql(const std::string& sql, const BoundValues& params);
+
+        uint64_t update_sql(const std::string& sql, const BoundValues& params);
+
+        // 事务控制，推荐通过 Transaction 使用
+        void begin();
+
+        void commit();
+
+        void rollback();
+
+        bool in_transaction() const { return inTransaction; }
+
+        // 会话对象是否存在（不访问网络）
+        bool is_open() const { return session != nullptr; }
+
+        // 通过 SELECT 1 探活，只在后台健康检查中调用
         bool is_connected() const;
 
         void reconnect();
 
+        // 执行中出现过数据库错误，归还连接池前需要确认连接状态
+        bool is_suspect() const { return suspect; }
+
+        void clear_suspect() { suspect = false; }
+
+        void mark_suspect() { suspect = true; }
+
+        // 出错后尝试把连接恢复到可复用状态，失败返回 false
+        bool recover();
+
         
     private:
         void connect(const DBConfig& config);
 
+        mysqlx::SqlStatement prepare(const std::string& sql);
+
+        // 新建语句对象，绑定参数并执行，出错时标记连接可疑
+        mysqlx::SqlResult run(const std::string& sql, const BoundValues& params, const char* name);
+
+        template<typename... Args>
+        static BoundValues bind_values(const Args&... params)
+        {
+            BoundValues values(RequestArena::resource());
+            values.reserve(sizeof...(Args));
+            (values.emplace_back(params), ...);
+            return values;
+        }
+
         Json::Value parse_result(mysqlx::SqlResult& result);
 
 
     private:
         DBConfig dbConfig;
         std::unique_ptr<mysqlx::Session> session;
+
+        bool inTransaction = false;
+
+        bool suspect = false;
     };
 
-}
\ No newline at end of file
+    // 事务作用域：析构时若未提交则回滚
+    class Transaction
+    {
+    public:
+        explicit Transaction(DatabaseHandler& db) : db(db)
+        {
+            db.begin();
+        }
+
+        ~Transaction()
+        {
+            if (active) {
+                try {
+                    db.rollback();
+                } catch (...) {
+                    // 回滚失败时连接已被标记可疑，归还时由连接池处理
+                }
+            }
+        }
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        void commit()
+        {
+            db.commit();
+            active = false;
+        }
+
+    private:
+        DatabaseHandler& db;
+        bool active = true;
+    };
+
+    // 空字符串绑定为 SQL NULL
+    inline mysqlx::Value nullable(const std::string& value)
+    {
+        return value.empty() ? mysqlx::Value() : mysqlx::Value(value);
+    }
+
+} 
@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "db_pool.h"
+#include "logger.h"
+#include "request_deadline.h"
+
+
+namespace TakeAwayPlatform
+{
+    PoolOptions load_pool_options(const Json::Value& config)
+    {
+        PoolOptions options;
+
+        // pool_size 保持原含义：启动时建立的连接数，同时作为常驻下限
+        options.minSize = config.get("pool_size", 10).asUInt();
+        options.maxSize = config.get("pool_max_size", static_cast<Json::UInt>(options.minSize * 2)).asUInt();
+        if (options.maxSize < options.minSize) {
+            options.maxSize = options.minSize;
+        }
+        if (options.maxSize == 0) {
+            options.maxSize = 1;
+        }
+
+        options.acquireTimeout = std::chrono::milliseconds(config.get("pool_wait_timeout_ms", 2000).asInt());
+        options.idleTimeout = std::chrono::seconds(config.get("pool_idle_timeout_s", 300).asInt());
+        options.healthCheckInterval = std::chrono::seconds(config.get("pool_health_check_interval_s", 30).asInt());
+        options.warmupConcurrency = std::max(1u, config.get("pool_warmup_concurrency", 4).asUInt());
+
+        return options;
+    }
+
+    DBLease::DBLease(DatabasePool* ownerPool, std::unique_ptr<DatabaseHandler> leased)
+        : pool(ownerPool), handler(std::move(leased))
+    {
+    }
+
+    DBLease::~DBLease()
+    {
+        reset();
+    }
+
+    DBLease::DBLease(DBLease&& other) noexcept
+        : pool(other.pool), handler(std::move(other.handler))
+    {
+        other.pool = nullptr;
+    }
+
+    DBLease& DBLease::operator=(DBLease&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            pool = other.pool;
+            handler = std::move(other.handler);
+            other.pool = nullptr;
+        }
+        return *this;
+    }
+
+    void DBLease::reset()
+    {
+        if (pool && handler) {
+            pool->release(std::move(handler));
+        }
+        handler.reset();
+        pool = nullptr;
+    }
+
+    DatabasePool::DatabasePool(const DBConfig& config, const PoolOptions& poolOptions)
+        : dbConfig(config), options(poolOptions)
+    {
+        warmThread = std::thread([this] { warm_up(); });
+        healthThread = std::thread([this] { health_loop(); });
+    }
+
+    DatabasePool::~DatabasePool()
+    {
+        shutdown();
+    }
+
+    bool DatabasePool::wait_warm(std::chrono::steady_clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        warmCv.wait_until(lock, deadline, [this] { return !warming || closed; });
+        return !warming && !closed;
+    }
+
+    size_t& DatabasePool::thread_slice()
+    {
+        thread_local size_t slice = UNOWNED_SLICE;
+        return slice;
+    }
+
+    void DatabasePool::set_thread_slice(size_t slice)
+    {
+        thread_slice() = slice;
+    }
+
+    std::deque<DatabasePool::IdleEntry>::iterator DatabasePool::pick_idle(size_t slice)
+    {
+        // 空闲连接数不超过 maxSize，线性查找的代价可以忽略
+        if (slice != UNOWNED_SLICE) {
+            for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+                if (it->slice == slice) {
+                    return std::prev(it.base());
+                }
+            }
+        }
+        return std::prev(idle.end());
+    }
+
+    DBLease DatabasePool::lease()
+    {
+        return DBLease(this, acquire());
+    }
+
+    std::unique_ptr<DatabaseHandler> DatabasePool::acquire()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        // 请求剩余的时间不足 acquireTimeout 时以请求截止时间为准
+        const auto deadline = std::min(start + options.acquireTimeout, RequestDeadline::current());
+        bool waited = false;
+        const size_t slice = thread_slice();
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true)
+        {
+            if (closed) {
+                throw std::runtime_error("Database pool is shut down");
+            }
+
+            if (!idle.empty())
+            {
+                const auto picked = pick_idle(slice);
+                const bool foreign = slice != UNOWNED_SLICE && picked->slice != UNOWNED_SLICE && picked->slice != slice;
+                auto handler = std::move(picked->handler);
+                idle.erase(picked);
+                lock.unlock();
+
+                hits.fetch_add(1, std::memory_order_relaxed);
+                if (foreign) {
+                    sliceMisses.fetch_add(1, std::memory_order_relaxed);
+                }
+                leased.fetch_add(1, std::memory_order_relaxed);
+                if (waited) {
+                    waitTimeMicros.fetch_add(elapsed_micros(start), std::memory_order_relaxed);
+                }
+                return handler;
+            }
+
+            if (total < options.maxSize)
+            {
+                // 先占位再在锁外建连，避免握手期间阻塞其他线程
+                ++total;
+                lock.unlock();
+
+                auto handler = create_handler();
+                if (waited) {
+                    waitTimeMicros.fetch_add(elapsed_micros(start), std::memory_order_relaxed);
+                }
+                if (handler) {
+                    leased.fetch_add(1, std::memory_order_relaxed);
+                    return handler;
+                }
+
+                lock.lock();
+                --total;
+                available.notify_one();
+                throw std::runtime_error("Failed to open database connection");
+            }
+
+            if (!waited) {
+                waited = true;
+                waits.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (available.wait_until(lock, deadline) == std::cv_status::timeout
+                && idle.empty() && total >= options.maxSize)
+            {
+                lock.unlock();
+                timeouts.fetch_add(1, std::memory_order_relaxed);
+                waitTimeMicros.fetch_add(elapsed_micros(start), std::memory_order_relaxed);
+                throw PoolTimeoutError("Timed out waiting for a database connection");
+            }
+        }
+    }
+
+    void DatabasePool::release(std::unique_ptr<DatabaseHandler> handler)
+    {
+        leased.fetch_sub(1, std::memory_order_relaxed);
+
+        // 出过错的连接可能已断开或残留未结束的事务，交给后台线程确认状态，
+        // 回滚与 SELECT 1 不占用请求线程；恢复期间仍占名额，不会多建连接
+        const bool suspect = handler && (handler->is_suspect() || handler->in_transaction());
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (suspect && !closed)
+        {
+            suspects.push_back({std::move(handler), std::chrono::steady_clock::now(), thread_slice()});
+            lock.unlock();
+            healthCv.notify_all();
+            return;
+        }
+        if (!handler || !handler->is_open() || closed)
+        {
+            // 失效连接直接丢弃，释放名额给等待者重新建连
+            if (total > 0) {
+                --total;
+            }
+            lock.unlock();
+            available.notify_one();
+            return;
+        }
+
+        idle.push_back({std::move(handler), std::chrono::steady_clock::now(), thread_slice()});
+        lock.unlock();
+        available.notify_one();
+    }
+
+    void DatabasePool::shutdown()
+    {
+        std::deque<IdleEntry> drained;
+        std::deque<IdleEntry> drainedSuspects;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (closed) {
+                return;
+            }
+            closed = true;
+            drained.swap(idle);
+            drainedSuspects.swap(suspects);
+            total -= drained.size() + drainedSuspects.size();
+        }
+
+        available.notify_all();
+        healthCv.notify_all();
+        warmCv.notify_all();
+        if (warmThread.joinable()) {
+            warmThread.join();
+        }
+        if (healthThread.joinable()) {
+            healthThread.join();
+        }
+    }
+
+    PoolStats DatabasePool::stats() const
+    {
+        PoolStats snapshot;
+        snapshot.hits = hits.load(std::memory_order_relaxed);
+        snapshot.creations = creations.load(std::memory_order_relaxed);
+        snapshot.waits = waits.load(std::memory_order_relaxed);
+        snapshot.waitTimeMicros = waitTimeMicros.load(std::memory_order_relaxed);
+        snapshot.timeouts = timeouts.load(std::memory_order_relaxed);
+        snapshot.evictions = evictions.load(std::memory_order_relaxed);
+        snapshot.healthFailures = healthFailures.load(std::memory_order_relaxed);
+        snapshot.discarded = discarded.load(std::memory_order_relaxed);
+        snapshot.sliceMisses = sliceMisses.load(std::memory_order_relaxed);
+        snapshot.leased = leased.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        snapshot.idle = idle.size();
+        snapshot.recovering = suspects.size();
+        snapshot.total = total;
+        snapshot.warming = warming;
+        return snapshot;
+    }
+
+    std::unique_ptr<DatabaseHandler> DatabasePool::create_handler()
+    {
+        auto handler = std::make_unique<DatabaseHandler>(dbConfig);
+        if (!handler->is_open()) {
+            return nullptr;
+        }
+
+        creations.fetch_add(1, std::memory_order_relaxed);
+        return handler;
+    }
+
+    void DatabasePool::warm_up()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::atomic<size_t> failures {0};
+
+        // 每个线程循环建连直到凑满 minSize；建连失败的线程不再重试，
+        // 数据库不可达时启动最多耽误一次连接超时，缺口之后由健康检查补足
+        auto open_connections = [this, &failures] {
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (closed || total >= options.minSize) {
+                        return;
+                    }
+                    // 与 acquire 一样先占位，总数不会超过 maxSize
+                    ++total;
+                }
+
+                auto handler = create_handler();
+
+                std::unique_lock<std::mutex> lock(mtx);
+                if (!handler || closed) {
+                    --total;
+                    lock.unlock();
+                    available.notify_one();
+                    if (!handler) {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return;
+                }
+                idle.push_back({std::move(handler), std::chrono::steady_clock::now()});
+                lock.unlock();
+                available.notify_one();
+            }
+        };
+
+        const size_t workers = std::min(options.warmupConcurrency, options.minSize);
+        std::vector<std::thread> threads;
+        for (size_t index = 1; index < workers; ++index) {
+            threads.emplace_back(open_connections);
+        }
+        if (workers > 0) {
+            open_connections();
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        size_t idleCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            warming = false;
+            idleCount = idle.size();
+        }
+        warmCv.notify_all();
+
+        const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("DatabasePool ready, idle: " << idleCount
+            << ", min: " << options.minSize << ", max: " << options.maxSize
+            << ", failed: " << failures.load() << ", warm-up: " << elapsedMs << "ms");
+    }
+
+    void DatabasePool::health_loop()
+    {
+        auto nextCheck = std::chrono::steady_clock::now() + options.healthCheckInterval;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!closed)
+        {
+            // 有可疑连接归还时立即唤醒，否则按周期探活
+            healthCv.wait_until(lock, nextCheck, [this] { return closed || !suspects.empty(); });
+            if (closed) {
+                break;
+            }
+
+            std::deque<IdleEntry> pending;
+            pending.swap(suspects);
+            lock.unlock();
+
+            if (!pending.empty()) {
+                recover_suspects(pending);
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= nextCheck) {
+                health_check_once();
+                nextCheck = now + options.healthCheckInterval;
+            }
+            lock.lock();
+        }
+    }
+
+    void DatabasePool::recover_suspects(std::deque<IdleEntry>& pending)
+    {
+        std::vector<IdleEntry> recovered;
+        size_t dropped = 0;
+        for (auto& entry : pending)
+        {
+            if (entry.handler->recover() && entry.handler->is_open()) {
+                entry.handler->clear_suspect();
+                entry.lastUsed = std::chrono::steady_clock::now();
+                recovered.push_back(std::move(entry));
+            } else {
+                discarded.fetch_add(1, std::memory_order_relaxed);
+                ++dropped;
+            }
+        }
+        pending.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            total -= dropped;
+            if (closed) {
+                total -= recovered.size();
+            } else {
+                for (auto& entry : recovered) {
+                    idle.push_back(std::move(entry));
+                }
+            }
+        }
+        // 恢复的连接与丢弃后空出的名额都可能满足等待者
+        available.notify_all();
+    }
+
+    void DatabasePool::health_check_once()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<IdleEntry> toCheck;
+        std::vector<std::unique_ptr<DatabaseHandler>> toClose;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = idle.begin();
+            while (it != idle.end())
+            {
+                const auto idleFor = now - it->lastUsed;
+                if (idleFor >= options.idleTimeout && total > options.minSize)
+                {
+                    toClose.push_back(std::move(it->handler));
+                    --total;
+                    evictions.fetch_add(1, std::memory_order_relaxed);
+                    it = idle.erase(it);
+                }
+                else if (idleFor >= options.healthCheckInterval)
+                {
+                    // 只探测空闲了一个周期以上的连接，最近用过的连接无需检查
+                    toCheck.push_back(std::move(*it));
+                    it = idle.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        // 关闭与探活都在锁外完成，不阻塞请求路径
+        toClose.clear();
+
+        std::vector<IdleEntry> healthy;
+        size_t dropped = 0;
+        for (auto& entry : toCheck)
+        {
+            if (!entry.handler->is_connected())
+            {
+                healthFailures.fetch_add(1, std::memory_order_relaxed);
+                entry.handler->reconnect();
+                if (!entry.handler->is_open()) {
+                    ++dropped;
+                    continue;
+                }
+            }
+            healthy.push_back(std::move(entry));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            total -= dropped;
+            if (closed) {
+                total -= healthy.size();
+            } else {
+                // 放回头部，保持“尾部最近使用”的顺序
+                for (auto it = healthy.rbegin(); it != healthy.rend(); ++it) {
+                    idle.push_front(std::move(*it));
+                }
+            }
+        }
+        available.notify_all();
+
+        // 补足常驻连接
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (closed || total >= options.minSize) {
+                    break;
+                }
+                ++total;
+            }
+
+            auto handler = create_handler();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!handler || closed) {
+                --total;
+                break;
+            }
+            idle.push_back({std::move(handler), std::chrono::steady_clock::now()});
+            available.notify_one();
+        }
+    }
+
+    uint64_t DatabasePool::elapsed_micros(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - since).count();
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "db_handler.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 连接池参数
+    struct PoolOptions
+    {
+        size_t minSize = 10;
+        size_t maxSize = 20;
+        std::chrono::milliseconds acquireTimeout {2000};
+        std::chrono::seconds idleTimeout {300};
+        std::chrono::seconds healthCheckInterval {30};
+        size_t warmupConcurrency = 4;      // 启动时同时建立连接的数量
+    };
+
+    // 从 config.json 的 database 节读取连接池参数
+    PoolOptions load_pool_options(const Json::Value& config);
+
+    // 连接池统计快照
+    struct PoolStats
+    {
+        uint64_t hits = 0;             // 直接拿到空闲连接
+        uint64_t creations = 0;        // 新建连接次数
+        uint64_t waits = 0;            // 需要等待的次数
+        uint64_t waitTimeMicros = 0;   // 累计等待时间
+        uint64_t timeouts = 0;         // 等待超时次数
+        uint64_t evictions = 0;        // 空闲淘汰次数
+        uint64_t healthFailures = 0;   // 后台探活失败次数
+        uint64_t discarded = 0;        // 归还后恢复失败而丢弃的连接
+        uint64_t sliceMisses = 0;      // 本监听实例没有空闲连接，取了其他实例归还的连接
+        size_t leased = 0;             // 借出未归还
+        size_t idle = 0;
+        size_t recovering = 0;         // 归还时可疑，等待后台恢复
+        size_t total = 0;
+        bool warming = false;          // 启动预热尚未结束
+    };
+
+    // 获取连接超时
+    class PoolTimeoutError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    class DatabasePool;
+
+    // 连接租约：析构时自动归还连接池，异常路径上也不会丢失连接
+    // 执行出错的连接归还后由后台线程恢复，失败则丢弃
+    class DBLease
+    {
+    public:
+        DBLease() = default;
+        DBLease(DatabasePool* pool, std::unique_ptr<DatabaseHandler> handler);
+        ~DBLease();
+
+        DBLease(DBLease&& other) noexcept;
+        DBLease& operator=(DBLease&& other) noexcept;
+
+        DBLease(const DBLease&) = delete;
+        DBLease& operator=(const DBLease&) = delete;
+
+        DatabaseHandler* operator->() const { return handler.get(); }
+        DatabaseHandler& operator*() const { return *handler; }
+        explicit operator bool() const { return handler != nullptr; }
+
+        // 提前归还连接
+        void reset();
+
+    private:
+        DatabasePool* pool = nullptr;
+        std::unique_ptr<DatabaseHandler> handler;
+    };
+
+    // 有界、阻塞的数据库连接池
+    // 连接数不超过 maxSize，池满时在 acquireTimeout 内等待归还；
+    // 构造后由后台线程以 warmupConcurrency 的并发建立 minSize 个连接，预热期间 acquire 照常可用；
+    // 后台线程负责恢复归还时可疑的连接、探活、淘汰长时间空闲的连接并补足 minSize；
+    // 空闲连接按归还线程所属的监听实例分片，借出时优先取本分片的连接，没有时再取其他分片的
+    class DatabasePool
+    {
+    public:
+        // 未设置分片的线程（后台写入、预热等）
+        static constexpr size_t UNOWNED_SLICE = static_cast<size_t>(-1);
+
+        DatabasePool(const DBConfig& config, const PoolOptions& options);
+        ~DatabasePool();
+
+        DatabasePool(const DatabasePool&) = delete;
+        DatabasePool& operator=(const DatabasePool&) = delete;
+
+        DBLease lease();
+
+        std::unique_ptr<DatabaseHandler> acquire();
+
+        void release(std::unique_ptr<DatabaseHandler> handler);
+
+        void shutdown();
+
+        PoolStats stats() const;
+
+        // 借出未归还的连接数，不加锁，供路由挑选负载较低的节点
+        size_t leased_count() const { return leased.load(std::memory_order_relaxed); }
+
+        // 等待启动预热结束（建连失败的部分由健康检查补足），超时或连接池关闭时返回 false
+        bool wait_warm(std::chrono::steady_clock::time_point deadline);
+
+        // 当前线程所属的连接池分片，对进程内所有连接池生效，由监听实例的工作线程启动时设置
+        static void set_thread_slice(size_t slice);
+
+    private:
+        struct IdleEntry
+        {
+            std::unique_ptr<DatabaseHandler> handler;
+            std::chrono::steady_clock::time_point lastUsed;
+            size_t slice = UNOWNED_SLICE;      // 最后归还它的线程所属的分片
+        };
+
+        // 在空闲连接中挑选：尾部起第一个本分片的连接，没有则取最近归还的，调用方持有锁
+        std::deque<IdleEntry>::iterator pick_idle(size_t slice);
+
+        static size_t& thread_slice();
+
+        std::unique_ptr<DatabaseHandler> create_handler();
+
+        void warm_up();
+
+        void health_loop();
+
+        void health_check_once();
+
+        // 在后台线程上恢复可疑连接，成功的放回空闲队列
+        void recover_suspects(std::deque<IdleEntry>& pending);
+
+        static uint64_t elapsed_micros(std::chrono::steady_clock::time_point since);
+
+    private:
+        const DBConfig dbConfig;
+        const PoolOptions options;
+
+        mutable std::mutex mtx;
+        std::condition_variable available;
+        std::deque<IdleEntry> idle;     // 尾部最近归还，头部最久未用
+        std::deque<IdleEntry> suspects; // 归还时可疑、等待后台线程恢复的连接
+        size_t total = 0;               // 空闲 + 借出 + 待恢复 + 正在创建
+        bool closed = false;
+        bool warming = true;
+
+        std::condition_variable warmCv;
+        std::thread warmThread;
+
+        std::condition_variable healthCv;
+        std::thread healthThread;
+
+        std::atomic<uint64_t> hits {0};
+        std::atomic<uint64_t> creations {0};
+        std::atomic<uint64_t> waits {0};
+        std::atomic<uint64_t> waitTimeMicros {0};
+        std::atomic<uint64_t> timeouts {0};
+        std::atomic<uint64_t> evictions {0};
+        std::atomic<uint64_t> healthFailures {0};
+        std::atomic<uint64_t> discarded {0};
+        std::atomic<uint64_t> sliceMisses {0};
+        std::atomic<size_t> leased {0};
+    };
+}
@@ -0,0 +1,244 @@
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "db_router.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // 单个分片超过该数量时，写入前先清掉已过期的键
+        constexpr size_t STICKY_SWEEP_THRESHOLD = 1024;
+    }
+
+    DBNodeConfig load_db_node(const std::string& name, const Json::Value& base, const Json::Value& overrides)
+    {
+        // 未填写的字段沿用 base 中的同名字段
+        Json::Value config = base;
+        if (overrides.isObject()) {
+            for (const auto& key : overrides.getMemberNames()) {
+                config[key] = overrides[key];
+            }
+        }
+
+        DBNodeConfig node;
+        node.name = name;
+        node.config = {
+            config["host"].asString(),
+            config["port"].asInt(),
+            config["user"].asString(),
+            config["password"].asString(),
+            config["name"].asString()
+        };
+        node.pool = load_pool_options(config);
+        return node;
+    }
+
+    std::vector<DBNodeConfig> load_db_nodes(const Json::Value& config)
+    {
+        std::vector<DBNodeConfig> nodes;
+        nodes.push_back(load_db_node("primary", config, Json::Value()));
+
+        const Json::Value& replicas = config["replicas"];
+        if (replicas.isArray()) {
+            for (Json::ArrayIndex index = 0; index < replicas.size(); ++index) {
+                nodes.push_back(load_db_node("replica-" + std::to_string(index), config, replicas[index]));
+            }
+        }
+        return nodes;
+    }
+
+    RouterOptions load_router_options(const Json::Value& config)
+    {
+        RouterOptions options;
+        options.stickiness = std::chrono::milliseconds(config.get("replica_sticky_ms", 3000).asInt());
+        options.retryInterval = std::chrono::seconds(config.get("replica_retry_s", 10).asInt());
+        return options;
+    }
+
+    DatabaseRouter::DatabaseRouter(const std::vector<DBNodeConfig>& nodes, const RouterOptions& routerOptions)
+        : options(routerOptions)
+    {
+        if (nodes.empty()) {
+            throw std::invalid_argument("Database router needs a primary node");
+        }
+
+        for (size_t index = 0; index < nodes.size(); ++index)
+        {
+            const DBNodeConfig& config = nodes[index];
+            LOG_INFO("database " << config.name << ": " << config.config.user << "@" << config.config.host
+                << ":" << config.config.port << "/" << config.config.database);
+
+            auto node = std::make_unique<Node>();
+            node->name = config.name;
+            node->pool = std::make_unique<DatabasePool>(config.config, config.pool);
+            if (index == 0) {
+                primaryNode = std::move(node);
+            } else {
+                replicas.push_back(std::move(node));
+            }
+        }
+
+        LOG_INFO("Database router ready, replicas: " << replicas.size()
+            << ", sticky " << options.stickiness.count() << "ms");
+    }
+
+    DatabaseRouter::~DatabaseRouter()
+    {
+        shutdown();
+    }
+
+    DBLease DatabaseRouter::primary()
+    {
+        return primaryNode->pool->lease();
+    }
+
+    DBLease DatabaseRouter::read(const std::string& stickyKey)
+    {
+        if (replicas.empty()) {
+            return primary();
+        }
+
+        if (!stickyKey.empty() && is_sticky(stickyKey)) {
+            stickyReads.fetch_add(1, std::memory_order_relaxed);
+            primaryNode->reads.fetch_add(1, std::memory_order_relaxed);
+            return primary();
+        }
+
+        // 从轮转位置起取前两个可用从库，选借出连接较少的一个，失败再试另一个
+        const int64_t now = now_millis();
+        const size_t count = replicas.size();
+        const size_t start = cursor.fetch_add(1, std::memory_order_relaxed) % count;
+
+        Node* candidates[2] = {nullptr, nullptr};
+        size_t found = 0;
+        for (size_t offset = 0; offset < count && found < 2; ++offset) {
+            Node* node = replicas[(start + offset) % count].get();
+            if (node->pausedUntil.load(std::memory_order_relaxed) <= now) {
+                candidates[found++] = node;
+            }
+        }
+        if (found == 2 && candidates[1]->pool->leased_count() < candidates[0]->pool->leased_count()) {
+            std::swap(candidates[0], candidates[1]);
+        }
+
+        for (size_t index = 0; index < found; ++index) {
+            DBLease lease = try_replica(*candidates[index], now);
+            if (lease) {
+                return lease;
+            }
+        }
+
+        fallbacks.fetch_add(1, std::memory_order_relaxed);
+        primaryNode->reads.fetch_add(1, std::memory_order_relaxed);
+        return primary();
+    }
+
+    DBLease DatabaseRouter::try_replica(Node& node, int64_t nowMillis)
+    {
+        try {
+            DBLease lease = node.pool->lease();
+            node.reads.fetch_add(1, std::memory_order_relaxed);
+            return lease;
+        } catch (const PoolTimeoutError& e) {
+            // 从库繁忙但连接正常，不暂停
+            node.failures.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN_RATE(1, "Replica " << node.name << " busy: " << e.what());
+        } catch (const std::exception& e) {
+            node.failures.fetch_add(1, std::memory_order_relaxed);
+            node.pausedUntil.store(nowMillis + std::chrono::milliseconds(options.retryInterval).count(),
+                                   std::memory_order_relaxed);
+            LOG_WARN_RATE(1, "Replica " << node.name << " unavailable, paused for "
+                << options.retryInterval.count() << "s: " << e.what());
+        }
+        return DBLease();
+    }
+
+    void DatabaseRouter::note_write(const std::string& stickyKey)
+    {
+        if (replicas.empty() || stickyKey.empty() || options.stickiness.count() <= 0) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        StickyShard& shard = sticky[std::hash<std::string>()(stickyKey) % STICKY_SHARDS];
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        if (shard.until.size() >= STICKY_SWEEP_THRESHOLD) {
+            for (auto it = shard.until.begin(); it != shard.until.end();) {
+                it = it->second <= now ? shard.until.erase(it) : std::next(it);
+            }
+        }
+        shard.until[stickyKey] = now + options.stickiness;
+    }
+
+    bool DatabaseRouter::is_sticky(const std::string& stickyKey)
+    {
+        StickyShard& shard = sticky[std::hash<std::string>()(stickyKey) % STICKY_SHARDS];
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.until.find(stickyKey);
+        if (found == shard.until.end()) {
+            return false;
+        }
+        if (found->second <= std::chrono::steady_clock::now()) {
+            shard.until.erase(found);
+            return false;
+        }
+        return true;
+    }
+
+    bool DatabaseRouter::wait_warm(std::chrono::steady_clock::time_point deadline)
+    {
+        // 各节点的连接池在构造时已经同时开始预热，这里依次等待即可
+        bool warmed = !primaryNode || primaryNode->pool->wait_warm(deadline);
+        for (auto& node : replicas) {
+            warmed = node->pool->wait_warm(deadline) && warmed;
+        }
+        return warmed;
+    }
+
+    void DatabaseRouter::shutdown()
+    {
+        for (auto& node : replicas) {
+            node->pool->shutdown();
+        }
+        if (primaryNode) {
+            primaryNode->pool->shutdown();
+        }
+    }
+
+    RouterStats DatabaseRouter::stats() const
+    {
+        RouterStats snapshot;
+        snapshot.stickyReads = stickyReads.load(std::memory_order_relaxed);
+        snapshot.fallbacks = fallbacks.load(std::memory_order_relaxed);
+
+        const int64_t now = now_millis();
+        auto describe = [&](const Node& node, bool isPrimary) {
+            DBNodeStats stats;
+            stats.name = node.name;
+            stats.primary = isPrimary;
+            stats.available = node.pausedUntil.load(std::memory_order_relaxed) <= now;
+            stats.reads = node.reads.load(std::memory_order_relaxed);
+            stats.failures = node.failures.load(std::memory_order_relaxed);
+            stats.pool = node.pool->stats();
+            snapshot.nodes.push_back(std::move(stats));
+        };
+
+        describe(*primaryNode, true);
+        for (const auto& node : replicas) {
+            describe(*node, false);
+        }
+        return snapshot;
+    }
+
+    int64_t DatabaseRouter::now_millis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
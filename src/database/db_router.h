@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "db_pool.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 一个数据库节点：连接参数与各自的连接池参数
+    struct DBNodeConfig
+    {
+        std::string name;           // 日志与监控中的节点名：primary、replica-0 ...
+        DBConfig config;
+        PoolOptions pool;
+    };
+
+    // 读写分离参数
+    struct RouterOptions
+    {
+        // 写入后同一键的读取改走主库的时长，应大于从库的复制延迟
+        std::chrono::milliseconds stickiness {3000};
+        // 从库建连失败后暂停使用的时长，期间读取由其他从库或主库承担
+        std::chrono::seconds retryInterval {10};
+    };
+
+    // 以 base 为默认值、overrides 中的字段覆盖，得到一个节点的配置
+    DBNodeConfig load_db_node(const std::string& name, const Json::Value& base, const Json::Value& overrides);
+
+    // 从 config.json 的 database 节读取节点列表，第一个为主库
+    // 主库沿用原有的平铺字段；replicas 数组中的从库未填写的字段沿用主库的值
+    std::vector<DBNodeConfig> load_db_nodes(const Json::Value& config);
+
+    RouterOptions load_router_options(const Json::Value& config);
+
+    struct DBNodeStats
+    {
+        std::string name;
+        bool primary = false;
+        bool available = true;      // 从库是否处于暂停期之外
+        uint64_t reads = 0;         // 经 read() 借出的连接，主库只计粘滞与退回的读取
+        uint64_t failures = 0;      // 借连接失败次数
+        PoolStats pool;
+    };
+
+    struct RouterStats
+    {
+        uint64_t stickyReads = 0;   // 因刚写入而改走主库的读取
+        uint64_t fallbacks = 0;     // 没有可用从库而改走主库的读取
+        std::vector<DBNodeStats> nodes;
+    };
+
+    // 主库加若干从库，每个节点一个连接池
+    // 写入与事务使用 primary()；只读查询使用 read()，在可用从库中取两个按借出连接数择优，
+    // 从库全部不可用时退回主库。read() 的键在 note_write() 之后的 stickiness 时长内读主库，
+    // 保证写入方马上能读到自己的写入。没有配置从库时 read() 等同于 primary()。
+    class DatabaseRouter
+    {
+    public:
+        DatabaseRouter(const std::vector<DBNodeConfig>& nodes, const RouterOptions& options);
+        ~DatabaseRouter();
+
+        DatabaseRouter(const DatabaseRouter&) = delete;
+        DatabaseRouter& operator=(const DatabaseRouter&) = delete;
+
+        DBLease primary();
+
+        // stickyKey 为空表示不关心读写一致性
+        DBLease read(const std::string& stickyKey = std::string());
+
+        // 记录 stickyKey 刚发生写入
+        void note_write(const std::string& stickyKey);
+
+        size_t replica_count() const { return replicas.size(); }
+
+        // 等待全部节点的连接池预热结束，超时返回 false
+        bool wait_warm(std::chrono::steady_clock::time_point deadline);
+
+        void shutdown();
+
+        RouterStats stats() const;
+
+    private:
+        struct Node
+        {
+            std::string name;
+            std::unique_ptr<DatabasePool> pool;
+            std::atomic<int64_t> pausedUntil {0};     // steady_clock 毫秒
+            std::atomic<uint64_t> reads {0};
+            std::atomic<uint64_t> failures {0};
+        };
+
+        struct StickyShard
+        {
+            std::mutex mtx;
+            std::unordered_map<std::string, std::chrono::steady_clock::time_point> until;
+        };
+
+        static constexpr size_t STICKY_SHARDS = 16;
+
+        bool is_sticky(const std::string& stickyKey);
+
+        // 从节点借连接，失败时暂停该节点并返回空租约
+        DBLease try_replica(Node& node, int64_t nowMillis);
+
+        static int64_t now_millis();
+
+    private:
+        const RouterOptions options;
+
+        std::unique_ptr<Node> primaryNode;
+        std::vector<std::unique_ptr<Node>> replicas;
+        std::atomic<size_t> cursor {0};
+
+        std::array<StickyShard, STICKY_SHARDS> sticky;
+
+        std::atomic<uint64_t> stickyReads {0};
+        std::atomic<uint64_t> fallbacks {0};
+    };
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "json_row_writer.h"
+
+
+namespace TakeAwayPlatform
+{
+    JsonRowWriter::JsonRowWriter(mysqlx::SqlResult& sqlResult)
+        : result(sqlResult)
+    {
+        if (!result.hasData()) {
+            return;
+        }
+
+        const unsigned columnCount = result.getColumnCount();
+        columnKeys.reserve(columnCount);
+        for (unsigned index = 0; index < columnCount; ++index) {
+            std::string key;
+            write_string(result.getColumn(index).getColumnName(), key);
+            key += ':';
+            columnKeys.push_back(std::move(key));
+        }
+    }
+
+    bool JsonRowWriter::write_some(std::string& out, size_t chunkBytes)
+    {
+        if (finished) {
+            return true;
+        }
+
+        if (!started) {
+            out += '[';
+            started = true;
+        }
+
+        const size_t limit = out.size() + chunkBytes;
+        while (out.size() < limit) {
+            mysqlx::Row row = columnKeys.empty() ? mysqlx::Row() : result.fetchOne();
+            if (!row) {
+                out += ']';
+                finished = true;
+                return true;
+            }
+
+            if (rowCount > 0) {
+                out += ',';
+            }
+            write_row(row, out);
+            ++rowCount;
+        }
+        return false;
+    }
+
+    void JsonRowWriter::write_all(std::string& out)
+    {
+        while (!write_some(out, 64 * 1024)) {
+        }
+    }
+
+    void JsonRowWriter::write_row(const mysqlx::Row& row, std::string& out)
+    {
+        out += '{';
+        const unsigned columnCount = std::min<unsigned>(row.colCount(), static_cast<unsigned>(columnKeys.size()));
+        for (unsigned index = 0; index < columnCount; ++index) {
+            if (index > 0) {
+                out += ',';
+            }
+            out += columnKeys[index];
+            write_value(row[index], out);
+        }
+        out += '}';
+    }
+
+    void JsonRowWriter::write_value(const mysqlx::Value& value, std::string& out)
+    {
+        switch (value.getType())
+        {
+            case mysqlx::Value::VNULL:
+                out += "null";
+                break;
+
+            case mysqlx::Value::STRING:
+                write_string(value.get<std::string>(), out);
+                break;
+
+            case mysqlx::Value::UINT64:
+                out += std::to_string(value.get<uint64_t>());
+                break;
+
+            case mysqlx::Value::INT64:
+                out += std::to_string(value.get<int64_t>());
+                break;
+
+            case mysqlx::Value::FLOAT:
+                write_double(value.get<float>(), out);
+                break;
+
+            case mysqlx::Value::DOUBLE:
+                write_double(value.get<double>(), out);
+                break;
+
+            case mysqlx::Value::BOOL:
+                out += value.get<bool>() ? "true" : "false";
+                break;
+
+            default:
+                out += "\"UNSUPPORTED_TYPE\"";
+        }
+    }
+
+    void JsonRowWriter::write_string(const std::string& value, std::string& out)
+    {
+        static const char HEX[] = "0123456789abcdef";
+
+        out += '"';
+        for (unsigned char c : value) {
+            switch (c)
+            {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        out += "\\u00";
+                        out += HEX[c >> 4];
+                        out += HEX[c & 0x0f];
+                    } else {
+                        // UTF-8 多字节字符原样输出
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    void JsonRowWriter::write_double(double value, std::string& out)
+    {
+        if (!std::isfinite(value)) {
+            out += "null";
+            return;
+        }
+
+        // 与 jsoncpp 默认的 17 位有效数字一致
+        char buffer[32];
+        const int length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        out.append(buffer, length > 0 ? static_cast<size_t>(length) : 0);
+    }
+}
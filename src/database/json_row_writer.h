@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <mysqlx/xdevapi.h>
+
+
+namespace TakeAwayPlatform
+{
+    // 把结果集逐行写成紧凑的 JSON 数组，不经过 Json::Value 树
+    // 列名在构造时读取一次；每次 write_some 最多追加约 chunkBytes 字节，
+    // 适合配合 httplib 的分块输出边查边发。
+    // 字段类型的处理与 DatabaseHandler::parse_result 一致，NULL 输出为 null。
+    class JsonRowWriter
+    {
+    public:
+        explicit JsonRowWriter(mysqlx::SqlResult& result);
+
+        JsonRowWriter(const JsonRowWriter&) = delete;
+        JsonRowWriter& operator=(const JsonRowWriter&) = delete;
+
+        // 向 out 追加数据，全部行写完（包括结尾的 ]）后返回 true
+        bool write_some(std::string& out, size_t chunkBytes);
+
+        // 一次写完全部行
+        void write_all(std::string& out);
+
+        size_t rows() const { return rowCount; }
+
+    private:
+        void write_row(const mysqlx::Row& row, std::string& out);
+
+        static void write_value(const mysqlx::Value& value, std::string& out);
+
+        static void write_string(const std::string& value, std::string& out);
+
+        static void write_double(double value, std::string& out);
+
+    private:
+        mysqlx::SqlResult& result;
+        std::vector<std::string> columnKeys;    // 已转义并带引号和冒号的列名，例如 "name":
+        size_t rowCount = 0;
+        bool started = false;
+        bool finished = false;
+    };
+}
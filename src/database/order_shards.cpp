@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "order_shards.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // FNV-1a 64 位：结果只取决于字节内容，不同进程、不同编译器得到相同分片
+        uint64_t fnv1a(const std::string& text)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+    }
+
+    std::vector<DBNodeConfig> load_shard_nodes(const Json::Value& config)
+    {
+        std::vector<DBNodeConfig> nodes;
+        const Json::Value& shards = config["order_shards"];
+        if (shards.isArray()) {
+            for (Json::ArrayIndex index = 0; index < shards.size(); ++index) {
+                nodes.push_back(load_db_node("shard-" + std::to_string(index), config, shards[index]));
+            }
+        }
+        return nodes;
+    }
+
+    ShardOptions load_shard_options(const Json::Value& config)
+    {
+        ShardOptions options;
+        options.locationCacheSize = config.get("order_location_cache_size", 100000).asUInt();
+        options.scatterThreads = std::max(1u, config.get("order_scatter_threads", 8).asUInt());
+        options.scatterMaxQueued = config.get("order_scatter_max_queued", 64).asUInt();
+        return options;
+    }
+
+    OrderShards::OrderShards(const std::vector<DBNodeConfig>& shards, PrimaryProvider primaryProvider,
+                             const ShardOptions& shardOptions)
+        : primary(std::move(primaryProvider)), options(shardOptions)
+    {
+        for (const DBNodeConfig& shard : shards)
+        {
+            LOG_INFO("order " << shard.name << ": " << shard.config.user << "@" << shard.config.host
+                << ":" << shard.config.port << "/" << shard.config.database);
+            names.push_back(shard.name);
+            pools.push_back(std::make_unique<DatabasePool>(shard.config, shard.pool));
+        }
+
+        if (pools.size() > 1) {
+            scatterPool = std::make_unique<ThreadPool>(options.scatterThreads);
+        }
+
+        LOG_INFO("Order shards: " << shard_count() << (colocated() ? " (primary)" : "")
+            << (scatterPool ? ", scatter threads " + std::to_string(options.scatterThreads) : std::string()));
+    }
+
+    OrderShards::~OrderShards()
+    {
+        shutdown();
+    }
+
+    size_t OrderShards::shard_for_user(const std::string& userId) const
+    {
+        return pools.size() <= 1 ? 0 : static_cast<size_t>(fnv1a(userId) % pools.size());
+    }
+
+    DBLease OrderShards::lease(size_t shard)
+    {
+        if (pools.empty()) {
+            return primary();
+        }
+        return pools.at(shard)->lease();
+    }
+
+    size_t OrderShards::locate_order(const std::string& orderId)
+    {
+        if (shard_count() == 1) {
+            return 0;
+        }
+
+        {
+            LocationShard& cache = location_shard(orderId);
+            std::lock_guard<std::mutex> lock(cache.mtx);
+            auto found = cache.shards.find(orderId);
+            if (found != cache.shards.end()) {
+                locateHits.fetch_add(1, std::memory_order_relaxed);
+                return found->second;
+            }
+        }
+
+        // 其他实例创建的订单，或缓存已被清空
+        locateProbes.fetch_add(1, std::memory_order_relaxed);
+        const std::vector<bool> present = scatter([&orderId](DatabaseHandler& db, size_t) {
+            return !db.execute(StmtId::OrderExists, orderId).empty();
+        });
+        for (size_t shard = 0; shard < present.size(); ++shard) {
+            if (present[shard]) {
+                remember_order(orderId, shard);
+                return shard;
+            }
+        }
+        throw std::invalid_argument("订单不存在: " + orderId);
+    }
+
+    void OrderShards::remember_order(const std::string& orderId, size_t shard)
+    {
+        if (shard_count() == 1 || options.locationCacheSize == 0) {
+            return;
+        }
+
+        // 每个分片达到上限时整体清空，被清掉的订单在下次使用时重新查找
+        const size_t capacity = std::max<size_t>(1, options.locationCacheSize / LOCATION_SHARDS);
+        LocationShard& cache = location_shard(orderId);
+        std::lock_guard<std::mutex> lock(cache.mtx);
+        if (cache.shards.size() >= capacity) {
+            cache.shards.clear();
+        }
+        cache.shards[orderId] = static_cast<uint32_t>(shard);
+    }
+
+    OrderShards::LocationShard& OrderShards::location_shard(const std::string& orderId)
+    {
+        return locations[fnv1a(orderId) % LOCATION_SHARDS];
+    }
+
+    bool OrderShards::wait_warm(std::chrono::steady_clock::time_point deadline)
+    {
+        bool warmed = true;
+        for (auto& pool : pools) {
+            warmed = pool->wait_warm(deadline) && warmed;
+        }
+        return warmed;
+    }
+
+    void OrderShards::shutdown()
+    {
+        for (auto& pool : pools) {
+            pool->shutdown();
+        }
+    }
+
+    ShardStats OrderShards::stats() const
+    {
+        ShardStats snapshot;
+        snapshot.locateHits = locateHits.load(std::memory_order_relaxed);
+        snapshot.locateProbes = locateProbes.load(std::memory_order_relaxed);
+        snapshot.scatters = scatters.load(std::memory_order_relaxed);
+        snapshot.inlineLegs = inlineLegs.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < pools.size(); ++index) {
+            DBNodeStats node;
+            node.name = names[index];
+            node.pool = pools[index]->stats();
+            snapshot.nodes.push_back(std::move(node));
+        }
+        return snapshot;
+    }
+}
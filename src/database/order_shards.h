@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "db_pool.h"
+#include "db_router.h"
+#include "thread_pool.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 订单分片参数
+    struct ShardOptions
+    {
+        size_t locationCacheSize = 100000;     // orderId -> 分片 的缓存条数上限
+        size_t scatterThreads = 8;             // 执行各分片查询的固定线程数，多个分片时才创建
+        size_t scatterMaxQueued = 64;          // 排队的分片查询超过该值时由调用线程自己执行
+    };
+
+    // 从 config.json 的 database 节读取 order_shards 数组，字段未填写时沿用主库的值
+    std::vector<DBNodeConfig> load_shard_nodes(const Json::Value& config);
+
+    ShardOptions load_shard_options(const Json::Value& config);
+
+    struct ShardStats
+    {
+        uint64_t locateHits = 0;        // orderId 在缓存中命中
+        uint64_t locateProbes = 0;      // 未命中，到各分片查找
+        uint64_t scatters = 0;          // 在全部分片上执行的查询
+        uint64_t inlineLegs = 0;        // 线程池排队已满，由调用线程执行的分片查询
+        std::vector<DBNodeStats> nodes;
+    };
+
+    // ORDER、ORDER_ITEM、PAYMENT_RECORD、DELIVERY_INFO 按 userId 水平分片
+    // 分片号为 userId 的 FNV-1a 哈希对分片数取模，调整分片数需要迁移数据。
+    // 支付与配送只携带 orderId，先查 orderId -> 分片 的缓存，未命中时并行到各分片查找。
+    // 未配置 order_shards 时只有一个分片，连接取自主库，行为与分片前相同。
+    class OrderShards
+    {
+    public:
+        using PrimaryProvider = std::function<DBLease()>;
+
+        OrderShards(const std::vector<DBNodeConfig>& shards, PrimaryProvider primary, const ShardOptions& options);
+        ~OrderShards();
+
+        OrderShards(const OrderShards&) = delete;
+        OrderShards& operator=(const OrderShards&) = delete;
+
+        size_t shard_count() const { return pools.empty() ? 1 : pools.size(); }
+
+        // 订单表与商品表在同一个库中，可以放在同一事务里
+        bool colocated() const { return pools.empty(); }
+
+        size_t shard_for_user(const std::string& userId) const;
+
+        DBLease lease(size_t shard);
+
+        DBLease lease_for_user(const std::string& userId) { return lease(shard_for_user(userId)); }
+
+        // 返回订单所在分片；订单不存在时抛出 std::invalid_argument
+        size_t locate_order(const std::string& orderId);
+
+        // 新订单写入后记录位置，之后的支付、配送不必查找
+        void remember_order(const std::string& orderId, size_t shard);
+
+        // 在每个分片上并行执行 fn(db, shard)，结果按分片顺序返回；任一分片出错时抛出第一个异常
+        template <typename Fn>
+        auto scatter(Fn fn) -> std::vector<decltype(fn(std::declval<DatabaseHandler&>(), size_t()))>
+        {
+            using Result = decltype(fn(std::declval<DatabaseHandler&>(), size_t()));
+            scatters.fetch_add(1, std::memory_order_relaxed);
+
+            auto run = [this, &fn](size_t shard) {
+                DBLease db = lease(shard);
+                return fn(*db, shard);
+            };
+
+            // 其余分片交给固定的线程池，第 0 个分片在调用线程上执行；
+            // 线程池排队过多时调用线程依次执行剩下的分片，总并发不超过线程池大小加上请求线程数
+            const size_t count = shard_count();
+            std::vector<std::future<Result>> pending;
+            pending.reserve(count - 1);
+            for (size_t shard = 1; shard < count; ++shard) {
+                std::packaged_task<Result()> task([&run, shard] { return run(shard); });
+                pending.push_back(task.get_future());
+                if (scatterPool && scatterPool->queued() < options.scatterMaxQueued) {
+                    scatterPool->enqueue(std::move(task));
+                } else {
+                    inlineLegs.fetch_add(1, std::memory_order_relaxed);
+                    task();
+                }
+            }
+
+            std::vector<Result> results;
+            results.reserve(count);
+            std::exception_ptr error;
+            try {
+                results.push_back(run(0));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            for (auto& future : pending) {
+                try {
+                    results.push_back(future.get());
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return results;
+        }
+
+        // 等待全部分片的连接池预热结束，超时返回 false；未分片时直接返回 true
+        bool wait_warm(std::chrono::steady_clock::time_point deadline);
+
+        void shutdown();
+
+        ShardStats stats() const;
+
+    private:
+        struct LocationShard
+        {
+            std::mutex mtx;
+            std::unordered_map<std::string, uint32_t> shards;
+        };
+
+        static constexpr size_t LOCATION_SHARDS = 16;
+
+        LocationShard& location_shard(const std::string& orderId);
+
+    private:
+        const PrimaryProvider primary;
+        const ShardOptions options;
+
+        std::vector<std::string> names;
+        std::vector<std::unique_ptr<DatabasePool>> pools;
+        std::unique_ptr<ThreadPool> scatterPool;     // 先于连接池析构，排队的分片查询执行完再退出
+
+        std::array<LocationShard, LOCATION_SHARDS> locations;
+
+        std::atomic<uint64_t> locateHits {0};
+        std::atomic<uint64_t> locateProbes {0};
+        std::atomic<uint64_t> scatters {0};
+        std::atomic<uint64_t> inlineLegs {0};
+    };
+}
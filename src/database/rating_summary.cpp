@@ -0,0 +1,65 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "rating_summary.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        const char* target_type(RatingTarget target)
+        {
+            return target == RatingTarget::Dish ? "dish" : "merchant";
+        }
+    }
+
+    void add_rating(DatabaseHandler& db, RatingTarget target, const std::string& targetId, int rating)
+    {
+        if (rating < RATING_MIN || rating > RATING_MAX) {
+            throw std::invalid_argument("评分必须在 1 到 5 之间");
+        }
+
+        // 插入与更新两部分各用到 6 次评分
+        BoundValues params(RequestArena::resource());
+        params.reserve(14);
+        params.emplace_back(target_type(target));
+        params.emplace_back(targetId);
+        for (int index = 0; index < 12; ++index) {
+            params.emplace_back(rating);
+        }
+        db.update_bound(StmtId::RatingSummaryAdd, params);
+
+        if (target == RatingTarget::Dish) {
+            db.execute_update(StmtId::DishRatingRefresh, targetId);
+        }
+    }
+
+    Json::Value rating_summary(DatabaseHandler& db, RatingTarget target, const std::string& targetId)
+    {
+        const Json::Value rows = db.execute(StmtId::RatingSummaryGet, target_type(target), targetId);
+
+        Json::Value summary;
+        Json::Value histogram(Json::objectValue);
+        uint64_t count = 0;
+        double sum = 0;
+        if (!rows.empty()) {
+            const Json::Value& row = rows[0];
+            count = row["ratingCount"].asUInt64();
+            sum = row["ratingSum"].asDouble();
+            for (int star = RATING_MIN; star <= RATING_MAX; ++star) {
+                histogram[std::to_string(star)] = row["star" + std::to_string(star)].asUInt64();
+            }
+        } else {
+            for (int star = RATING_MIN; star <= RATING_MAX; ++star) {
+                histogram[std::to_string(star)] = 0;
+            }
+        }
+
+        summary["count"] = static_cast<Json::UInt64>(count);
+        summary["average"] = count > 0 ? std::round(sum / count * 100) / 100 : 0.0;
+        summary["histogram"] = histogram;
+        return summary;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "common.h"
+#include "db_handler.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 评分汇总的对象，对应 RATING_SUMMARY.targetType
+    enum class RatingTarget
+    {
+        Merchant,       // 商家评价 MERCHANT_REVIEW
+        Dish            // 菜品评论 USER_COMMENT
+    };
+
+    constexpr int RATING_MIN = 1;
+    constexpr int RATING_MAX = 5;
+
+    // 累加一条评分，菜品同时刷新 DISH.rating
+    // 调用方负责把它与评价/评论的 INSERT 放在同一事务中，评分须在 [RATING_MIN, RATING_MAX] 内
+    void add_rating(DatabaseHandler& db, RatingTarget target, const std::string& targetId, int rating);
+
+    // 主键读取汇总：{ count, average, histogram: { "1": n, ..., "5": n } }，没有评分时各项为 0
+    Json::Value rating_summary(DatabaseHandler& db, RatingTarget target, const std::string& targetId);
+}
@@ -0,0 +1,322 @@
+#include <array>
+#include <stdexcept>
+
+#include "sql_statements.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        struct StatementDef
+        {
+            StmtId id;
+            const char* name;
+            std::string sql;
+        };
+
+        #define ORDER_COLUMNS \
+            "SELECT orderId, userId, merchantId, totalPrice, status, " \
+            "DATE_FORMAT(orderTime, '%Y-%m-%d %H:%i:%s') AS orderTime, " \
+            "DATE_FORMAT(paymentTime, '%Y-%m-%d %H:%i:%s') AS paymentTime, " \
+            "DATE_FORMAT(estimatedDeliveryTime, '%Y-%m-%d %H:%i:%s') AS estimatedDeliveryTime, " \
+            "DATE_FORMAT(actualDeliveryTime, '%Y-%m-%d %H:%i:%s') AS actualDeliveryTime, " \
+            "remark, addressId FROM `ORDER` "
+
+        #define REVIEW_COLUMNS \
+            "SELECT r.reviewId, r.userId, u.username, r.rating, r.content, " \
+            "DATE_FORMAT(r.reviewTime, '%Y-%m-%d %H:%i:%s') AS reviewTime " \
+            "FROM MERCHANT_REVIEW r " \
+            "LEFT JOIN USER u ON r.userId = u.userId "
+
+        #define COMMENT_COLUMNS \
+            "SELECT r.commentId, r.userId, u.username, r.rating, r.content, " \
+            "DATE_FORMAT(r.commentTime, '%Y-%m-%d %H:%i:%s') AS commentTime " \
+            "FROM USER_COMMENT r " \
+            "LEFT JOIN USER u ON r.userId = u.userId "
+
+        // 顺序必须与 StmtId 保持一致
+        const std::array<StatementDef, STMT_COUNT> STATEMENTS = {{
+            { StmtId::MenuAll, "menu_all",
+              "SELECT * FROM DISH" },
+
+            { StmtId::DishInsertAutoId, "dish_insert_auto_id",
+              "INSERT INTO DISH "
+              "(dishId, merchantId, categoryId, name, description, price, imageUrl, stock, sales, rating, isOnSale) "
+              "VALUES (UUID(), ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::DishInsert, "dish_insert",
+              "INSERT INTO DISH "
+              "(dishId, merchantId, categoryId, name, description, price, imageUrl, stock, sales, rating, isOnSale) "
+              "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::MerchantInsert, "merchant_insert",
+              "INSERT INTO MERCHANT "
+              "(merchantId, name, description, address, phoneNumber, logoUrl, isOpen, status) "
+              "VALUES (?, ?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::CategoryInsert, "category_insert",
+              "INSERT INTO DISH_CATEGORY (categoryId, merchantId, categoryName, sortOrder) "
+              "VALUES (?, ?, ?, ?)" },
+
+            { StmtId::UserInsert, "user_insert",
+              "INSERT INTO USER (userId, username, passwordHash, email, phoneNumber, status, avatarUrl, gender) "
+              "VALUES (?, ?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::UserLogin, "user_login",
+              "SELECT userId, username, email, phoneNumber, status, avatarUrl, gender "
+              "FROM USER WHERE userId = ? AND username = ? AND passwordHash = ?" },
+
+            { StmtId::OrderInsert, "order_insert",
+              "INSERT INTO `ORDER` (orderId, userId, merchantId, totalPrice, status, orderTime, paymentTime, "
+              "estimatedDeliveryTime, actualDeliveryTime, addressId, remark) "
+              "VALUES (?, ?, ?, ?, 'PENDING_PAYMENT', ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::OrderItemInsert, "order_item_insert",
+              "INSERT INTO ORDER_ITEM (orderItemId, orderId, dishId, dishName, price, quantity) "
+              "VALUES (?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::AddressInsert, "address_insert",
+              "INSERT INTO USER_ADDRESS (addressId, userId, recipientName, phoneNumber, fullAddress, isDefault) "
+              "VALUES (?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::CommentInsert, "comment_insert",
+              "INSERT INTO USER_COMMENT (commentId, userId, dishId, rating, content, commentTime) "
+              "VALUES (?, ?, ?, ?, ?, NOW())" },
+
+            { StmtId::AdminInsert, "admin_insert",
+              "INSERT INTO ADMIN_USER (adminId, username, passwordHash, role, lastLogin) "
+              "VALUES (?, ?, ?, ?, ?)" },
+
+            { StmtId::AdminLogin, "admin_login",
+              "SELECT * FROM ADMIN_USER WHERE adminId = ? AND username = ? AND passwordHash = ?" },
+
+            { StmtId::ReviewInsert, "review_insert",
+              "INSERT INTO MERCHANT_REVIEW (reviewId, userId, merchantId, rating, content, reviewTime) "
+              "VALUES (?, ?, ?, ?, ?, ?)" },
+
+            // 评价与评论按 (时间, ID) 倒序分页，后续页以上一页最后一条为游标
+            { StmtId::MerchantReviews, "merchant_reviews",
+              REVIEW_COLUMNS
+              "WHERE r.merchantId = ? "
+              "ORDER BY r.reviewTime DESC, r.reviewId DESC LIMIT ?" },
+
+            { StmtId::MerchantDishes, "merchant_dishes",
+              "SELECT dishId, merchantId, Name, description, price, imageUrl, categoryId "
+              "FROM DISH "
+              "WHERE merchantId = ? "
+              "ORDER BY Name ASC" },
+
+            { StmtId::CategoriesByMerchant, "categories_by_merchant",
+              "SELECT categoryId, merchantId, categoryName, sortOrder "
+              "FROM DISH_CATEGORY "
+              "WHERE merchantId = ? "
+              "ORDER BY sortOrder ASC" },
+
+            { StmtId::DeliveryInsert, "delivery_insert",
+              "INSERT INTO DELIVERY_INFO (deliveryId, orderId, deliveryStatus, estimatedDeliveryTime, "
+              "actualDeliveryTime, deliveryPersonId, deliveryPersonName, deliveryPersonPhone) "
+              "VALUES (?, ?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::PaymentInsert, "payment_insert",
+              "INSERT INTO PAYMENT_RECORD (paymentId, orderId, amount, paymentTime, paymentMethod, transactionId, status) "
+              "VALUES (?, ?, ?, ?, ?, ?, ?)" },
+
+            { StmtId::MerchantSearch, "merchant_search",
+              "SELECT * FROM MERCHANT WHERE name LIKE CONCAT('%', ?, '%')" },
+
+            // 订单按 (orderTime, orderId) 倒序分页，后续页以上一页最后一条为游标
+            { StmtId::OrdersByUserFirstPage, "orders_by_user_first_page",
+              ORDER_COLUMNS
+              "WHERE userId = ? "
+              "ORDER BY orderTime DESC, orderId DESC LIMIT ?" },
+
+            { StmtId::OrdersByUserAfter, "orders_by_user_after",
+              ORDER_COLUMNS
+              "WHERE userId = ? AND (orderTime < ? OR (orderTime = ? AND orderId < ?)) "
+              "ORDER BY orderTime DESC, orderId DESC LIMIT ?" },
+
+            { StmtId::DishReviews, "dish_reviews",
+              COMMENT_COLUMNS
+              "WHERE r.dishId = ? "
+              "ORDER BY r.commentTime DESC, r.commentId DESC LIMIT ?" },
+
+            // 搜索索引全量加载
+            { StmtId::SearchMerchantsAll, "search_merchants_all",
+              "SELECT * FROM MERCHANT" },
+
+            { StmtId::SearchDishesAll, "search_dishes_all",
+              "SELECT dishId, merchantId, name, price, imageUrl, sales, rating, isOnSale FROM DISH" },
+
+            // 订单分片：按订单号定位分片，以及商家维度在各分片上分别执行的查询
+            { StmtId::OrderExists, "order_exists",
+              "SELECT 1 FROM `ORDER` WHERE orderId = ?" },
+
+            { StmtId::MerchantOrdersRecent, "merchant_orders_recent",
+              ORDER_COLUMNS
+              "WHERE merchantId = ? "
+              "ORDER BY orderTime DESC, orderId DESC LIMIT ?" },
+
+            { StmtId::MerchantOrderStats, "merchant_order_stats",
+              "SELECT COUNT(*) AS orderCount, COALESCE(SUM(totalPrice), 0) AS revenue "
+              "FROM `ORDER` WHERE merchantId = ?" },
+
+            // 延迟批量写入时评论时间由服务端在接收请求时确定
+            { StmtId::CommentInsertAt, "comment_insert_at",
+              "INSERT INTO USER_COMMENT (commentId, userId, dishId, rating, content, commentTime) "
+              "VALUES (?, ?, ?, ?, ?, ?)" },
+
+            // 启动预热菜品目录缓存的商家
+            { StmtId::OpenMerchantIds, "open_merchant_ids",
+              "SELECT merchantId FROM MERCHANT WHERE isOpen = 1 LIMIT ?" },
+
+            { StmtId::MerchantReviewsAfter, "merchant_reviews_after",
+              REVIEW_COLUMNS
+              "WHERE r.merchantId = ? AND (r.reviewTime < ? OR (r.reviewTime = ? AND r.reviewId < ?)) "
+              "ORDER BY r.reviewTime DESC, r.reviewId DESC LIMIT ?" },
+
+            { StmtId::DishReviewsAfter, "dish_reviews_after",
+              COMMENT_COLUMNS
+              "WHERE r.dishId = ? AND (r.commentTime < ? OR (r.commentTime = ? AND r.commentId < ?)) "
+              "ORDER BY r.commentTime DESC, r.commentId DESC LIMIT ?" },
+
+            // 评分汇总，与评价/评论的 INSERT 在同一事务中累加；参数为 (类型, ID) 之后评分重复 12 次
+            { StmtId::RatingSummaryAdd, "rating_summary_add",
+              "INSERT INTO RATING_SUMMARY "
+              "(targetType, targetId, ratingCount, ratingSum, star1, star2, star3, star4, star5) "
+              "VALUES (?, ?, 1, ?, ? = 1, ? = 2, ? = 3, ? = 4, ? = 5) "
+              "ON DUPLICATE KEY UPDATE ratingCount = ratingCount + 1, ratingSum = ratingSum + ?, "
+              "star1 = star1 + (? = 1), star2 = star2 + (? = 2), star3 = star3 + (? = 3), "
+              "star4 = star4 + (? = 4), star5 = star5 + (? = 5)" },
+
+            { StmtId::RatingSummaryGet, "rating_summary_get",
+              "SELECT ratingCount, ratingSum, star1, star2, star3, star4, star5 "
+              "FROM RATING_SUMMARY WHERE targetType = ? AND targetId = ?" },
+
+            // 按汇总刷新 DISH.rating，保留一位小数
+            { StmtId::DishRatingRefresh, "dish_rating_refresh",
+              "UPDATE DISH d JOIN RATING_SUMMARY s ON s.targetType = 'dish' AND s.targetId = d.dishId "
+              "SET d.rating = ROUND(s.ratingSum / s.ratingCount, 1) "
+              "WHERE d.dishId = ?" },
+
+            // 订单状态推送：订阅时发送的当前状态，同时用于核对订单归属
+            { StmtId::OrderStatusSnapshot, "order_status_snapshot",
+              "SELECT o.orderId, o.userId, o.status, p.status AS paymentStatus, d.deliveryStatus, "
+              "DATE_FORMAT(d.estimatedDeliveryTime, '%Y-%m-%d %H:%i:%s') AS estimatedDeliveryTime, "
+              "DATE_FORMAT(d.actualDeliveryTime, '%Y-%m-%d %H:%i:%s') AS actualDeliveryTime "
+              "FROM `ORDER` o "
+              "LEFT JOIN PAYMENT_RECORD p ON p.orderId = o.orderId "
+              "LEFT JOIN DELIVERY_INFO d ON d.orderId = o.orderId "
+              "WHERE o.orderId = ?" },
+        }};
+
+        #undef ORDER_COLUMNS
+        #undef REVIEW_COLUMNS
+        #undef COMMENT_COLUMNS
+
+        const StatementDef& lookup(StmtId id)
+        {
+            const size_t index = static_cast<size_t>(id);
+            if (index >= STMT_COUNT || STATEMENTS[index].id != id) {
+                throw std::out_of_range("Unknown statement id");
+            }
+            return STATEMENTS[index];
+        }
+
+        // 按 (dishId, quantity) 参数对拼出派生表并与 DISH 关联更新，setClause 为 SET 及之后的部分
+        std::string dish_stock_update_sql(size_t dishCount, const char* setClause)
+        {
+            if (dishCount == 0) {
+                throw std::invalid_argument("dishCount must be positive");
+            }
+
+            std::string result = "UPDATE DISH d JOIN (SELECT ? AS dishId, ? AS quantity";
+            for (size_t index = 1; index < dishCount; ++index) {
+                result += " UNION ALL SELECT ?, ?";
+            }
+            result += ") c ON d.dishId = c.dishId ";
+            result += setClause;
+            return result;
+        }
+    }
+
+    const std::string& statement_sql(StmtId id)
+    {
+        return lookup(id).sql;
+    }
+
+    const char* statement_name(StmtId id)
+    {
+        return lookup(id).name;
+    }
+
+    std::string multi_row_sql(StmtId id, size_t rows)
+    {
+        const std::string& sql = statement_sql(id);
+        const size_t valuesPos = sql.find("VALUES ");
+        if (valuesPos == std::string::npos || rows == 0) {
+            throw std::invalid_argument("Statement cannot be expanded to multiple rows");
+        }
+
+        const size_t tupleStart = valuesPos + 7;
+        const std::string tuple = sql.substr(tupleStart);
+
+        std::string result;
+        result.reserve(tupleStart + rows * (tuple.size() + 2));
+        result.append(sql, 0, tupleStart);
+        for (size_t row = 0; row < rows; ++row) {
+            if (row > 0) {
+                result += ", ";
+            }
+            result += tuple;
+        }
+        return result;
+    }
+
+    std::string dish_stock_deduct_sql(size_t dishCount)
+    {
+        return dish_stock_update_sql(dishCount,
+            "SET d.stock = d.stock - c.quantity, d.sales = d.sales + c.quantity "
+            "WHERE d.stock >= c.quantity");
+    }
+
+    std::string dish_stock_restore_sql(size_t dishCount)
+    {
+        return dish_stock_update_sql(dishCount,
+            "SET d.stock = d.stock + c.quantity, d.sales = d.sales - c.quantity");
+    }
+
+    std::string dish_stock_commit_sql(size_t dishCount)
+    {
+        return dish_stock_update_sql(dishCount,
+            "SET d.stock = d.stock - c.quantity, d.sales = d.sales + c.quantity");
+    }
+
+    std::string dish_stock_by_ids_sql(size_t dishCount)
+    {
+        if (dishCount == 0) {
+            throw std::invalid_argument("dishCount must be positive");
+        }
+
+        std::string result = "SELECT dishId, stock FROM DISH WHERE dishId IN (?";
+        for (size_t index = 1; index < dishCount; ++index) {
+            result += ", ?";
+        }
+        result += ")";
+        return result;
+    }
+
+    std::string order_items_by_orders_sql(size_t orderCount)
+    {
+        if (orderCount == 0) {
+            throw std::invalid_argument("orderCount must be positive");
+        }
+
+        std::string result = "SELECT orderId, dishId, dishName, price, quantity FROM ORDER_ITEM WHERE orderId IN (?";
+        for (size_t index = 1; index < orderCount; ++index) {
+            result += ", ?";
+        }
+        result += ")";
+        return result;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+
+
+namespace TakeAwayPlatform
+{
+    // 服务端使用的全部 SQL 语句编号，参数统一使用 ? 占位符
+    enum class StmtId
+    {
+        MenuAll = 0,
+        DishInsertAutoId,
+        DishInsert,
+        MerchantInsert,
+        CategoryInsert,
+        UserInsert,
+        UserLogin,
+        OrderInsert,
+        OrderItemInsert,
+        AddressInsert,
+        CommentInsert,
+        AdminInsert,
+        AdminLogin,
+        ReviewInsert,
+        MerchantReviews,
+        MerchantDishes,
+        CategoriesByMerchant,
+        DeliveryInsert,
+        PaymentInsert,
+        MerchantSearch,
+        OrdersByUserFirstPage,
+        OrdersByUserAfter,
+        DishReviews,
+        SearchMerchantsAll,
+        SearchDishesAll,
+        OrderExists,
+        MerchantOrdersRecent,
+        MerchantOrderStats,
+        CommentInsertAt,
+        OpenMerchantIds,
+        MerchantReviewsAfter,
+        DishReviewsAfter,
+        RatingSummaryAdd,
+        RatingSummaryGet,
+        DishRatingRefresh,
+        OrderStatusSnapshot,
+
+        Count
+    };
+
+    constexpr size_t STMT_COUNT = static_cast<size_t>(StmtId::Count);
+
+    // 语句文本
+    const std::string& statement_sql(StmtId id);
+
+    // 语句名称（用于日志）
+    const char* statement_name(StmtId id);
+
+    // 把单行 INSERT ... VALUES (?, ...) 扩展为 rows 行的批量插入
+    std::string multi_row_sql(StmtId id, size_t rows);
+
+    // 一条语句批量扣减库存、累加销量，参数为 (dishId, quantity) * dishCount
+    // 库存不足的菜品不会被更新，调用方需核对受影响行数
+    std::string dish_stock_deduct_sql(size_t dishCount);
+
+    // 撤销 dish_stock_deduct_sql 的扣减，参数相同；订单写入分片失败时补偿
+    std::string dish_stock_restore_sql(size_t dishCount);
+
+    // 把内存库存累计的售出量写回 DISH，参数为 (dishId, quantity) * dishCount，不检查库存
+    std::string dish_stock_commit_sql(size_t dishCount);
+
+    // 一次查询多个菜品的库存，参数为 dishCount 个 dishId
+    std::string dish_stock_by_ids_sql(size_t dishCount);
+
+    // 一次查询多个订单的订单项，参数为 orderCount 个 orderId
+    std::string order_items_by_orders_sql(size_t orderCount);
+}
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <fstream>
+
+#include "write_behind.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // 重试退避上限
+        constexpr std::chrono::milliseconds MAX_RETRY_DELAY {5000};
+
+        mysqlx::Value to_value(const Json::Value& value)
+        {
+            switch (value.type())
+            {
+                case Json::nullValue:
+                    return mysqlx::Value();
+                case Json::intValue:
+                    return mysqlx::Value(static_cast<int64_t>(value.asInt64()));
+                case Json::uintValue:
+                    return mysqlx::Value(static_cast<uint64_t>(value.asUInt64()));
+                case Json::realValue:
+                    return mysqlx::Value(value.asDouble());
+                case Json::booleanValue:
+                    return mysqlx::Value(value.asBool());
+                default:
+                    return mysqlx::Value(value.asString());
+            }
+        }
+
+        BoundValues to_values(const Json::Value& row)
+        {
+            BoundValues values;
+            values.reserve(row.size());
+            for (const auto& value : row) {
+                values.push_back(to_value(value));
+            }
+            return values;
+        }
+    }
+
+    WriteBehindOptions load_write_behind_options(const Json::Value& config)
+    {
+        WriteBehindOptions options;
+        options.enabled = config.get("enabled", false).asBool();
+        options.batchSize = std::max(1u, config.get("batch_size", 100).asUInt());
+        options.flushInterval = std::chrono::milliseconds(config.get("flush_interval_ms", 50).asInt());
+        options.maxBacklog = std::max(1u, config.get("max_backlog", 10000).asUInt());
+        options.enqueueTimeout = std::chrono::milliseconds(config.get("enqueue_timeout_ms", 100).asInt());
+        options.maxRetries = config.get("max_retries", 3).asUInt();
+        options.failedFile = config.get("failed_file", "").asString();
+        return options;
+    }
+
+    WriteBehindQueue::WriteBehindQueue(LeaseProvider provider, const WriteBehindOptions& queueOptions)
+        : leaseProvider(std::move(provider)), options(queueOptions)
+    {
+        if (options.enabled) {
+            flusher = std::thread([this] { flush_loop(); });
+        }
+    }
+
+    WriteBehindQueue::~WriteBehindQueue()
+    {
+        drain();
+    }
+
+    bool WriteBehindQueue::enqueue(StmtId id, size_t target, Json::Value row, std::function<void()> onCommitted,
+                                   RowHook withinTransaction)
+    {
+        if (!options.enabled) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        const bool admitted = space.wait_for(lock, options.enqueueTimeout, [this] {
+            return stopping || backlog < options.maxBacklog;
+        });
+        if (!admitted || stopping) {
+            lock.unlock();
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        ++backlog;
+        Batch& batch = open[BatchKey(id, target)];
+        const bool first = batch.entries.empty();
+        if (first) {
+            batch.id = id;
+            batch.target = target;
+            batch.firstAt = std::chrono::steady_clock::now();
+        }
+        batch.entries.push_back({std::move(row), std::move(onCommitted), std::move(withinTransaction)});
+        const bool full = batch.entries.size() >= options.batchSize;
+        lock.unlock();
+
+        enqueued.fetch_add(1, std::memory_order_relaxed);
+
+        // 第一行需要让后台线程按 flushInterval 定时，攒满时立即写入
+        if (first || full) {
+            wake.notify_one();
+        }
+        return true;
+    }
+
+    void WriteBehindQueue::drain()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        space.notify_all();
+
+        if (flusher.joinable())
+        {
+            flusher.join();
+
+            const WriteBehindStats snapshot = stats();
+            LOG_INFO("Write-behind drained - written: " << snapshot.written
+                << ", batches: " << snapshot.batches
+                << ", retries: " << snapshot.retries
+                << ", rejected: " << snapshot.rejected
+                << ", failed: " << snapshot.failed);
+        }
+    }
+
+    WriteBehindStats WriteBehindQueue::stats() const
+    {
+        WriteBehindStats snapshot;
+        snapshot.enqueued = enqueued.load(std::memory_order_relaxed);
+        snapshot.written = written.load(std::memory_order_relaxed);
+        snapshot.batches = batches.load(std::memory_order_relaxed);
+        snapshot.retries = retries.load(std::memory_order_relaxed);
+        snapshot.rejected = rejected.load(std::memory_order_relaxed);
+        snapshot.failed = failed.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        snapshot.backlog = backlog;
+        return snapshot;
+    }
+
+    void WriteBehindQueue::flush_loop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            std::vector<Batch> ready = take_ready(now, stopping);
+
+            if (ready.empty())
+            {
+                if (stopping && open.empty() && retrying.empty()) {
+                    break;
+                }
+
+                // 睡到最早的批次到期或重试时间
+                auto deadline = std::chrono::steady_clock::time_point::max();
+                for (const auto& entry : open) {
+                    deadline = std::min(deadline, entry.second.firstAt + options.flushInterval);
+                }
+                for (const Batch& batch : retrying) {
+                    deadline = std::min(deadline, batch.retryAt);
+                }
+
+                if (deadline == std::chrono::steady_clock::time_point::max()) {
+                    wake.wait(lock);
+                } else {
+                    wake.wait_until(lock, deadline);
+                }
+                continue;
+            }
+
+            lock.unlock();
+            for (Batch& batch : ready)
+            {
+                if (write(batch)) {
+                    continue;
+                }
+
+                if (++batch.attempts > options.maxRetries) {
+                    std::vector<const Entry*> entries;
+                    for (const Entry& entry : batch.entries) {
+                        entries.push_back(&entry);
+                    }
+                    give_up(batch, entries, "retries exhausted");
+                    continue;
+                }
+
+                // 指数退避，等数据库恢复
+                retries.fetch_add(1, std::memory_order_relaxed);
+                const auto delay = std::min<std::chrono::milliseconds>(
+                    MAX_RETRY_DELAY, options.flushInterval * (1u << std::min(batch.attempts, 10u)));
+                batch.retryAt = std::chrono::steady_clock::now() + delay;
+
+                std::lock_guard<std::mutex> retryLock(mtx);
+                retrying.push_back(std::move(batch));
+            }
+            lock.lock();
+        }
+    }
+
+    std::vector<WriteBehindQueue::Batch> WriteBehindQueue::take_ready(
+        std::chrono::steady_clock::time_point now, bool draining)
+    {
+        std::vector<Batch> ready;
+
+        for (auto it = open.begin(); it != open.end();)
+        {
+            Batch& batch = it->second;
+            if (!draining && batch.entries.size() < options.batchSize && now - batch.firstAt < options.flushInterval) {
+                ++it;
+                continue;
+            }
+
+            // 后台线程忙时一个批次可能超过 batchSize，按 batchSize 切开
+            for (size_t offset = 0; offset < batch.entries.size(); offset += options.batchSize) {
+                const size_t end = std::min(batch.entries.size(), offset + options.batchSize);
+                Batch chunk;
+                chunk.id = batch.id;
+                chunk.target = batch.target;
+                chunk.firstAt = batch.firstAt;
+                chunk.entries.assign(std::make_move_iterator(batch.entries.begin() + offset),
+                                     std::make_move_iterator(batch.entries.begin() + end));
+                ready.push_back(std::move(chunk));
+            }
+            it = open.erase(it);
+        }
+
+        for (auto it = retrying.begin(); it != retrying.end();)
+        {
+            if (it->retryAt <= now) {
+                ready.push_back(std::move(*it));
+                it = retrying.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        return ready;
+    }
+
+    bool WriteBehindQueue::write(Batch& batch)
+    {
+        const size_t rows = batch.entries.size();
+        try {
+            BoundValues params;
+            for (const Entry& entry : batch.entries) {
+                BoundValues values = to_values(entry.row);
+                params.insert(params.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+            }
+
+            const bool hooked = std::any_of(batch.entries.begin(), batch.entries.end(),
+                [](const Entry& entry) { return static_cast<bool>(entry.withinTransaction); });
+
+            DBLease db = leaseProvider(batch.target);
+            if (hooked) {
+                Transaction tx(*db);
+                db->update_sql(multi_row_sql(batch.id, rows), params);
+                for (const Entry& entry : batch.entries) {
+                    if (entry.withinTransaction) {
+                        entry.withinTransaction(*db);
+                    }
+                }
+                tx.commit();
+            } else {
+                db->update_sql(multi_row_sql(batch.id, rows), params);
+            }
+            db.reset();
+        } catch (const std::exception& e) {
+            LOG_WARN_RATE(1, "Write-behind batch " << statement_name(batch.id) << " x" << rows
+                << " failed: " << e.what());
+            if (rows == 1) {
+                return false;
+            }
+            write_rows_individually(batch);
+            return batch.entries.empty();
+        }
+
+        batches.fetch_add(1, std::memory_order_relaxed);
+        for (const Entry& entry : batch.entries) {
+            if (entry.onCommitted) {
+                entry.onCommitted();
+            }
+        }
+        finish(rows);
+        return true;
+    }
+
+    void WriteBehindQueue::write_rows_individually(Batch& batch)
+    {
+        // 逐行写入，找出被数据库拒绝的行（例如外键不存在）
+        std::vector<bool> succeeded(batch.entries.size(), false);
+        size_t successCount = 0;
+        try {
+            DBLease db = leaseProvider(batch.target);
+            const std::string sql = multi_row_sql(batch.id, 1);
+            for (size_t index = 0; index < batch.entries.size(); ++index) {
+                try {
+                    const Entry& entry = batch.entries[index];
+                    if (entry.withinTransaction) {
+                        Transaction tx(*db);
+                        db->update_sql(sql, to_values(entry.row));
+                        entry.withinTransaction(*db);
+                        tx.commit();
+                    } else {
+                        db->update_sql(sql, to_values(entry.row));
+                    }
+                    succeeded[index] = true;
+                    ++successCount;
+                } catch (const std::exception&) {
+                    // 连接出错后 DatabaseHandler 会尝试恢复，继续下一行
+                }
+            }
+        } catch (const std::exception&) {
+            // 拿不到连接：与 successCount == 0 一样按故障处理
+        }
+
+        if (successCount == 0) {
+            // 全部失败更可能是数据库故障，整批保留等待重试
+            return;
+        }
+
+        batches.fetch_add(1, std::memory_order_relaxed);
+        std::vector<const Entry*> rejectedRows;
+        for (size_t index = 0; index < batch.entries.size(); ++index) {
+            const Entry& entry = batch.entries[index];
+            if (!succeeded[index]) {
+                rejectedRows.push_back(&entry);
+            } else if (entry.onCommitted) {
+                entry.onCommitted();
+            }
+        }
+        finish(successCount);
+        if (!rejectedRows.empty()) {
+            give_up(batch, rejectedRows, "rejected by database");
+        }
+        batch.entries.clear();
+    }
+
+    void WriteBehindQueue::give_up(const Batch& batch, const std::vector<const Entry*>& entries, const std::string& reason)
+    {
+        failed.fetch_add(entries.size(), std::memory_order_relaxed);
+        LOG_ERROR("Write-behind dropped " << entries.size() << " " << statement_name(batch.id)
+            << " rows (" << reason << ")" << (options.failedFile.empty() ? "" : ", saved to " + options.failedFile));
+
+        if (!options.failedFile.empty())
+        {
+            std::lock_guard<std::mutex> lock(failedMtx);
+            std::ofstream out(options.failedFile, std::ios::app);
+            for (const Entry* entry : entries) {
+                Json::Value line;
+                line["statement"] = statement_name(batch.id);
+                line["target"] = static_cast<Json::UInt64>(batch.target);
+                line["reason"] = reason;
+                line["row"] = entry->row;
+                out << to_json(line) << '\n';
+            }
+            if (!out) {
+                LOG_ERROR("Write-behind failed to append to " << options.failedFile);
+            }
+        }
+
+        // 放弃的行同样移出积压
+        std::lock_guard<std::mutex> lock(mtx);
+        backlog -= std::min(backlog, entries.size());
+        space.notify_all();
+    }
+
+    void WriteBehindQueue::finish(size_t rows)
+    {
+        written.fetch_add(rows, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            backlog -= std::min(backlog, rows);
+        }
+        space.notify_all();
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "db_pool.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 延迟批量写入参数
+    struct WriteBehindOptions
+    {
+        bool enabled = false;
+        size_t batchSize = 100;                         // 同一语句攒够这么多行立即写入
+        std::chrono::milliseconds flushInterval {50};   // 最早一行最多等待这么久
+        size_t maxBacklog = 10000;                      // 排队加写入中的行数上限
+        std::chrono::milliseconds enqueueTimeout {100}; // 队列满时最多等待这么久
+        unsigned maxRetries = 3;                        // 整批失败后的重试次数
+        std::string failedFile;                         // 重试用尽的行追加到该文件（JSON Lines），为空只记日志
+    };
+
+    // 从 config.json 的 write_behind 节读取参数
+    WriteBehindOptions load_write_behind_options(const Json::Value& config);
+
+    struct WriteBehindStats
+    {
+        uint64_t enqueued = 0;
+        uint64_t written = 0;       // 已提交的行
+        uint64_t batches = 0;       // 执行过的批量 INSERT
+        uint64_t retries = 0;
+        uint64_t rejected = 0;      // 队列满而被拒绝的行
+        uint64_t failed = 0;        // 重试用尽或被数据库拒绝而放弃的行
+        size_t backlog = 0;
+    };
+
+    // 写后批量入库：请求线程只把行放进队列，后台线程把同一语句、同一目标库的行
+    // 合并成一条多行 INSERT（multi_row_sql）写入。
+    // 攒够 batchSize 行或最早一行等待超过 flushInterval 时写入；积压达到 maxBacklog 时
+    // enqueue 在 enqueueTimeout 内等待，仍无空位返回 false，由调用方拒绝请求。
+    // 整批失败时逐行重试以区分坏行与故障：部分行成功则其余行按坏行放弃，
+    // 全部失败则整批退避后重试。drain() 写完全部积压后才返回。
+    class WriteBehindQueue
+    {
+    public:
+        // target 由调用方定义（例如主库或某个订单分片）
+        using LeaseProvider = std::function<DBLease(size_t target)>;
+
+        WriteBehindQueue(LeaseProvider leaseProvider, const WriteBehindOptions& options);
+        ~WriteBehindQueue();
+
+        WriteBehindQueue(const WriteBehindQueue&) = delete;
+        WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+        // 与行的 INSERT 在同一事务中执行的附加写入，例如累加汇总；抛出异常则该行按失败处理
+        using RowHook = std::function<void(DatabaseHandler& db)>;
+
+        // row 为按占位符顺序排列的参数数组，null 写入 NULL
+        // onCommitted 在该行写入成功后由后台线程调用，可用于失效缓存
+        bool enqueue(StmtId id, size_t target, Json::Value row, std::function<void()> onCommitted = nullptr,
+                     RowHook withinTransaction = nullptr);
+
+        // 停止接收新行，写完积压后结束后台线程
+        void drain();
+
+        bool enabled() const { return options.enabled; }
+
+        WriteBehindStats stats() const;
+
+    private:
+        struct Entry
+        {
+            Json::Value row;
+            std::function<void()> onCommitted;
+            RowHook withinTransaction;
+        };
+
+        using BatchKey = std::pair<StmtId, size_t>;
+
+        struct Batch
+        {
+            StmtId id;
+            size_t target;
+            std::vector<Entry> entries;
+            std::chrono::steady_clock::time_point firstAt;
+            std::chrono::steady_clock::time_point retryAt;
+            unsigned attempts = 0;
+        };
+
+        void flush_loop();
+
+        // 在锁内取出到期的批次；draining 时全部取出
+        std::vector<Batch> take_ready(std::chrono::steady_clock::time_point now, bool draining);
+
+        // 调用方不持有锁；返回 false 表示整批需要重试
+        bool write(Batch& batch);
+
+        void write_rows_individually(Batch& batch);
+
+        void give_up(const Batch& batch, const std::vector<const Entry*>& entries, const std::string& reason);
+
+        void finish(size_t rows);
+
+    private:
+        const LeaseProvider leaseProvider;
+        const WriteBehindOptions options;
+
+        mutable std::mutex mtx;
+        std::condition_variable wake;           // 唤醒后台线程
+        std::condition_variable space;          // 积压减少，唤醒等待入队的请求
+        std::map<BatchKey, Batch> open;
+        std::deque<Batch> retrying;
+        size_t backlog = 0;
+        bool stopping = false;
+
+        std::mutex failedMtx;                   // 串行写 failedFile
+
+        std::thread flusher;
+
+        std::atomic<uint64_t> enqueued {0};
+        std::atomic<uint64_t> written {0};
+        std::atomic<uint64_t> batches {0};
+        std::atomic<uint64_t> retries {0};
+        std::atomic<uint64_t> rejected {0};
+        std::atomic<uint64_t> failed {0};
+    };
+}
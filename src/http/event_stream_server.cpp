@@ -0,0 +1,795 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "event_stream_server.h"
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // epoll_event.data.u64 中的保留值，其余为连接号
+        constexpr uint64_t LISTEN_TAG = 0;
+        constexpr uint64_t WAKE_TAG = 1;
+        constexpr uint64_t FIRST_CONNECTION = 2;
+
+        constexpr size_t MAX_REQUEST_BYTES = 8192;
+        constexpr int MAX_EVENTS = 256;
+
+#ifdef EPOLLEXCLUSIVE
+        constexpr uint32_t LISTEN_EVENTS = EPOLLIN | EPOLLEXCLUSIVE;
+#else
+        constexpr uint32_t LISTEN_EVENTS = EPOLLIN;
+#endif
+
+        const char* reason_phrase(int status)
+        {
+            switch (status)
+            {
+                case 400: return "Bad Request";
+                case 401: return "Unauthorized";
+                case 403: return "Forbidden";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 408: return "Request Timeout";
+                case 431: return "Request Header Fields Too Large";
+                case 503: return "Service Unavailable";
+                default: return "Internal Server Error";
+            }
+        }
+
+        std::string error_response(int status, const std::string& message)
+        {
+            Json::Value body;
+            body["status"] = "fail";
+            body["message"] = message;
+            const std::string content = to_json(body);
+            return "HTTP/1.1 " + std::to_string(status) + " " + reason_phrase(status) + "\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: " + std::to_string(content.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + content;
+        }
+
+        std::string event_frame(uint64_t id, const std::string& type, const std::string& data)
+        {
+            std::string frame;
+            frame.reserve(data.size() + type.size() + 40);
+            if (id != 0) {
+                frame += "id: " + std::to_string(id) + "\n";
+            }
+            frame += "event: " + type + "\n";
+            frame += "data: " + data + "\n\n";
+            return frame;
+        }
+
+        int hex_value(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        std::string url_decode(const std::string& text)
+        {
+            std::string out;
+            out.reserve(text.size());
+            for (size_t index = 0; index < text.size(); ++index) {
+                const char c = text[index];
+                if (c == '+') {
+                    out += ' ';
+                } else if (c == '%' && index + 2 < text.size()
+                           && hex_value(text[index + 1]) >= 0 && hex_value(text[index + 2]) >= 0) {
+                    out += static_cast<char>(hex_value(text[index + 1]) * 16 + hex_value(text[index + 2]));
+                    index += 2;
+                } else {
+                    out += c;
+                }
+            }
+            return out;
+        }
+
+        std::string query_param(const std::string& query, const std::string& key)
+        {
+            size_t start = 0;
+            while (start <= query.size()) {
+                size_t end = query.find('&', start);
+                if (end == std::string::npos) {
+                    end = query.size();
+                }
+                const size_t equals = query.find('=', start);
+                if (equals != std::string::npos && equals < end && query.compare(start, equals - start, key) == 0) {
+                    return url_decode(query.substr(equals + 1, end - equals - 1));
+                }
+                start = end + 1;
+            }
+            return "";
+        }
+
+        // 请求头名称不区分大小写
+        std::string header_value(const std::string& head, const std::string& name)
+        {
+            size_t start = head.find("\r\n");
+            while (start != std::string::npos && start + 2 < head.size()) {
+                start += 2;
+                const size_t end = head.find("\r\n", start);
+                const size_t colon = head.find(':', start);
+                if (colon != std::string::npos && (end == std::string::npos || colon < end)
+                    && colon - start == name.size()
+                    && std::equal(name.begin(), name.end(), head.begin() + start,
+                        [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) {
+                    size_t valueStart = colon + 1;
+                    while (valueStart < head.size() && head[valueStart] == ' ') {
+                        ++valueStart;
+                    }
+                    return head.substr(valueStart, (end == std::string::npos ? head.size() : end) - valueStart);
+                }
+                start = end;
+            }
+            return "";
+        }
+    }
+
+    struct EventStreamServer::Connection
+    {
+        enum class State
+        {
+            Reading,        // 等待请求头
+            Opening,        // 已订阅，等待校验结果
+            Streaming,
+            Closing         // 发完错误响应后关闭
+        };
+
+        int fd = -1;
+        State state = State::Reading;
+        std::string in;
+        std::string out;
+        size_t outOffset = 0;
+        bool writable = false;      // 已注册 EPOLLOUT
+        std::chrono::steady_clock::time_point acceptedAt;
+        std::chrono::steady_clock::time_point openingAt;
+        std::string orderId;
+        uint64_t subscriptionId = 0;
+        std::vector<std::shared_ptr<const OrderEvent>> early;  // 校验完成前到达的事件
+    };
+
+    struct EventStreamServer::Loop
+    {
+        struct Task
+        {
+            uint64_t connectionId;
+            std::shared_ptr<const OrderEvent> event;
+            std::shared_ptr<const StreamOpenResult> opened;
+        };
+
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::thread thread;
+
+        // 其他线程投递给本循环的任务
+        std::mutex mtx;
+        std::vector<Task> tasks;
+
+        // 以下只在循环线程中访问
+        std::unordered_map<uint64_t, Connection> connections;
+        uint64_t nextConnection = FIRST_CONNECTION;
+
+        void post(Task task)
+        {
+            bool first = false;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                first = tasks.empty();
+                tasks.push_back(std::move(task));
+            }
+            if (first) {
+                const uint64_t one = 1;
+                ssize_t written = ::write(wakeFd, &one, sizeof(one));
+                (void)written;
+            }
+        }
+    };
+
+    EventStreamOptions load_event_stream_options(const Json::Value& config)
+    {
+        EventStreamOptions options;
+        options.enabled = config.get("enabled", false).asBool();
+        options.host = config.get("host", "0.0.0.0").asString();
+        options.port = config.get("port", 8081).asInt();
+        options.loopThreads = std::max(1u, config.get("loop_threads", 2).asUInt());
+        options.openThreads = std::max(1u, config.get("open_threads", 2).asUInt());
+        options.maxStreams = std::max(1u, config.get("max_streams", 50000).asUInt());
+        options.maxBufferedBytes = std::max(1024u, config.get("max_buffered_bytes", 65536).asUInt());
+        options.heartbeat = std::chrono::seconds(std::max(1, config.get("heartbeat_s", 15).asInt()));
+        options.requestTimeout = std::chrono::seconds(std::max(1, config.get("request_timeout_s", 10).asInt()));
+        options.openTimeout = std::chrono::seconds(std::max(1, config.get("open_timeout_s", 10).asInt()));
+        options.maxOpenJobs = std::max(1u, config.get("max_open_jobs", 1024).asUInt());
+        options.maxEarlyEvents = std::max(1u, config.get("max_early_events", 64).asUInt());
+        return options;
+    }
+
+    EventStreamServer::EventStreamServer(OrderEventBus& eventBus, Opener streamOpener, const EventStreamOptions& streamOptions)
+        : bus(eventBus), opener(std::move(streamOpener)), options(streamOptions)
+    {
+    }
+
+    EventStreamServer::~EventStreamServer()
+    {
+        stop();
+        for (auto& loop : loops) {
+            if (loop->epollFd >= 0) {
+                ::close(loop->epollFd);
+            }
+            if (loop->wakeFd >= 0) {
+                ::close(loop->wakeFd);
+            }
+        }
+    }
+
+    bool EventStreamServer::start()
+    {
+        if (!options.enabled || started) {
+            return started;
+        }
+
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+            LOG_ERROR("Event stream: invalid host " << options.host);
+            return false;
+        }
+
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        const int on = 1;
+        if (listenFd < 0
+            || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+            || bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || listen(listenFd, SOMAXCONN) != 0) {
+            LOG_ERROR("Event stream: cannot listen on " << options.host << ":" << options.port << ": " << std::strerror(errno));
+            if (listenFd >= 0) {
+                ::close(listenFd);
+                listenFd = -1;
+            }
+            return false;
+        }
+
+        stopping = false;
+        for (size_t index = 0; index < options.loopThreads; ++index)
+        {
+            auto loop = std::make_unique<Loop>();
+            loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            epoll_event listenEvent {};
+            listenEvent.events = LISTEN_EVENTS;
+            listenEvent.data.u64 = LISTEN_TAG;
+            epoll_event wakeEvent {};
+            wakeEvent.events = EPOLLIN;
+            wakeEvent.data.u64 = WAKE_TAG;
+            if (loop->epollFd < 0 || loop->wakeFd < 0
+                || epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) != 0
+                || epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &wakeEvent) != 0) {
+                LOG_ERROR("Event stream: cannot create event loop: " << std::strerror(errno));
+                loops.push_back(std::move(loop));
+                started = true;
+                stop();
+                return false;
+            }
+            loops.push_back(std::move(loop));
+        }
+
+        for (auto& loop : loops) {
+            Loop* target = loop.get();
+            loop->thread = std::thread([this, target] { run_loop(*target); });
+        }
+        for (size_t index = 0; index < options.openThreads; ++index) {
+            openers.emplace_back([this] { open_loop(); });
+        }
+
+        started = true;
+        LOG_INFO("Event stream listening on " << options.host << ":" << options.port
+            << " (" << options.loopThreads << " loops, max " << options.maxStreams << " streams)");
+        return true;
+    }
+
+    void EventStreamServer::stop()
+    {
+        if (!started) {
+            return;
+        }
+        started = false;
+
+        {
+            // 在锁内设置，open_loop 不会错过通知
+            std::lock_guard<std::mutex> lock(openMtx);
+            stopping = true;
+        }
+        for (auto& loop : loops) {
+            if (loop->wakeFd >= 0) {
+                const uint64_t one = 1;
+                ssize_t written = ::write(loop->wakeFd, &one, sizeof(one));
+                (void)written;
+            }
+        }
+        for (auto& loop : loops) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+
+        openCv.notify_all();
+        for (std::thread& thread : openers) {
+            thread.join();
+        }
+        openers.clear();
+        openJobs.clear();
+
+        // 循环线程已结束，在这里关闭剩余连接并取消订阅
+        for (auto& loop : loops) {
+            std::vector<uint64_t> ids;
+            ids.reserve(loop->connections.size());
+            for (const auto& entry : loop->connections) {
+                ids.push_back(entry.first);
+            }
+            for (uint64_t id : ids) {
+                close_connection(*loop, id);
+            }
+        }
+
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+        }
+        LOG_INFO("Event stream stopped - accepted: " << acceptedCount.load()
+            << ", opened: " << openedCount.load() << ", slow closed: " << slowClosedCount.load());
+    }
+
+    EventStreamStats EventStreamServer::stats() const
+    {
+        EventStreamStats snapshot;
+        snapshot.accepted = acceptedCount.load(std::memory_order_relaxed);
+        snapshot.opened = openedCount.load(std::memory_order_relaxed);
+        snapshot.rejected = rejectedCount.load(std::memory_order_relaxed);
+        snapshot.slowClosed = slowClosedCount.load(std::memory_order_relaxed);
+        snapshot.openRejected = openRejectedCount.load(std::memory_order_relaxed);
+        snapshot.openTimedOut = openTimedOutCount.load(std::memory_order_relaxed);
+        snapshot.earlyOverflow = earlyOverflowCount.load(std::memory_order_relaxed);
+        snapshot.streams = streamCount.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void EventStreamServer::run_loop(Loop& loop)
+    {
+        epoll_event events[MAX_EVENTS];
+        auto lastSweep = std::chrono::steady_clock::now();
+        auto nextHeartbeat = lastSweep + options.heartbeat;
+
+        while (!stopping)
+        {
+            const int count = epoll_wait(loop.epollFd, events, MAX_EVENTS, 1000);
+            if (count < 0 && errno != EINTR) {
+                LOG_ERROR_RATE(1, "Event stream: epoll_wait failed: " << std::strerror(errno));
+            }
+
+            for (int index = 0; index < count; ++index)
+            {
+                const uint64_t tag = events[index].data.u64;
+                const uint32_t flags = events[index].events;
+                if (tag == LISTEN_TAG) {
+                    accept_connections(loop);
+                    continue;
+                }
+                if (tag == WAKE_TAG) {
+                    uint64_t value = 0;
+                    ssize_t received = ::read(loop.wakeFd, &value, sizeof(value));
+                    (void)received;
+                    run_tasks(loop);
+                    continue;
+                }
+
+                auto found = loop.connections.find(tag);
+                if (found == loop.connections.end()) {
+                    continue;
+                }
+                if (flags & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(loop, tag);
+                    continue;
+                }
+                if ((flags & EPOLLOUT) && !flush(loop, tag, found->second)) {
+                    continue;
+                }
+                if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                    on_readable(loop, tag);
+                }
+            }
+
+            // 每秒检查一次请求头与校验超时，按间隔发送心跳
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastSweep >= std::chrono::seconds(1)) {
+                const bool heartbeat = now >= nextHeartbeat;
+                if (heartbeat) {
+                    nextHeartbeat = now + options.heartbeat;
+                }
+                sweep(loop, now, heartbeat);
+                lastSweep = now;
+            }
+        }
+    }
+
+    void EventStreamServer::open_loop()
+    {
+        while (true)
+        {
+            OpenJob job;
+            {
+                std::unique_lock<std::mutex> lock(openMtx);
+                openCv.wait(lock, [this] { return stopping || !openJobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = std::move(openJobs.front());
+                openJobs.pop_front();
+            }
+
+            // 排队已超过校验时限的连接会被 sweep 关闭，不再为它查库
+            if (std::chrono::steady_clock::now() - job.queuedAt >= options.openTimeout) {
+                continue;
+            }
+
+            auto result = std::make_shared<StreamOpenResult>();
+            try {
+                *result = opener(job.request);
+            } catch (const std::exception& e) {
+                result->status = 500;
+                result->message = e.what();
+            }
+            job.loop->post({job.connectionId, nullptr, std::move(result)});
+        }
+    }
+
+    void EventStreamServer::accept_connections(Loop& loop)
+    {
+        while (true)
+        {
+            const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    LOG_WARN_RATE(1, "Event stream: accept failed: " << std::strerror(errno));
+                }
+                return;
+            }
+
+            if (streamCount.load(std::memory_order_relaxed) >= options.maxStreams) {
+                rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                const std::string response = error_response(503, "推送连接数已满，请稍后重试");
+                ssize_t written = ::send(fd, response.data(), response.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                (void)written;
+                ::close(fd);
+                continue;
+            }
+
+            const int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+            const uint64_t id = loop.nextConnection++;
+            epoll_event event {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.u64 = id;
+            if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+
+            Connection& connection = loop.connections[id];
+            connection.fd = fd;
+            connection.acceptedAt = std::chrono::steady_clock::now();
+            streamCount.fetch_add(1, std::memory_order_relaxed);
+            acceptedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void EventStreamServer::on_readable(Loop& loop, uint64_t connectionId)
+    {
+        char buffer[4096];
+        while (true)
+        {
+            auto found = loop.connections.find(connectionId);
+            if (found == loop.connections.end()) {
+                return;
+            }
+            Connection& connection = found->second;
+
+            const ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received == 0) {
+                close_connection(loop, connectionId);
+                return;
+            }
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    close_connection(loop, connectionId);
+                }
+                return;
+            }
+
+            // 请求头之后客户端发来的数据直接丢弃
+            if (connection.state != Connection::State::Reading) {
+                continue;
+            }
+
+            connection.in.append(buffer, static_cast<size_t>(received));
+            if (connection.in.find("\r\n\r\n") != std::string::npos) {
+                on_request(loop, connectionId, connection);
+            } else if (connection.in.size() > MAX_REQUEST_BYTES) {
+                connection.state = Connection::State::Closing;
+                send(loop, connectionId, connection, error_response(431, "请求头过长"));
+                return;
+            }
+        }
+    }
+
+    void EventStreamServer::on_request(Loop& loop, uint64_t connectionId, Connection& connection)
+    {
+        const std::string head = connection.in.substr(0, connection.in.find("\r\n\r\n") + 2);
+        connection.in.clear();
+        connection.state = Connection::State::Closing;
+
+        // 请求行：GET /order/events?orderId=... HTTP/1.1
+        const size_t methodEnd = head.find(' ');
+        const size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : head.find(' ', methodEnd + 1);
+        if (targetEnd == std::string::npos) {
+            send(loop, connectionId, connection, error_response(400, "无效的请求"));
+            return;
+        }
+        if (head.compare(0, methodEnd, "GET") != 0) {
+            send(loop, connectionId, connection, error_response(405, "只支持 GET"));
+            return;
+        }
+
+        const std::string target = head.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        const size_t question = target.find('?');
+        const std::string path = target.substr(0, question);
+        const std::string query = question == std::string::npos ? std::string() : target.substr(question + 1);
+        if (path != "/order/events") {
+            send(loop, connectionId, connection, error_response(404, "接口不存在"));
+            return;
+        }
+
+        StreamRequest request;
+        request.orderId = query_param(query, "orderId");
+        if (request.orderId.empty()) {
+            send(loop, connectionId, connection, error_response(400, "缺少 orderId"));
+            return;
+        }
+        const std::string authorization = header_value(head, "Authorization");
+        const std::string bearer = "Bearer ";
+        request.token = authorization.compare(0, bearer.size(), bearer) == 0
+            ? authorization.substr(bearer.size()) : query_param(query, "token");
+
+        // 校验会查库，队列满时直接拒绝，不让排队无限增长；各循环线程同时入队时最多超出几个
+        bool full = false;
+        {
+            std::lock_guard<std::mutex> lock(openMtx);
+            full = openJobs.size() >= options.maxOpenJobs;
+        }
+        if (full) {
+            openRejectedCount.fetch_add(1, std::memory_order_relaxed);
+            send(loop, connectionId, connection, error_response(503, "推送服务繁忙，请稍后重试"));
+            return;
+        }
+
+        // 先订阅再校验，校验期间的事件缓存在连接上
+        Loop* owner = &loop;
+        const auto now = std::chrono::steady_clock::now();
+        connection.state = Connection::State::Opening;
+        connection.openingAt = now;
+        connection.orderId = request.orderId;
+        connection.subscriptionId = bus.subscribe(request.orderId,
+            [owner, connectionId](const std::shared_ptr<const OrderEvent>& event) {
+                owner->post({connectionId, event, nullptr});
+            });
+
+        {
+            std::lock_guard<std::mutex> lock(openMtx);
+            openJobs.push_back({&loop, connectionId, std::move(request), now});
+        }
+        openCv.notify_one();
+    }
+
+    void EventStreamServer::run_tasks(Loop& loop)
+    {
+        std::vector<Loop::Task> tasks;
+        {
+            std::lock_guard<std::mutex> lock(loop.mtx);
+            tasks.swap(loop.tasks);
+        }
+
+        for (const Loop::Task& task : tasks)
+        {
+            if (task.opened) {
+                on_opened(loop, task.connectionId, *task.opened);
+                continue;
+            }
+
+            auto found = loop.connections.find(task.connectionId);
+            if (found == loop.connections.end()) {
+                continue;
+            }
+            Connection& connection = found->second;
+            if (connection.state == Connection::State::Opening) {
+                if (connection.early.size() >= options.maxEarlyEvents) {
+                    // 丢弃事件会让客户端状态出错，断开后客户端重连会拿到新的快照
+                    earlyOverflowCount.fetch_add(1, std::memory_order_relaxed);
+                    abort_opening(loop, task.connectionId, connection, 503, "订单状态变化过快，请重新连接");
+                    continue;
+                }
+                connection.early.push_back(task.event);
+            } else if (connection.state == Connection::State::Streaming) {
+                send(loop, task.connectionId, connection, event_frame(task.event->id, task.event->type, task.event->data));
+            }
+        }
+    }
+
+    void EventStreamServer::on_opened(Loop& loop, uint64_t connectionId, const StreamOpenResult& result)
+    {
+        auto found = loop.connections.find(connectionId);
+        if (found == loop.connections.end()) {
+            return;
+        }
+        Connection& connection = found->second;
+        if (connection.state != Connection::State::Opening) {
+            // 已因超时或缓存事件过多关闭
+            return;
+        }
+
+        if (result.status != 200) {
+            abort_opening(loop, connectionId, connection, result.status, result.message);
+            return;
+        }
+
+        std::string data =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: close\r\n"
+            "X-Accel-Buffering: no\r\n\r\n"
+            "retry: 3000\n\n";
+        data += event_frame(0, "snapshot", to_json(result.snapshot));
+        for (const auto& event : connection.early) {
+            data += event_frame(event->id, event->type, event->data);
+        }
+        connection.early.clear();
+        connection.state = Connection::State::Streaming;
+        openedCount.fetch_add(1, std::memory_order_relaxed);
+        send(loop, connectionId, connection, data);
+    }
+
+    void EventStreamServer::abort_opening(Loop& loop, uint64_t connectionId, Connection& connection,
+                                          int status, const std::string& message)
+    {
+        bus.unsubscribe(connection.orderId, connection.subscriptionId);
+        connection.subscriptionId = 0;
+        connection.early.clear();
+        connection.state = Connection::State::Closing;
+        send(loop, connectionId, connection, error_response(status, message));
+    }
+
+    bool EventStreamServer::send(Loop& loop, uint64_t connectionId, Connection& connection, const std::string& data)
+    {
+        if (connection.out.size() - connection.outOffset + data.size() > options.maxBufferedBytes
+            && connection.state == Connection::State::Streaming) {
+            slowClosedCount.fetch_add(1, std::memory_order_relaxed);
+            close_connection(loop, connectionId);
+            return false;
+        }
+        connection.out += data;
+        return flush(loop, connectionId, connection);
+    }
+
+    bool EventStreamServer::flush(Loop& loop, uint64_t connectionId, Connection& connection)
+    {
+        while (connection.outOffset < connection.out.size())
+        {
+            const ssize_t written = ::send(connection.fd, connection.out.data() + connection.outOffset,
+                                           connection.out.size() - connection.outOffset, MSG_NOSIGNAL);
+            if (written > 0) {
+                connection.outOffset += static_cast<size_t>(written);
+                continue;
+            }
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // 内核缓冲区已满，等可写时继续
+                if (!connection.writable) {
+                    epoll_event event {};
+                    event.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+                    event.data.u64 = connectionId;
+                    epoll_ctl(loop.epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+                    connection.writable = true;
+                }
+                return true;
+            }
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            close_connection(loop, connectionId);
+            return false;
+        }
+
+        connection.out.clear();
+        connection.outOffset = 0;
+        if (connection.writable) {
+            epoll_event event {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.u64 = connectionId;
+            epoll_ctl(loop.epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.writable = false;
+        }
+        if (connection.state == Connection::State::Closing) {
+            close_connection(loop, connectionId);
+            return false;
+        }
+        return true;
+    }
+
+    void EventStreamServer::close_connection(Loop& loop, uint64_t connectionId)
+    {
+        auto found = loop.connections.find(connectionId);
+        if (found == loop.connections.end()) {
+            return;
+        }
+
+        Connection& connection = found->second;
+        if (connection.subscriptionId != 0) {
+            bus.unsubscribe(connection.orderId, connection.subscriptionId);
+        }
+        epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        loop.connections.erase(found);
+        streamCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void EventStreamServer::sweep(Loop& loop, std::chrono::steady_clock::time_point now, bool heartbeat)
+    {
+        std::vector<uint64_t> timedOut;
+        std::vector<uint64_t> openTimedOut;
+        std::vector<uint64_t> streaming;
+        for (const auto& entry : loop.connections) {
+            const Connection& connection = entry.second;
+            if (connection.state == Connection::State::Reading && now - connection.acceptedAt >= options.requestTimeout) {
+                timedOut.push_back(entry.first);
+            } else if (connection.state == Connection::State::Opening && now - connection.openingAt >= options.openTimeout) {
+                openTimedOut.push_back(entry.first);
+            } else if (heartbeat && connection.state == Connection::State::Streaming) {
+                streaming.push_back(entry.first);
+            }
+        }
+
+        for (uint64_t id : timedOut) {
+            Connection& connection = loop.connections[id];
+            connection.state = Connection::State::Closing;
+            send(loop, id, connection, error_response(408, "请求超时"));
+        }
+        for (uint64_t id : openTimedOut) {
+            openTimedOutCount.fetch_add(1, std::memory_order_relaxed);
+            abort_opening(loop, id, loop.connections[id], 503, "订阅校验超时，请稍后重试");
+        }
+        for (uint64_t id : streaming) {
+            auto found = loop.connections.find(id);
+            if (found != loop.connections.end()) {
+                send(loop, id, found->second, ": ping\n\n");
+            }
+        }
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "order_events.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 订单状态推送（SSE）参数
+    struct EventStreamOptions
+    {
+        bool enabled = false;
+        std::string host = "0.0.0.0";
+        int port = 8081;
+        size_t loopThreads = 2;                     // epoll 事件循环线程
+        size_t openThreads = 2;                     // 执行订阅校验（会查库）的线程
+        size_t maxStreams = 50000;                  // 同时打开的连接上限，超出返回 503
+        size_t maxBufferedBytes = 64 * 1024;        // 单个连接未发出的字节上限，超出按慢客户端断开
+        std::chrono::seconds heartbeat {15};        // 心跳注释行间隔，避免中间设备断开空闲连接
+        std::chrono::seconds requestTimeout {10};   // 连接建立后发完请求头的时限
+        std::chrono::seconds openTimeout {10};      // 请求头之后等待校验结果的时限
+        size_t maxOpenJobs = 1024;                  // 排队等待校验的连接上限，超出返回 503
+        size_t maxEarlyEvents = 64;                 // 校验完成前单个连接缓存的事件上限，超出断开让客户端重连
+    };
+
+    // 从 config.json 的 events 节读取参数
+    EventStreamOptions load_event_stream_options(const Json::Value& config);
+
+    // GET /order/events?orderId=... 的订阅请求
+    struct StreamRequest
+    {
+        std::string orderId;
+        std::string token;          // Authorization: Bearer，或 URL 参数 token（浏览器 EventSource 不能设置请求头）
+    };
+
+    struct StreamOpenResult
+    {
+        int status = 200;           // 非 200 时以该状态码和 message 响应并关闭连接
+        std::string message;
+        Json::Value snapshot;       // 200 时作为第一个事件（snapshot）发送的当前状态
+    };
+
+    struct EventStreamStats
+    {
+        uint64_t accepted = 0;
+        uint64_t opened = 0;        // 通过校验开始推送的连接
+        uint64_t rejected = 0;      // 超过 maxStreams 被拒绝
+        uint64_t slowClosed = 0;    // 未发出的数据超过 maxBufferedBytes 被断开
+        uint64_t openRejected = 0;  // 校验队列超过 maxOpenJobs 被拒绝
+        uint64_t openTimedOut = 0;  // 超过 openTimeout 仍未完成校验
+        uint64_t earlyOverflow = 0; // 校验期间缓存的事件超过 maxEarlyEvents 被断开
+        size_t streams = 0;         // 当前打开的连接
+    };
+
+    // 订单状态推送服务：独立端口上的 Server-Sent Events
+    // 少量 epoll 线程以非阻塞方式持有全部连接，空闲的订阅不占用 httplib 工作线程。
+    // 解析出订单号后立即在 OrderEventBus 上订阅，再把校验交给 openThreads：
+    // 校验期间到达的事件先缓存，校验通过后依次发送当前状态与这些事件，订阅与读取状态之间不会漏掉变化。
+    // 响应不带长度，以连接关闭结束；客户端断开后取消订阅。
+    class EventStreamServer
+    {
+    public:
+        // 在 openThreads 上调用，可以阻塞；抛出异常按 500 处理
+        using Opener = std::function<StreamOpenResult(const StreamRequest& request)>;
+
+        EventStreamServer(OrderEventBus& bus, Opener opener, const EventStreamOptions& options);
+        ~EventStreamServer();
+
+        EventStreamServer(const EventStreamServer&) = delete;
+        EventStreamServer& operator=(const EventStreamServer&) = delete;
+
+        bool enabled() const { return options.enabled; }
+
+        // 绑定端口并启动线程，失败返回 false
+        bool start();
+
+        // 关闭全部连接并结束线程；之后仍可能收到发布，只会被丢弃
+        void stop();
+
+        EventStreamStats stats() const;
+
+    private:
+        struct Connection;
+        struct Loop;
+
+        struct OpenJob
+        {
+            Loop* loop;
+            uint64_t connectionId;
+            StreamRequest request;
+            std::chrono::steady_clock::time_point queuedAt;
+        };
+
+        void run_loop(Loop& loop);
+
+        void open_loop();
+
+        void accept_connections(Loop& loop);
+
+        void on_readable(Loop& loop, uint64_t connectionId);
+
+        void on_request(Loop& loop, uint64_t connectionId, Connection& connection);
+
+        void run_tasks(Loop& loop);
+
+        void on_opened(Loop& loop, uint64_t connectionId, const StreamOpenResult& result);
+
+        // 结束等待校验的连接：取消订阅，丢弃缓存的事件，发出错误响应后关闭
+        void abort_opening(Loop& loop, uint64_t connectionId, Connection& connection,
+                           int status, const std::string& message);
+
+        // 追加待发送数据并尝试发送；连接因此被关闭时返回 false
+        bool send(Loop& loop, uint64_t connectionId, Connection& connection, const std::string& data);
+
+        bool flush(Loop& loop, uint64_t connectionId, Connection& connection);
+
+        void close_connection(Loop& loop, uint64_t connectionId);
+
+        void sweep(Loop& loop, std::chrono::steady_clock::time_point now, bool heartbeat);
+
+    private:
+        OrderEventBus& bus;
+        const Opener opener;
+        const EventStreamOptions options;
+
+        int listenFd = -1;
+        std::atomic<bool> stopping {false};
+        bool started = false;
+
+        std::vector<std::unique_ptr<Loop>> loops;
+
+        std::mutex openMtx;
+        std::condition_variable openCv;
+        std::deque<OpenJob> openJobs;
+        std::vector<std::thread> openers;
+
+        std::atomic<uint64_t> acceptedCount {0};
+        std::atomic<uint64_t> openedCount {0};
+        std::atomic<uint64_t> rejectedCount {0};
+        std::atomic<uint64_t> slowClosedCount {0};
+        std::atomic<uint64_t> openRejectedCount {0};
+        std::atomic<uint64_t> openTimedOutCount {0};
+        std::atomic<uint64_t> earlyOverflowCount {0};
+        std::atomic<size_t> streamCount {0};
+    };
+}
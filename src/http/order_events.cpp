@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include "order_events.h"
+
+
+namespace TakeAwayPlatform
+{
+    uint64_t OrderEventBus::subscribe(const std::string& orderId, Sink sink)
+    {
+        const uint64_t subscriptionId = nextSubscription.fetch_add(1, std::memory_order_relaxed);
+
+        Shard& shard = shard_for(orderId);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.subscribers[orderId].emplace_back(subscriptionId, std::move(sink));
+        return subscriptionId;
+    }
+
+    void OrderEventBus::unsubscribe(const std::string& orderId, uint64_t subscriptionId)
+    {
+        Shard& shard = shard_for(orderId);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto found = shard.subscribers.find(orderId);
+        if (found == shard.subscribers.end()) {
+            return;
+        }
+
+        auto& sinks = found->second;
+        sinks.erase(std::remove_if(sinks.begin(), sinks.end(),
+            [subscriptionId](const auto& entry) { return entry.first == subscriptionId; }), sinks.end());
+        if (sinks.empty()) {
+            shard.subscribers.erase(found);
+        }
+    }
+
+    void OrderEventBus::publish(const std::string& orderId, const std::string& type, const Json::Value& data)
+    {
+        publishedCount.fetch_add(1, std::memory_order_relaxed);
+
+        // 复制回调后在锁外调用，订阅者可以在回调中取消订阅
+        std::vector<Sink> sinks;
+        {
+            Shard& shard = shard_for(orderId);
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto found = shard.subscribers.find(orderId);
+            if (found == shard.subscribers.end()) {
+                return;
+            }
+            sinks.reserve(found->second.size());
+            for (const auto& entry : found->second) {
+                sinks.push_back(entry.second);
+            }
+        }
+
+        auto event = std::make_shared<OrderEvent>();
+        event->id = nextEvent.fetch_add(1, std::memory_order_relaxed);
+        event->orderId = orderId;
+        event->type = type;
+        event->data = to_json(data);
+        const std::shared_ptr<const OrderEvent> shared = std::move(event);
+
+        for (const Sink& sink : sinks) {
+            sink(shared);
+        }
+        deliveredCount.fetch_add(sinks.size(), std::memory_order_relaxed);
+    }
+
+    OrderEventStats OrderEventBus::stats() const
+    {
+        OrderEventStats snapshot;
+        snapshot.published = publishedCount.load(std::memory_order_relaxed);
+        snapshot.delivered = deliveredCount.load(std::memory_order_relaxed);
+        for (const Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            for (const auto& entry : shard.subscribers) {
+                snapshot.subscriptions += entry.second.size();
+            }
+        }
+        return snapshot;
+    }
+
+    OrderEventBus::Shard& OrderEventBus::shard_for(const std::string& orderId)
+    {
+        return shards[std::hash<std::string>()(orderId) % SHARD_COUNT];
+    }
+}
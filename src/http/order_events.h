@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+
+namespace TakeAwayPlatform
+{
+    // 订单状态变化事件，发布后只读，由全部订阅者共享
+    struct OrderEvent
+    {
+        uint64_t id = 0;            // 进程内递增序号，用作 SSE 的 id
+        std::string orderId;
+        std::string type;           // "payment"、"delivery" 等
+        std::string data;           // 紧凑格式的 JSON
+    };
+
+    struct OrderEventStats
+    {
+        uint64_t published = 0;
+        uint64_t delivered = 0;     // 交给订阅者的次数
+        size_t subscriptions = 0;
+    };
+
+    // 进程内按订单号的发布/订阅
+    // 写接口在数据提交后发布，订阅者的回调在发布线程上同步调用，必须只做入队之类的非阻塞操作。
+    // 事件不持久化：订阅之前发布的事件不会补发，订阅方需要自己读取当前状态。
+    class OrderEventBus
+    {
+    public:
+        using Sink = std::function<void(const std::shared_ptr<const OrderEvent>& event)>;
+
+        OrderEventBus() = default;
+
+        OrderEventBus(const OrderEventBus&) = delete;
+        OrderEventBus& operator=(const OrderEventBus&) = delete;
+
+        // 返回订阅号，用于取消订阅
+        uint64_t subscribe(const std::string& orderId, Sink sink);
+
+        void unsubscribe(const std::string& orderId, uint64_t subscriptionId);
+
+        // 没有订阅者时只计数
+        void publish(const std::string& orderId, const std::string& type, const Json::Value& data);
+
+        OrderEventStats stats() const;
+
+    private:
+        struct Shard
+        {
+            mutable std::mutex mtx;
+            std::unordered_map<std::string, std::vector<std::pair<uint64_t, Sink>>> subscribers;
+        };
+
+        static constexpr size_t SHARD_COUNT = 16;
+
+        Shard& shard_for(const std::string& orderId);
+
+    private:
+        std::array<Shard, SHARD_COUNT> shards;
+
+        std::atomic<uint64_t> nextSubscription {1};
+        std::atomic<uint64_t> nextEvent {1};
+        std::atomic<uint64_t> publishedCount {0};
+        std::atomic<uint64_t> deliveredCount {0};
+    };
+}
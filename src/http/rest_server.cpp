@@ -1,133 +1,583 @@
-#include <iostream>
 #include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <map>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
 #include <cppconn/driver.h>
 #include <cppconn/connection.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
-#include <future>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
 
 #include "rest_server.h"
+#include "logger.h"
 
 
 namespace TakeAwayPlatform
 {
-    RestServer::RestServer(const std::string& configPath) : threadPool(std::thread::hardware_concurrency()) 
+    namespace
     {
-        std::cout << "RestServer starting." << std::endl;
-        std::cout.flush();
+        // /order/query 每页订单数
+        constexpr int ORDER_PAGE_SIZE_DEFAULT = 20;
+        constexpr int ORDER_PAGE_SIZE_MAX = 100;
+
+        // /merchant/reviews 与 /dish/reviews 每页条数，默认页大小的第一页进入响应缓存
+        constexpr int REVIEW_PAGE_SIZE_DEFAULT = 20;
+        constexpr int REVIEW_PAGE_SIZE_MAX = 100;
+
+        // 延迟批量写入的目标库：0 为主库，订单分片 n 为 n + 1
+        constexpr size_t WRITE_TARGET_PRIMARY = 0;
+
+        size_t write_target_shard(size_t shard)
+        {
+            return shard + 1;
+        }
+
+        // 通道或写入队列已满：快速失败，提示客户端稍后重试
+        void respond_busy(httplib::Response& res)
+        {
+            res.status = 503;
+            res.set_header("Retry-After", "1");
+            res.set_content("{\"status\":\"error\", \"message\": \"服务繁忙，请稍后重试\"}", "application/json");
+        }
+
+        // 下单时库存不足
+        class OutOfStockError : public std::runtime_error
+        {
+        public:
+            using std::runtime_error::runtime_error;
+        };
+
+        // 评价页的响应缓存只保存有评价的对象：键来自客户端输入，不存在的 ID 与没有评价的对象结果相同
+        bool has_reviews(const Json::Value& page)
+        {
+            return !page["reviews"].empty();
+        }
+
+        // 字符串字段的原始内容，不复制；不是字符串时返回空
+        std::string_view json_string_view(const Json::Value& value)
+        {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            return value.getString(&begin, &end) ? std::string_view(begin, static_cast<size_t>(end - begin)) : std::string_view();
+        }
+
+        // 连接任务进入线程池队列的时间，由连接上的第一个请求取走，计入该请求的耗时预算
+        std::chrono::steady_clock::time_point& connection_queued_at()
+        {
+            thread_local std::chrono::steady_clock::time_point queuedAt;
+            return queuedAt;
+        }
+
+        // 把当前线程绑定到 cpus，失败时只记录日志
+        void pin_current_thread(const std::vector<int>& cpus)
+        {
+            if (cpus.empty()) {
+                return;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                CPU_SET(cpu, &set);
+            }
+            const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (error != 0) {
+                LOG_WARN("Failed to pin thread to CPUs: " << std::strerror(error));
+            }
+        }
+
+        // 进程可以使用的 CPU 编号
+        std::vector<int> available_cpus()
+        {
+            std::vector<int> cpus;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &set)) {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+            return cpus;
+        }
+
+        // 在 httplib 线程池外层统计排队深度与排队时间；排队的连接超过 maxQueued 时直接拒绝，
+        // 由 httplib 关闭连接，过载时不再无限堆积客户端早已放弃的请求。
+        // 工作线程第一次取到任务时绑定到所属监听实例的 CPU，并设置连接池分片
+        class InstrumentedTaskQueue : public httplib::TaskQueue
+        {
+        public:
+            InstrumentedTaskQueue(size_t threads, size_t maxQueued, std::atomic<int64_t>& queued,
+                                  Histogram& waitTime, Counter& rejected, size_t slice, std::vector<int> cpus)
+                : pool(threads), maxQueued(static_cast<int64_t>(maxQueued)), queued(queued),
+                  waitTime(waitTime), rejected(rejected), slice(slice), cpus(std::move(cpus)) {}
+
+            bool enqueue(std::function<void()> fn) override
+            {
+                if (queued.fetch_add(1, std::memory_order_relaxed) >= maxQueued) {
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    rejected.add();
+                    return false;
+                }
+
+                const auto enqueuedAt = std::chrono::steady_clock::now();
+                const bool accepted = pool.enqueue([this, fn = std::move(fn), enqueuedAt] {
+                    bind_worker();
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    waitTime.record(std::chrono::steady_clock::now() - enqueuedAt);
+                    connection_queued_at() = enqueuedAt;
+                    fn();
+                    connection_queued_at() = std::chrono::steady_clock::time_point();
+                });
+                if (!accepted) {
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return accepted;
+            }
+
+            void shutdown() override
+            {
+                pool.shutdown();
+            }
+
+        private:
+            // httplib::ThreadPool 的线程只属于一个队列，每个线程只需绑定一次
+            void bind_worker()
+            {
+                thread_local bool bound = false;
+                if (bound) {
+                    return;
+                }
+                bound = true;
+                pin_current_thread(cpus);
+                DatabasePool::set_thread_slice(slice);
+            }
+
+        private:
+            httplib::ThreadPool pool;
+            const int64_t maxQueued;
+            std::atomic<int64_t>& queued;
+            Histogram& waitTime;
+            Counter& rejected;
+            const size_t slice;
+            const std::vector<int> cpus;
+        };
+    }
+
+    ListenerOptions load_listener_options(const Json::Value& config)
+    {
+        ListenerOptions options;
+        options.port = config.get("port", 9090).asInt();
+        options.listeners = std::max(1u, config.get("listeners", 1).asUInt());
+        options.backlog = std::max(1, config.get("listen_backlog", 512).asInt());
+        options.keepAliveMaxCount = std::max(1u, config.get("keep_alive_max_count", 100).asUInt());
+        options.keepAliveTimeout = std::chrono::seconds(std::max(1, config.get("keep_alive_timeout_s", 5).asInt()));
+
+        const Json::Value& affinity = config["cpu_affinity"];
+        if (affinity.isArray()) {
+            for (const Json::Value& cpus : affinity) {
+                std::vector<int> set;
+                for (const Json::Value& cpu : cpus) {
+                    set.push_back(cpu.asInt());
+                }
+                options.cpuSets.push_back(std::move(set));
+            }
+            // 列出的组数少于实例数时循环使用
+            if (!options.cpuSets.empty()) {
+                for (size_t index = options.cpuSets.size(); index < options.listeners; ++index) {
+                    options.cpuSets.push_back(options.cpuSets[index % affinity.size()]);
+                }
+                options.cpuSets.resize(options.listeners);
+            }
+        } else if (affinity.asString() == "auto") {
+            // 相邻编号的 CPU 分给同一实例，余下的归最后一个实例；CPU 不够分时每个实例一个，循环使用
+            const std::vector<int> cpus = available_cpus();
+            if (!cpus.empty()) {
+                options.cpuSets.resize(options.listeners);
+                const size_t perListener = cpus.size() / options.listeners;
+                for (size_t index = 0; index < options.listeners; ++index) {
+                    if (perListener == 0) {
+                        options.cpuSets[index].push_back(cpus[index % cpus.size()]);
+                        continue;
+                    }
+                    const size_t first = index * perListener;
+                    const size_t last = index + 1 == options.listeners ? cpus.size() : first + perListener;
+                    options.cpuSets[index].assign(cpus.begin() + first, cpus.begin() + last);
+                }
+            }
+        }
+
+        return options;
+    }
+
+    RestServer::RestServer(const std::string& configPath) 
+        : poolWait(MetricsRegistry::instance().histogram("takeaway_db_pool_acquire_seconds",
+              "Time spent in acquire_db_handler, including waits for a free connection")),
+          poolTimeouts(MetricsRegistry::instance().counter("takeaway_db_pool_timeouts_total",
+              "acquire_db_handler calls that timed out")),
+          taskWait(MetricsRegistry::instance().histogram("takeaway_http_task_wait_seconds",
+              "Time a connection task waited in the HTTP thread pool queue"))
+    {
+        LOG_INFO("RestServer starting.");
 
         Json::Value config = load_config(configPath);
 
-        std::cout << "RestServer load config success." << std::endl;
-        std::cout.flush();
+        // 日志级别与输出位置
+        const Json::Value& logConfig = config["log"];
+        LogOptions logOptions;
+        logOptions.level = parse_log_level(logConfig.get("level", "info").asString(), LogLevel::Info);
+        logOptions.file = logConfig.get("file", "").asString();
+        logOptions.flushInterval = std::chrono::milliseconds(logConfig.get("flush_interval_ms", 20).asInt());
+        Logger::instance().configure(logOptions);
+
+        // 主键 ID 格式
+        const IdOptions idOptions = load_id_options(config["id"]);
+        configure_ids(idOptions);
+
+        LOG_INFO("RestServer load config success.");
+        LOG_INFO("ID format: " << (idOptions.timeOrdered ? "uuid v7" : "uuid v4"));
         
+        // 处理函数直接运行在 httplib 的工作线程上，线程数取自配置
+        const Json::Value& serverConfig = config["server"];
+        size_t workerCount = serverConfig.get("thread_pool_size", 0).asUInt();
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const size_t maxQueued = std::max(1u, serverConfig.get("max_queued_connections", 128).asUInt());
+        Counter* rejectedConnections = &MetricsRegistry::instance().counter("takeaway_http_rejected_connections_total",
+            "Connections closed because the HTTP task queue was full");
+        LOG_INFO("HTTP worker threads: " << workerCount << ", max queued connections: " << maxQueued);
+
+        // 监听实例：工作线程按实例均分，排队上限仍是全部实例合计
+        listenerOptions = load_listener_options(serverConfig);
+        if (listenerOptions.listeners > workerCount) {
+            // 每个实例至少一个线程，实例多于线程时合计线程数会超过 thread_pool_size
+            LOG_WARN("HTTP listeners " << listenerOptions.listeners << " exceed worker threads " << workerCount
+                << ", using " << workerCount << " listeners");
+            listenerOptions.listeners = workerCount;
+        }
+        const size_t listenerCount = listenerOptions.listeners;
+        for (size_t index = 0; index < listenerCount; ++index) {
+            auto listener = std::make_unique<Listener>();
+            listener->index = index;
+            if (index < listenerOptions.cpuSets.size()) {
+                listener->cpus = listenerOptions.cpuSets[index];
+            }
+
+            const size_t threads = workerCount / listenerCount + (index < workerCount % listenerCount ? 1 : 0);
+            listener->server.new_task_queue = [this, threads, maxQueued, rejectedConnections, index, cpus = listener->cpus] {
+                return new InstrumentedTaskQueue(threads, maxQueued, queuedTasks, taskWait, *rejectedConnections, index, cpus);
+            };
+            listener->server.set_keep_alive_max_count(listenerOptions.keepAliveMaxCount);
+            listener->server.set_keep_alive_timeout(listenerOptions.keepAliveTimeout.count());
+
+            // 替换 httplib 默认的套接字选项：同端口的多个实例需要 SO_REUSEPORT，并记下套接字以便调整 backlog
+            Listener* owner = listener.get();
+            listener->server.set_socket_options([owner](int sock) {
+                int yes = 1;
+                setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+                setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+                owner->socket = sock;
+            });
+
+            std::ostringstream cpuList;
+            for (int cpu : listener->cpus) {
+                cpuList << (cpuList.tellp() > 0 ? "," : "") << cpu;
+            }
+            LOG_INFO("HTTP listener " << index << ": " << threads << " worker threads, CPUs "
+                << (listener->cpus.empty() ? "any" : cpuList.str()));
+            listeners.push_back(std::move(listener));
+        }
+        LOG_INFO("HTTP listeners: " << listenerCount << ", backlog " << listenerOptions.backlog
+            << ", keep-alive " << listenerOptions.keepAliveMaxCount << " requests / "
+            << listenerOptions.keepAliveTimeout.count() << "s");
+
+        // 每个请求的耗时预算，从连接进入队列（或请求进入 dispatch）时算起，超过后不再访问数据库
+        requestTimeout = std::chrono::seconds(serverConfig.get("timeout", 10).asInt());
+        LOG_INFO("Request timeout: " << requestTimeout.count() << "ms");
+
+        // 每个工作线程的请求临时内存，用量超过初始大小时逐步扩大到上限
+        const size_t arenaKb = serverConfig.get("request_arena_kb", 16).asUInt();
+        const size_t arenaMaxKb = serverConfig.get("request_arena_max_kb", 256).asUInt();
+        RequestArena::configure(arenaKb * 1024, arenaMaxKb * 1024);
+        LOG_INFO("Request arena: " << arenaKb << "KB per worker, up to " << arenaMaxKb << "KB");
+
+        // 按路由类别划分调度通道，各自限制并发
+        laneScheduler = std::make_unique<LaneScheduler>(serverConfig["lanes"], workerCount);
+        for (size_t index = 0; index < LANE_COUNT; ++index) {
+            const Lane lane = static_cast<Lane>(index);
+            const LaneOptions& options = laneScheduler->options(lane);
+            LOG_INFO("Lane " << lane_name(lane) << ": concurrency " << options.maxConcurrency
+                << ", queue " << options.maxQueue << ", wait " << options.maxWait.count() << "ms");
+        }
+
         // 初始化数据库连接池
         init_db_pool(config["database"]);
 
-        std::cout << "RestServer instance created." << std::endl;
-        std::cout.flush();
+        // 订单状态变化的进程内发布/订阅，配送与支付写入后发布
+        orderEvents = std::make_unique<OrderEventBus>();
+
+        // 评论、评价与配送信息的延迟批量写入
+        const WriteBehindOptions writeBehindOptions = load_write_behind_options(config["write_behind"]);
+        writeBehind = std::make_unique<WriteBehindQueue>([this](size_t target) {
+            return target == WRITE_TARGET_PRIMARY ? acquire_db_handler() : orderShards->lease(target - 1);
+        }, writeBehindOptions);
+        LOG_INFO("Write-behind: " << (writeBehindOptions.enabled ? "enabled" : "disabled")
+            << ", batch " << writeBehindOptions.batchSize
+            << ", flush " << writeBehindOptions.flushInterval.count() << "ms"
+            << ", backlog " << writeBehindOptions.maxBacklog);
+
+        // 热点菜品库存计数，售出量定时写回 DISH
+        const InventoryOptions inventoryOptions = load_inventory_options(config["inventory"]);
+        inventory = std::make_unique<Inventory>([this] { return acquire_db_handler(); }, inventoryOptions);
+        LOG_INFO("Inventory: " << (inventoryOptions.enabled ? "enabled" : "disabled")
+            << ", write-back " << inventoryOptions.writeBackInterval.count() << "ms"
+            << ", reservation ttl " << inventoryOptions.reservationTtl.count() << "s");
+
+        // 登录令牌与会话缓存
+        const SessionOptions sessionOptions = load_session_options(config["auth"]);
+        sessionCache = std::make_unique<SessionCache>(sessionOptions);
+        LOG_INFO("Sessions: ttl " << sessionOptions.ttl.count() << "s, max " << sessionOptions.maxSessions);
+
+        // 订单状态推送（SSE），独立端口，start() 时开始监听
+        const EventStreamOptions eventOptions = load_event_stream_options(config["events"]);
+        eventStream = std::make_unique<EventStreamServer>(*orderEvents, [this](const StreamRequest& request) {
+            return open_order_stream(request);
+        }, eventOptions);
+        LOG_INFO("Event stream: " << (eventOptions.enabled ? "enabled" : "disabled")
+            << ", port " << eventOptions.port
+            << ", loops " << eventOptions.loopThreads
+            << ", max streams " << eventOptions.maxStreams);
+
+        // 菜品目录缓存，由商家写接口主动失效
+        const CatalogOptions catalogOptions = load_catalog_options(config["cache"]);
+        catalogCache = std::make_unique<CatalogCache>([this](const std::string& merchantId) {
+            return acquire_read_handler("merchant:" + merchantId);
+        }, catalogOptions);
+        LOG_INFO("Catalog cache: " << (catalogOptions.enabled ? "enabled" : "disabled")
+            << ", ttl " << catalogOptions.ttl.count() << "s"
+            << ", max " << catalogOptions.maxMerchants << " merchants");
+
+        // 热点读接口的序列化结果缓存
+        const ResponseCacheOptions responseOptions = load_response_cache_options(config["cache"]);
+        responseCache = std::make_unique<ResponseCache>(responseOptions);
+        LOG_INFO("Response cache: " << (responseOptions.enabled ? "enabled" : "disabled")
+            << ", ttl " << responseOptions.ttl.count() << "s"
+            << ", gzip " << (responseOptions.gzip ? "on" : "off")
+            << ", max " << responseOptions.maxBytes / (1024 * 1024) << "MB");
+
+        // 商家名与菜品名搜索索引，首次查询时加载
+        const SearchOptions searchOptions = load_search_options(config["cache"]);
+        searchIndex = std::make_unique<SearchIndex>([this] { return acquire_read_handler("search"); }, searchOptions);
+        LOG_INFO("Search index: " << (searchOptions.enabled ? "enabled" : "disabled")
+            << ", refresh " << searchOptions.refresh.count() << "s");
+
+        register_collectors();
+
+        // 连接池已在后台并行建连；预热在独立线程中进行，期间 /health 返回 WARMING
+        const Json::Value& warmupConfig = config["warmup"];
+        const std::chrono::seconds warmupTimeout(warmupConfig.get("timeout_s", 30).asInt());
+        const size_t catalogMerchants = warmupConfig.get("catalog_merchants", 0).asUInt();
+        const bool warmSearch = warmupConfig.get("search_index", false).asBool();
+        warmupBeforeListen = warmupConfig.get("before_listen", false).asBool();
+        warmupThread = std::thread([this, warmupTimeout, catalogMerchants, warmSearch] {
+            warm_up(warmupTimeout, catalogMerchants, warmSearch);
+        });
+
+        LOG_INFO("RestServer instance created.");
     }
 
     RestServer::~RestServer() 
     {
         stop();
+        if (warmupThread.joinable()) {
+            warmupThread.join();
+        }
+        MetricsRegistry::instance().remove_collector(collectorId);
     }
 
     void RestServer::start(int port) 
     {
         if (isRunning) {
-            std::cerr << "Server is already running." << std::endl;
-            std::cout.flush();
+            LOG_WARN("Server is already running.");
             return;
         }
         
+        if (warmupBeforeListen && warmupThread.joinable()) {
+            LOG_INFO("Waiting for warm-up before listening on port " << port << "...");
+            warmupThread.join();
+        }
+
+        if (eventStream->enabled() && !eventStream->start()) {
+            LOG_ERROR("Event stream failed to start, order events will not be pushed");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(stopMtx);
+            activeListeners = listeners.size();
+        }
         isRunning = true;
         stopRequested = false;
         
-        // 成员变量保存线程
-        serverThread = std::thread([this, port] {
-            this->run_server(port);
-        });
+        // 每个监听实例一个 accept 线程
+        for (auto& listener : listeners) {
+            Listener* instance = listener.get();
+            instance->thread = std::thread([this, instance, port] {
+                this->run_listener(*instance, port);
+            });
+        }
         
-        std::cout << "Server starting on port " << port << "..." << std::endl;
-        std::cout.flush();
+        LOG_INFO("Server starting on port " << port << " with " << listeners.size() << " listener(s)...");
     }
 
-    void RestServer::run_server(int port) 
+    void RestServer::run_listener(Listener& listener, int port) 
     {
+        pin_current_thread(listener.cpus);
+
         try 
         {
             // 设置路由
-            setup_routes();
-            
-            std::cout << "HTTP server listening on port " << port << std::endl;
-            std::cout.flush();
+            setup_routes(listener.server);
+
+            if (stopRequested) {
+                LOG_INFO("Listener " << listener.index << " not started, server is stopping");
+            } else if (!listener.server.bind_to_port("0.0.0.0", port)) {
+                LOG_ERROR("Listener " << listener.index << " failed to bind port " << port);
+            } else {
+                // httplib 以固定的 backlog 调用 listen()，对已在监听的套接字再次 listen() 可以修改队列长度
+                if (listener.socket >= 0 && ::listen(listener.socket, listenerOptions.backlog) != 0) {
+                    LOG_WARN("Listener " << listener.index << " failed to set backlog: " << std::strerror(errno));
+                }
 
-            if (!server.listen("0.0.0.0", port)) {
-                std::cerr << "Failed to start server on port " << port << std::endl;
+                LOG_INFO("HTTP listener " << listener.index << " listening on port " << port);
+                if (!listener.server.listen_after_bind()) {
+                    LOG_ERROR("Listener " << listener.index << " failed on port " << port);
+                }
             }
             
-            std::cout << "HTTP server exited listen loop." << std::endl;
+            LOG_INFO("HTTP listener " << listener.index << " exited listen loop.");
         } 
         catch (const std::exception& e) 
         {
-            std::cerr << "Server error in worker thread: " << e.what() << std::endl;
-            std::cout.flush();
+            LOG_ERROR("Server error in listener " << listener.index << ": " << e.what());
         }
         
-        // 服务器已停止，更新状态
-        isRunning = false;
-        
-        // 通知等待的线程
-        stopCv.notify_one();
-        std::cout << "Server worker thread exiting." << std::endl;
-        std::cout.flush();
+        // 一个实例意外退出时停止其余实例，整个服务器一起停止
+        if (!stopRequested.exchange(true)) {
+            for (auto& other : listeners) {
+                other->server.stop();
+            }
+        }
+
+        // 最后一个实例退出后更新状态，并通知等待的线程
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(stopMtx);
+            last = --activeListeners == 0;
+            if (last) {
+                isRunning = false;
+            }
+        }
+        if (last) {
+            stopCv.notify_all();
+        }
+        LOG_INFO("Listener " << listener.index << " thread exiting.");
     }
 
     void RestServer::stop() 
     {
         if (!isRunning) {
-            std::cout << "Server already stop." << std::endl;
-            std::cout.flush();
+            LOG_INFO("Server already stop.");
             return;
         }
         
-        std::cout << "Requesting server stop..." << std::endl;
-        std::cout.flush();
+        LOG_INFO("Requesting server stop...");
         stopRequested = true;
         
-        // 通知服务器停止
-        server.stop();
+        // 通知全部监听实例停止
+        for (auto& listener : listeners) {
+            listener->server.stop();
+        }
         
         // 等待服务器实际停止
         std::unique_lock<std::mutex> lock(stopMtx);
-        if (stopCv.wait_for(lock, std::chrono::seconds(5), [this] {
-            return !isRunning;
-        }))
-        {
-            if (serverThread.joinable()) 
-            {
-                serverThread.join();
+        const bool stopped = stopCv.wait_for(lock, std::chrono::seconds(5), [this] {
+            return activeListeners == 0;
+        });
+        lock.unlock();
+
+        for (auto& listener : listeners) {
+            if (!listener->thread.joinable()) {
+                continue;
+            }
+            if (stopped) {
+                listener->thread.join();
+            } else {
+                listener->thread.detach(); // 最后手段，避免死锁
             }
+        }
+        if (stopped) {
+            LOG_INFO("Server stopped successfully.");
+        } else {
+            LOG_WARN("Server did not stop within timeout.");
+        }
 
-            std::cout << "Server stopped successfully." << std::endl;
-            std::cout.flush();
-        } 
-        else 
-        {
-            std::cerr << "Warning: Server did not stop within timeout." << std::endl;
-            std::cout.flush();
+        // 推送连接的校验会访问连接池，先于连接池关闭
+        if (eventStream) {
+            eventStream->stop();
+        }
 
-            if (serverThread.joinable()) 
-            {
-                serverThread.detach(); // 最后手段，避免死锁
-            }
+        // 先写完积压的延迟写入，再关闭连接池
+        if (writeBehind) {
+            writeBehind->drain();
+        }
+        if (inventory) {
+            inventory->shutdown();
         }
 
         // 清理数据库连接池
-        std::lock_guard<std::mutex> dbLock(dbPoolMutex);
-        while (!dbPool.empty()) {
-            dbPool.pop();
+        if (dbRouter) {
+            const RouterStats router = dbRouter->stats();
+            for (const DBNodeStats& node : router.nodes) {
+                const PoolStats& stats = node.pool;
+                LOG_INFO("DB pool stats [" << node.name << "] - hits: " << stats.hits
+                    << ", creations: " << stats.creations
+                    << ", waits: " << stats.waits
+                    << ", wait_us: " << stats.waitTimeMicros
+                    << ", timeouts: " << stats.timeouts
+                    << ", reads: " << node.reads);
+            }
+            LOG_INFO("DB router stats - sticky reads: " << router.stickyReads
+                << ", fallbacks: " << router.fallbacks);
+        }
+        if (orderShards) {
+            const ShardStats shards = orderShards->stats();
+            for (const DBNodeStats& node : shards.nodes) {
+                LOG_INFO("DB pool stats [" << node.name << "] - hits: " << node.pool.hits
+                    << ", creations: " << node.pool.creations
+                    << ", waits: " << node.pool.waits
+                    << ", timeouts: " << node.pool.timeouts);
+            }
+            LOG_INFO("Order shard stats - locate hits: " << shards.locateHits
+                << ", probes: " << shards.locateProbes
+                << ", scatters: " << shards.scatters
+                << ", inline legs: " << shards.inlineLegs);
+            orderShards->shutdown();
+        }
+        if (dbRouter) {
+            dbRouter->shutdown();
+        }
+
+        // 连接池关闭后预热中的查询会立即失败，线程很快结束
+        if (warmupThread.joinable()) {
+            warmupThread.join();
         }
     }
 
@@ -138,94 +588,633 @@ namespace TakeAwayPlatform
 
     void RestServer::init_db_pool(const Json::Value& config) 
     {
-        std::cout << "host: " << config["host"].asString() << std::endl;
-        std::cout << "port: " << config["port"].asInt() << std::endl;
-        std::cout << "user: " << config["user"].asString() << std::endl;
-        std::cout << "password: " << config["password"].asString() << std::endl;
-        std::cout << "name: " << config["name"].asString() << std::endl;
-        std::cout.flush();
-        
-        int pool_size = config.get("pool_size", 10).asInt();
-
-        dbConfig.push_back({
-            config["host"].asString(),
-            config["port"].asInt(),
-            config["user"].asString(),
-            config["password"].asString(),
-            config["name"].asString()
-        });
+        // 主库加可选的从库列表，每个节点一个连接池
+        dbRouter = std::make_unique<DatabaseRouter>(load_db_nodes(config), load_router_options(config));
+
+        // 订单相关表按 userId 分片；未配置分片时使用主库
+        orderShards = std::make_unique<OrderShards>(load_shard_nodes(config),
+            [this] { return acquire_db_handler(); }, load_shard_options(config));
+    }
+
+    void RestServer::warm_up(std::chrono::seconds timeout, size_t catalogMerchants, bool warmSearch)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + timeout;
+
+        // 先各自等待，避免主库超时后不再等待分片
+        const bool routerWarm = dbRouter->wait_warm(deadline);
+        const bool shardsWarm = orderShards->wait_warm(deadline);
+        if (!routerWarm || !shardsWarm) {
+            LOG_WARN("Connection pools still warming after " << timeout.count() << "s, serving anyway");
+        }
 
-        for (int index = 0; index < pool_size; ++index) {
-            dbPool.push(create_db_handler());
+        size_t catalogsLoaded = 0;
+        if (catalogMerchants > 0 && catalogCache->enabled() && !stopRequested)
+        {
+            try {
+                auto db = acquire_read_handler();
+                const Json::Value merchants = db->execute(StmtId::OpenMerchantIds, static_cast<int>(catalogMerchants));
+                db.reset();
+
+                for (const auto& row : merchants) {
+                    if (stopRequested) {
+                        break;
+                    }
+                    catalogCache->merchant(row["merchantId"].asString());
+                    ++catalogsLoaded;
+                }
+            } catch (const std::exception& e) {
+                LOG_WARN("Catalog warm-up stopped after " << catalogsLoaded << " merchants: " << e.what());
+            }
+        }
+
+        if (warmSearch && searchIndex->enabled() && !stopRequested)
+        {
+            try {
+                searchIndex->rebuild();
+            } catch (const std::exception& e) {
+                LOG_WARN("Search index warm-up failed: " << e.what());
+            }
         }
+
+        ready = true;
+        LOG_INFO("Server ready after " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count() << "ms"
+            << ", catalogs: " << catalogsLoaded);
     }
 
-    std::unique_ptr<DatabaseHandler> RestServer::create_db_handler() 
+    DBLease RestServer::acquire_db_handler() 
     {
-        return std::make_unique<DatabaseHandler>(dbConfig[0]);
+        // 池满时在超时时间内阻塞等待，超时抛出 PoolTimeoutError
+        // 租约离开作用域时自动归还，异常路径同样适用
+        ScopedTimer timer(poolWait);
+        try {
+            return dbRouter->primary();
+        } catch (const PoolTimeoutError&) {
+            poolTimeouts.add();
+            throw;
+        }
     }
 
-    std::unique_ptr<DatabaseHandler> RestServer::acquire_db_handler() 
+    DBLease RestServer::acquire_read_handler(const std::string& stickyKey)
     {
-        std::lock_guard<std::mutex> lock(dbPoolMutex);
-        if (dbPool.empty()) {
-            return create_db_handler();
+        // 从库繁忙或不可用时由路由退回主库，只有主库也超时才抛出
+        ScopedTimer timer(poolWait);
+        try {
+            return dbRouter->read(stickyKey);
+        } catch (const PoolTimeoutError&) {
+            poolTimeouts.add();
+            throw;
         }
-        
-        auto handler = std::move(dbPool.front());
-        dbPool.pop();
-        return handler;
     }
 
-    void RestServer::release_db_handler(std::unique_ptr<DatabaseHandler> handler) 
+    void RestServer::send_cached(const httplib::Request& req, httplib::Response& res,
+                                 const std::shared_ptr<const CachedResponse>& cached)
+    {
+        res.set_header("ETag", cached->etag);
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Vary", "Accept-Encoding");
+
+        const std::string ifNoneMatch = req.get_header_value("If-None-Match");
+        if (!ifNoneMatch.empty() && (ifNoneMatch == "*" || ifNoneMatch.find(cached->etag) != std::string::npos)) {
+            res.status = 304;
+            return;
+        }
+
+        const bool useGzip = !cached->gzipBody.empty()
+            && req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos;
+        if (useGzip) {
+            res.set_header("Content-Encoding", "gzip");
+        }
+
+        // 直接从共享缓冲区发送，不复制到 res.body
+        const std::string& body = useGzip ? cached->gzipBody : cached->body;
+        res.set_content_provider(body.size(), "application/json",
+            [cached, &body](size_t offset, size_t length, httplib::DataSink& sink) {
+                return sink.write(body.data() + offset, length);
+            });
+    }
+
+    namespace
+    {
+        // 分块输出的单块大小
+        constexpr size_t STREAM_CHUNK_BYTES = 16 * 1024;
+
+        // 流式输出期间持有连接与结果集，全部发送完或连接中断后归还连接
+        struct RowStream
+        {
+            RowStream(DBLease lease, mysqlx::SqlResult rows)
+                : db(std::move(lease)), result(std::move(rows)), writer(result)
+            {
+                buffer.reserve(STREAM_CHUNK_BYTES + 1024);
+            }
+
+            DBLease db;
+            mysqlx::SqlResult result;
+            JsonRowWriter writer;
+            std::string buffer;
+        };
+    }
+
+    void RestServer::stream_rows(httplib::Response& res, DBLease db, mysqlx::SqlResult result)
+    {
+        auto stream = std::make_shared<RowStream>(std::move(db), std::move(result));
+
+        res.set_chunked_content_provider("application/json",
+            [stream](size_t, httplib::DataSink& sink) {
+                try {
+                    stream->buffer.clear();
+                    const bool finished = stream->writer.write_some(stream->buffer, STREAM_CHUNK_BYTES);
+                    if (!stream->buffer.empty() && !sink.write(stream->buffer.data(), stream->buffer.size())) {
+                        return false;
+                    }
+                    if (finished) {
+                        stream->db.reset();
+                        sink.done();
+                    }
+                    return true;
+                } catch (const std::exception& e) {
+                    // 响应头已经发出，只能中断连接
+                    LOG_WARN_RATE(10, "Row stream error: " << e.what());
+                    return false;
+                }
+            },
+            [stream](bool success) {
+                if (!success && stream->db) {
+                    // 结果集可能没有读完，归还前让连接池检查连接
+                    stream->db->mark_suspect();
+                }
+                stream->db.reset();
+            });
+    }
+
+    StreamOpenResult RestServer::open_order_stream(const StreamRequest& request)
+    {
+        StreamOpenResult result;
+
+        // 推送订单状态必须登录，先校验令牌再查订单，未登录的连接拿不到订单是否存在的信息
+        const std::optional<Session> session =
+            request.token.empty() ? std::nullopt : sessionCache->validate(request.token);
+        if (!session) {
+            result.status = 401;
+            result.message = request.token.empty() ? "请先登录" : "登录已失效，请重新登录";
+            return result;
+        }
+
+        Json::Value rows;
+        try {
+            auto db = orderShards->lease(orderShards->locate_order(request.orderId));
+            rows = db->execute(StmtId::OrderStatusSnapshot, request.orderId);
+        } catch (const std::invalid_argument&) {
+            // locate_order 在各分片都找不到订单
+        }
+        if (rows.empty()) {
+            result.status = 404;
+            result.message = "订单不存在";
+            return result;
+        }
+
+        Json::Value& order = rows[0];
+        if (session->kind != "admin" && session->subjectId != order["userId"].asString()) {
+            result.status = 403;
+            result.message = "无权访问其他用户的数据";
+            return result;
+        }
+
+        order.removeMember("userId");
+        result.snapshot = order;
+        return result;
+    }
+
+    Json::Value RestServer::review_page(RatingTarget target, const std::string& targetId,
+                                        const std::string& cursorTime, const std::string& cursorId, int pageSize)
+    {
+        const bool dish = target == RatingTarget::Dish;
+        const char* timeField = dish ? "commentTime" : "reviewTime";
+        const char* idField = dish ? "commentId" : "reviewId";
+
+        auto db = acquire_read_handler(dish ? "dish:" + targetId : "reviews:" + targetId);
+
+        // 多取一条用于判断是否还有下一页
+        Json::Value reviews;
+        if (cursorTime.empty() || cursorId.empty()) {
+            reviews = db->execute(dish ? StmtId::DishReviews : StmtId::MerchantReviews, targetId, pageSize + 1);
+        } else {
+            reviews = db->execute(dish ? StmtId::DishReviewsAfter : StmtId::MerchantReviewsAfter,
+                targetId, cursorTime, cursorTime, cursorId, pageSize + 1);
+        }
+        Json::Value summary = rating_summary(*db, target, targetId);
+        db.reset();
+
+        const bool hasMore = reviews.size() > static_cast<Json::ArrayIndex>(pageSize);
+        if (hasMore) {
+            Json::Value removed;
+            reviews.removeIndex(static_cast<Json::ArrayIndex>(pageSize), &removed);
+        }
+
+        Json::Value response;
+        response["status"] = "success";
+        response[dish ? "dishId" : "merchantId"] = targetId;
+        response["summary"] = std::move(summary);
+        response["reviews"] = std::move(reviews);
+        response["hasMore"] = hasMore;
+        if (hasMore) {
+            const Json::Value& last = response["reviews"][static_cast<Json::ArrayIndex>(pageSize - 1)];
+            response["nextCursor"]["cursorTime"] = last[timeField];
+            response["nextCursor"]["cursorId"] = last[idField];
+        }
+        return response;
+    }
+
+    void RestServer::invalidate_catalog(const std::string& merchantId)
+    {
+        // 从库追上之前，重新加载目录与菜单的查询读主库，避免把旧数据写回缓存
+        dbRouter->note_write("merchant:" + merchantId);
+        dbRouter->note_write("menu");
+        catalogCache->invalidate(merchantId);
+        responseCache->invalidate("menu");
+        responseCache->invalidate("dishes/" + merchantId);
+    }
+
+    namespace
+    {
+        // 每个路由的指标在注册路由时创建，处理请求时只做原子加法
+        struct RouteMetrics
+        {
+            Histogram* duration;
+            std::array<Counter*, 5> statusClasses;      // 1xx ~ 5xx
+            Counter* rejected;
+            Counter* expired;
+            Counter* errors;
+
+            explicit RouteMetrics(const std::string& route)
+            {
+                MetricsRegistry& registry = MetricsRegistry::instance();
+                duration = &registry.histogram("takeaway_http_request_duration_seconds",
+                    "Handler time per route, including lane admission", {{"route", route}});
+                for (size_t index = 0; index < statusClasses.size(); ++index) {
+                    statusClasses[index] = &registry.counter("takeaway_http_requests_total",
+                        "Requests handled per route and status class",
+                        {{"route", route}, {"code", std::to_string(index + 1) + "xx"}});
+                }
+                rejected = &registry.counter("takeaway_http_rejected_total",
+                    "Requests rejected by lane admission control", {{"route", route}});
+                expired = &registry.counter("takeaway_http_expired_total",
+                    "Requests dropped because their deadline passed before the handler ran", {{"route", route}});
+                errors = &registry.counter("takeaway_http_errors_total",
+                    "Requests answered with a 5xx status", {{"route", route}});
+            }
+
+            void finish(int status)
+            {
+                if (status >= 100 && status < 600) {
+                    statusClasses[static_cast<size_t>(status / 100 - 1)]->add();
+                }
+                if (status >= 500) {
+                    errors->add();
+                }
+            }
+        };
+    }
+
+    bool RestServer::resolve_user(const httplib::Request& req, httplib::Response& res, std::string& userId)
+    {
+        const std::string token = SessionCache::bearer_token(req.get_header_value("Authorization"));
+        if (token.empty()) {
+            // 未携带令牌，沿用请求参数
+            return true;
+        }
+
+        const std::optional<Session> session = sessionCache->validate(token);
+        if (!session) {
+            res.status = 401;
+            res.set_content("{\"status\":\"fail\", \"message\": \"登录已失效，请重新登录\"}", "application/json");
+            return false;
+        }
+        if (session->kind == "admin") {
+            return true;
+        }
+        if (!userId.empty() && userId != session->subjectId) {
+            res.status = 403;
+            res.set_content("{\"status\":\"fail\", \"message\": \"无权访问其他用户的数据\"}", "application/json");
+            return false;
+        }
+
+        userId = session->subjectId;
+        return true;
+    }
+
+    httplib::Server::Handler RestServer::dispatch(const std::string& route, Lane lane, httplib::Server::Handler handler)
+    {
+        auto metrics = std::make_shared<RouteMetrics>(route);
+
+        return [this, lane, metrics, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res) {
+            ScopedTimer timer(*metrics->duration);
+
+            // 截止时间：连接上的第一个请求从连接入队时算起，之后的请求从进入这里时算起；
+            // 客户端可以用 X-Request-Timeout-Ms 要求更短的预算
+            const auto now = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point& queuedAt = connection_queued_at();
+            const auto arrival = queuedAt == std::chrono::steady_clock::time_point() ? now : queuedAt;
+            queuedAt = std::chrono::steady_clock::time_point();
+
+            auto deadline = arrival + requestTimeout;
+            const std::string clientTimeout = req.get_header_value("X-Request-Timeout-Ms");
+            if (!clientTimeout.empty()) {
+                const long millis = std::strtol(clientTimeout.c_str(), nullptr, 10);
+                if (millis > 0) {
+                    deadline = std::min(deadline, now + std::chrono::milliseconds(millis));
+                }
+            }
+
+            LaneScheduler::Permit permit = laneScheduler->admit(lane, deadline);
+            if (!permit) {
+                // 通道已满：快速失败，不占用工作线程和数据库连接
+                respond_busy(res);
+                metrics->rejected->add();
+                metrics->finish(res.status);
+                return;
+            }
+
+            if (std::chrono::steady_clock::now() >= deadline) {
+                // 排队期间已经超时，客户端多半已经放弃，不再访问数据库
+                permit.release();
+                respond_busy(res);
+                metrics->expired->add();
+                metrics->finish(res.status);
+                return;
+            }
+
+            RequestDeadline::Scope deadlineScope(deadline);
+            RequestArena::Scope arenaScope;
+            handler(req, res);
+
+            // 流式响应在这里只计入生成响应头前的耗时；-1 表示处理函数没有设置状态码
+            metrics->finish(res.status == -1 ? 200 : res.status);
+        };
+    }
+
+    void RestServer::register_collectors()
     {
-        std::lock_guard<std::mutex> lock(dbPoolMutex);
-        dbPool.push(std::move(handler));
+        collectorId = MetricsRegistry::instance().add_collector([this](MetricsWriter& out) {
+            if (dbRouter) {
+                const RouterStats router = dbRouter->stats();
+                for (const DBNodeStats& node : router.nodes) {
+                    const PoolStats& pool = node.pool;
+                    const MetricLabels labels {{"node", node.name}};
+                    out.gauge("takeaway_db_pool_connections", "Open connections in the pool", static_cast<double>(pool.total), labels);
+                    out.gauge("takeaway_db_pool_idle_connections", "Idle connections in the pool", static_cast<double>(pool.idle), labels);
+                    out.gauge("takeaway_db_pool_recovering_connections", "Returned connections waiting for background recovery", static_cast<double>(pool.recovering), labels);
+                    out.gauge("takeaway_db_pool_leased_connections", "Connections currently leased out", static_cast<double>(pool.leased), labels);
+                    out.gauge("takeaway_db_node_available", "1 unless the replica is paused after a connection failure", node.available ? 1.0 : 0.0, labels);
+                }
+                for (const DBNodeStats& node : router.nodes) {
+                    const PoolStats& pool = node.pool;
+                    const MetricLabels labels {{"node", node.name}};
+                    out.counter("takeaway_db_pool_hits_total", "Acquires served by an idle connection", static_cast<double>(pool.hits), labels);
+                    out.counter("takeaway_db_pool_slice_misses_total", "Acquires served by a connection another listener returned", static_cast<double>(pool.sliceMisses), labels);
+                    out.counter("takeaway_db_pool_creations_total", "Connections opened by the pool", static_cast<double>(pool.creations), labels);
+                    out.counter("takeaway_db_pool_waits_total", "Acquires that had to wait", static_cast<double>(pool.waits), labels);
+                    out.counter("takeaway_db_pool_discarded_total", "Connections discarded on release", static_cast<double>(pool.discarded), labels);
+                    out.counter("takeaway_db_pool_health_failures_total", "Failed background health checks", static_cast<double>(pool.healthFailures), labels);
+                    out.counter("takeaway_db_reads_total", "Read-only leases served by the node", static_cast<double>(node.reads), labels);
+                    out.counter("takeaway_db_lease_failures_total", "Failed read lease attempts on the node", static_cast<double>(node.failures), labels);
+                }
+                out.counter("takeaway_db_sticky_reads_total", "Reads sent to the primary because the key was written recently",
+                            static_cast<double>(router.stickyReads));
+                out.counter("takeaway_db_replica_fallbacks_total", "Reads sent to the primary because no replica was usable",
+                            static_cast<double>(router.fallbacks));
+            }
+
+            if (orderShards) {
+                const ShardStats shards = orderShards->stats();
+                for (const DBNodeStats& node : shards.nodes) {
+                    const MetricLabels labels {{"node", node.name}};
+                    out.gauge("takeaway_db_pool_connections", "Open connections in the pool", static_cast<double>(node.pool.total), labels);
+                    out.gauge("takeaway_db_pool_idle_connections", "Idle connections in the pool", static_cast<double>(node.pool.idle), labels);
+                    out.gauge("takeaway_db_pool_recovering_connections", "Returned connections waiting for background recovery", static_cast<double>(node.pool.recovering), labels);
+                    out.gauge("takeaway_db_pool_leased_connections", "Connections currently leased out", static_cast<double>(node.pool.leased), labels);
+                }
+                for (const DBNodeStats& node : shards.nodes) {
+                    const MetricLabels labels {{"node", node.name}};
+                    out.counter("takeaway_db_pool_hits_total", "Acquires served by an idle connection", static_cast<double>(node.pool.hits), labels);
+                    out.counter("takeaway_db_pool_slice_misses_total", "Acquires served by a connection another listener returned", static_cast<double>(node.pool.sliceMisses), labels);
+                    out.counter("takeaway_db_pool_creations_total", "Connections opened by the pool", static_cast<double>(node.pool.creations), labels);
+                    out.counter("takeaway_db_pool_waits_total", "Acquires that had to wait", static_cast<double>(node.pool.waits), labels);
+                }
+                out.gauge("takeaway_order_shards", "Number of order shards", static_cast<double>(orderShards->shard_count()));
+                out.counter("takeaway_order_locate_total", "orderId to shard lookups", static_cast<double>(shards.locateHits), {{"result", "cached"}});
+                out.counter("takeaway_order_locate_total", "orderId to shard lookups", static_cast<double>(shards.locateProbes), {{"result", "probe"}});
+                out.counter("takeaway_order_scatter_total", "Queries run on every order shard", static_cast<double>(shards.scatters));
+                out.counter("takeaway_order_scatter_inline_total", "Shard legs run on the request thread because the scatter pool queue was full",
+                            static_cast<double>(shards.inlineLegs));
+            }
+
+            if (writeBehind && writeBehind->enabled()) {
+                const WriteBehindStats queue = writeBehind->stats();
+                out.gauge("takeaway_write_behind_backlog", "Rows queued or being written", static_cast<double>(queue.backlog));
+                out.counter("takeaway_write_behind_rows_total", "Rows accepted by the write-behind queue", static_cast<double>(queue.enqueued));
+                out.counter("takeaway_write_behind_written_total", "Rows written by the write-behind queue", static_cast<double>(queue.written));
+                out.counter("takeaway_write_behind_batches_total", "Batched INSERT statements executed", static_cast<double>(queue.batches));
+                out.counter("takeaway_write_behind_retries_total", "Batches retried after a failure", static_cast<double>(queue.retries));
+                out.counter("takeaway_write_behind_rejected_total", "Rows rejected because the backlog was full", static_cast<double>(queue.rejected));
+                out.counter("takeaway_write_behind_failed_total", "Rows dropped after retries or rejected by the database", static_cast<double>(queue.failed));
+            }
+
+            if (inventory && inventory->enabled()) {
+                const InventoryStats stock = inventory->stats();
+                out.gauge("takeaway_inventory_dishes", "Dishes with an in-memory stock counter", static_cast<double>(stock.dishes));
+                out.gauge("takeaway_inventory_reservations", "Stock reservations awaiting payment", static_cast<double>(stock.reservations));
+                out.counter("takeaway_inventory_reservations_total", "Stock reservations by outcome", static_cast<double>(stock.reserved), {{"result", "reserved"}});
+                out.counter("takeaway_inventory_reservations_total", "Stock reservations by outcome", static_cast<double>(stock.rejected), {{"result", "rejected"}});
+                out.counter("takeaway_inventory_reservations_total", "Stock reservations by outcome", static_cast<double>(stock.confirmed), {{"result", "confirmed"}});
+                out.counter("takeaway_inventory_reservations_total", "Stock reservations by outcome", static_cast<double>(stock.released), {{"result", "released"}});
+                out.counter("takeaway_inventory_reservations_total", "Stock reservations by outcome", static_cast<double>(stock.expired), {{"result", "expired"}});
+                out.counter("takeaway_inventory_write_backs_total", "Stock write-back statements executed", static_cast<double>(stock.writeBacks));
+                out.counter("takeaway_inventory_write_back_failures_total", "Stock write-backs that failed and were retried", static_cast<double>(stock.writeBackFailures));
+            }
+
+            if (sessionCache) {
+                const SessionStats sessions = sessionCache->stats();
+                out.gauge("takeaway_sessions", "Sessions in the in-process session cache", static_cast<double>(sessions.sessions));
+                out.counter("takeaway_sessions_issued_total", "Tokens issued at login", static_cast<double>(sessions.issued));
+                out.counter("takeaway_session_validations_total", "Token validations by result", static_cast<double>(sessions.validated), {{"result", "valid"}});
+                out.counter("takeaway_session_validations_total", "Token validations by result", static_cast<double>(sessions.rejected), {{"result", "rejected"}});
+                out.counter("takeaway_sessions_revoked_total", "Sessions revoked by logout", static_cast<double>(sessions.revoked));
+                out.counter("takeaway_sessions_evicted_total", "Sessions evicted because the cache was full", static_cast<double>(sessions.evicted));
+            }
+
+            if (orderEvents) {
+                const OrderEventStats events = orderEvents->stats();
+                out.counter("takeaway_order_events_published_total", "Order status events published", static_cast<double>(events.published));
+                out.counter("takeaway_order_events_delivered_total", "Order status events handed to subscribers", static_cast<double>(events.delivered));
+                out.gauge("takeaway_order_event_subscriptions", "Open order status subscriptions", static_cast<double>(events.subscriptions));
+            }
+            if (eventStream && eventStream->enabled()) {
+                const EventStreamStats streams = eventStream->stats();
+                out.gauge("takeaway_event_streams", "Open order status stream connections", static_cast<double>(streams.streams));
+                out.counter("takeaway_event_streams_opened_total", "Stream connections that passed authorization", static_cast<double>(streams.opened));
+                out.counter("takeaway_event_streams_closed_total", "Stream connections refused or dropped by the server",
+                            static_cast<double>(streams.rejected), {{"reason", "limit"}});
+                out.counter("takeaway_event_streams_closed_total", "Stream connections refused or dropped by the server",
+                            static_cast<double>(streams.slowClosed), {{"reason", "slow"}});
+                out.counter("takeaway_event_streams_closed_total", "Stream connections refused or dropped by the server",
+                            static_cast<double>(streams.openRejected), {{"reason", "open_queue"}});
+                out.counter("takeaway_event_streams_closed_total", "Stream connections refused or dropped by the server",
+                            static_cast<double>(streams.openTimedOut), {{"reason", "open_timeout"}});
+                out.counter("takeaway_event_streams_closed_total", "Stream connections refused or dropped by the server",
+                            static_cast<double>(streams.earlyOverflow), {{"reason", "early_overflow"}});
+            }
+
+            out.gauge("takeaway_server_ready", "1 once warm-up has finished", ready ? 1.0 : 0.0);
+
+            out.gauge("takeaway_http_queued_tasks", "Connection tasks waiting for an HTTP worker",
+                      static_cast<double>(queuedTasks.load(std::memory_order_relaxed)));
+
+            if (laneScheduler) {
+                for (size_t index = 0; index < LANE_COUNT; ++index) {
+                    const Lane lane = static_cast<Lane>(index);
+                    const LaneStats stats = laneScheduler->stats(lane);
+                    const MetricLabels labels {{"lane", lane_name(lane)}};
+                    out.gauge("takeaway_lane_active", "Requests running in the lane", static_cast<double>(stats.active), labels);
+                    out.gauge("takeaway_lane_waiting", "Requests queued for the lane", static_cast<double>(stats.waiting), labels);
+                    out.gauge("takeaway_lane_limit", "Current concurrency limit of the lane", static_cast<double>(stats.limit), labels);
+                }
+                for (size_t index = 0; index < LANE_COUNT; ++index) {
+                    const Lane lane = static_cast<Lane>(index);
+                    const LaneStats stats = laneScheduler->stats(lane);
+                    const MetricLabels labels {{"lane", lane_name(lane)}};
+                    out.counter("takeaway_lane_rejected_total", "Requests rejected because the lane queue was full",
+                                static_cast<double>(stats.rejected), labels);
+                    out.counter("takeaway_lane_timeouts_total", "Requests that timed out waiting for the lane",
+                                static_cast<double>(stats.timeouts), labels);
+                }
+            }
+
+            if (catalogCache) {
+                const CatalogStats catalog = catalogCache->stats();
+                out.counter("takeaway_cache_hits_total", "Cache hits", static_cast<double>(catalog.hits), {{"cache", "catalog"}});
+                out.counter("takeaway_cache_misses_total", "Cache misses", static_cast<double>(catalog.misses), {{"cache", "catalog"}});
+                out.counter("takeaway_cache_invalidations_total", "Cache invalidations", static_cast<double>(catalog.invalidations), {{"cache", "catalog"}});
+                out.counter("takeaway_cache_evictions_total", "Entries removed because they expired or the cache was full",
+                            static_cast<double>(catalog.evictions), {{"cache", "catalog"}});
+                out.gauge("takeaway_cache_entries", "Entries held by the cache", static_cast<double>(catalog.entries), {{"cache", "catalog"}});
+            }
+            if (responseCache) {
+                const ResponseCacheStats response = responseCache->stats();
+                out.counter("takeaway_cache_hits_total", "Cache hits", static_cast<double>(response.hits), {{"cache", "response"}});
+                out.counter("takeaway_cache_misses_total", "Cache misses", static_cast<double>(response.misses), {{"cache", "response"}});
+                out.counter("takeaway_cache_invalidations_total", "Cache invalidations", static_cast<double>(response.invalidations), {{"cache", "response"}});
+                out.counter("takeaway_cache_coalesced_total", "Cache misses served by a concurrent identical load",
+                            static_cast<double>(response.coalesced), {{"cache", "response"}});
+                out.counter("takeaway_cache_evictions_total", "Entries removed because they expired or the cache was full",
+                            static_cast<double>(response.evictions), {{"cache", "response"}});
+                out.counter("takeaway_cache_skipped_total", "Responses built on a miss but not stored",
+                            static_cast<double>(response.skipped), {{"cache", "response"}});
+                out.gauge("takeaway_cache_entries", "Entries held by the cache", static_cast<double>(response.entries), {{"cache", "response"}});
+                out.gauge("takeaway_cache_bytes", "Bytes held by the response cache, including gzip copies",
+                          static_cast<double>(response.bytes), {{"cache", "response"}});
+            }
+
+            if (searchIndex) {
+                const SearchStats search = searchIndex->stats();
+                out.counter("takeaway_search_queries_total", "Search index lookups", static_cast<double>(search.queries));
+                out.counter("takeaway_search_rebuilds_total", "Full search index reloads", static_cast<double>(search.rebuilds));
+                out.counter("takeaway_search_load_failures_total", "Failed initial search index loads", static_cast<double>(search.loadFailures));
+                out.counter("takeaway_search_rejected_total", "Search lookups refused while waiting to retry the initial load",
+                            static_cast<double>(search.rejected));
+                out.gauge("takeaway_search_documents", "Documents in the search index",
+                          static_cast<double>(search.merchants), {{"kind", "merchant"}});
+                out.gauge("takeaway_search_documents", "Documents in the search index",
+                          static_cast<double>(search.dishes), {{"kind", "dish"}});
+            }
+
+            const RequestArenaStats arena = RequestArena::stats();
+            out.counter("takeaway_request_arena_requests_total", "Requests handled inside a per-thread arena",
+                        static_cast<double>(arena.requests));
+            out.counter("takeaway_request_arena_overflows_total", "Requests that outgrew the thread arena and fell back to the heap",
+                        static_cast<double>(arena.overflows));
+            out.counter("takeaway_request_arena_overflow_bytes_total", "Bytes requested from the heap after the thread arena ran out",
+                        static_cast<double>(arena.overflowBytes));
+            out.gauge("takeaway_request_arena_reserved_bytes", "Arena buffers held by worker threads",
+                      static_cast<double>(arena.reservedBytes));
+
+            out.counter("takeaway_log_dropped_total", "Log lines dropped because a thread buffer was full",
+                        static_cast<double>(Logger::instance().dropped()));
+        });
     }
 
-    void RestServer::setup_routes() 
+    void RestServer::setup_routes(httplib::Server& server) 
     {
         // 首页测试接口
         server.Get("/", [](const httplib::Request&, httplib::Response& res) {
             res.set_content("TakeAwayPlatform is running!", "text/plain");
         });
         
-        //健康检查接口
+        //健康检查接口：就绪检查，预热期间返回 WARMING
         server.Get("/health", [this](const httplib::Request&, httplib::Response& res) {
-            if (this->is_running() && !this->stopRequested) {
-                res.set_content("OK", "text/plain");
-            } else {
+            if (!this->is_running() || this->stopRequested) {
                 res.set_content("SHUTTING_DOWN", "text/plain");
                 res.status = 503; // Service Unavailable
+            } else if (!this->ready) {
+                res.set_content("WARMING", "text/plain");
+                res.status = 503;
+            } else {
+                res.set_content("OK", "text/plain");
             }
         });
 
-        // 示例路由：获取所有菜品（使用线程池处理）
-        server.Get("/menu", [&](const httplib::Request&, httplib::Response& res) 
-        {
-            threadPool.enqueue([this, &res] {
-                auto db_handler = acquire_db_handler();
-                Json::Value menu = db_handler->query("SELECT * FROM DISH");
-                release_db_handler(std::move(db_handler));
-                
-                res.set_content(menu.toStyledString(), "application/json");
-            });
+        // 存活检查：进程能处理请求即返回 OK，不关心预热
+        server.Get("/live", [this](const httplib::Request&, httplib::Response& res) {
+            if (this->stopRequested) {
+                res.set_content("SHUTTING_DOWN", "text/plain");
+                res.status = 503;
+            } else {
+                res.set_content("OK", "text/plain");
+            }
         });
 
-        // 示例路由：创建订单（使用线程池处理）
-        server.Post("/order", [&](const httplib::Request& req, httplib::Response& res) 
-        {
-            threadPool.enqueue([this, req, &res] {
-                Json::Value order = parse_json(req.body);
-                auto db_handler = acquire_db_handler();
-                
-                // 验证订单数据...
-                // 插入数据库...
-                
-                release_db_handler(std::move(db_handler));
-                res.set_content("{\"status\":\"created\"}", "application/json");
-            });
+        // Prometheus 文本格式的监控指标
+        server.Get("/metrics", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(MetricsRegistry::instance().render(), "text/plain; version=0.0.4");
         });
+
+        // 示例路由：获取所有菜品
+        server.Get("/menu", dispatch("/menu", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) 
+        {
+            try {
+                if (responseCache->enabled()) {
+                    // 结果集直接写成缓存的字节，不构建 Json::Value 树
+                    send_cached(req, res, responseCache->get_body("menu", [this] {
+                        auto db_handler = acquire_read_handler("menu");
+                        mysqlx::SqlResult result = db_handler->execute_result(StmtId::MenuAll);
+                        std::string body;
+                        JsonRowWriter(result).write_all(body);
+                        return body;
+                    }));
+                } else {
+                    auto db_handler = acquire_read_handler("menu");
+                    mysqlx::SqlResult result = db_handler->execute_result(StmtId::MenuAll);
+                    stream_rows(res, std::move(db_handler), std::move(result));
+                }
+            } catch (const std::exception& e) {
+                res.status = 500;
+                res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+            }
+        }));
+
+        // 示例路由：创建订单
+        server.Post("/order", dispatch("/order", Lane::Checkout, [&](const httplib::Request& req, httplib::Response& res) 
+        {
+            Json::Value order = parse_json(req.body);
+            auto db_handler = acquire_db_handler();
+
+            // 验证订单数据...
+            // 插入数据库...
+
+            db_handler.reset();
+            res.set_content("{\"status\":\"created\"}", "application/json");
+        }));
     
         // ====================== 商家接口 ======================
         // ====================== 商家接口 ======================
@@ -234,59 +1223,58 @@ namespace TakeAwayPlatform
 
         
         // ✅✅ 商家添加菜品接口：插入 DISH 表 ✅✅
-        server.Post("/merchant/add_item", [&](const httplib::Request& req, httplib::Response& res) 
+        server.Post("/merchant/add_item", dispatch("/merchant/add_item", Lane::Write, [&](const httplib::Request& req, httplib::Response& res) 
         {
-            threadPool.enqueue([this, req, &res] {
-                try {
-                    Json::Value item = parse_json(req.body);
-
-                    // ✅ 提取字段
-                    std::string name = item["name"].asString();
-                    double price = item["price"].asDouble();
-                    std::string desc = item.get("description", "").asString();
-                    std::string merchantId = item["merchantId"].asString();
-                    std::string categoryId = item["categoryId"].asString();
-                    std::string imageUrl = item.get("imageUrl", "").asString();
-                    int stock = item.get("stock", 0).asInt();
-                    int sales = item.get("sales", 0).asInt();
-                    double rating = item.get("rating", 0.0).asDouble();
-                    int isOnSale = item.get("isOnSale", 1).asInt();
-
-                    std::cout << "/merchant/add_item name: " << name << std::endl;
-                    std::cout << "/merchant/add_item price: " << price << std::endl;
-                    std::cout << "/merchant/add_item desc: " << desc << std::endl;
-                    std::cout << "/merchant/add_item merchantId: " << merchantId << std::endl;
-                    std::cout << "/merchant/add_item categoryId: " << categoryId << std::endl;
-                    std::cout << "/merchant/add_item imageUrl: " << imageUrl << std::endl;
-                    std::cout << "/merchant/add_item stock: " << stock << std::endl;
-                    std::cout << "/merchant/add_item sales: " << sales << std::endl;
-                    std::cout << "/merchant/add_item rating: " << rating << std::endl;
-                    std::cout << "/merchant/add_item isOnSale: " << isOnSale << std::endl;
-                    std::cout.flush();
-
-                    auto db_handler = acquire_db_handler();
-
-                    // ✅ 构造 SQL 插入语句（使用 UUID 生成 dishId）
-                    std::string sql = "INSERT INTO DISH "
-                        "(dishId, merchantId, categoryId, name, description, price, imageUrl, stock, sales, rating, isOnSale) "
-                        "VALUES (UUID(), '" + merchantId + "', '" + categoryId + "', '" + name + "', '" + desc + "', " +
-                        std::to_string(price) + ", '" + imageUrl + "', " + std::to_string(stock) + ", " +
-                        std::to_string(sales) + ", " + std::to_string(rating) + ", " + std::to_string(isOnSale) + ")";
-
-                    db_handler->query(sql);
-                    release_db_handler(std::move(db_handler));
-
-                    res.set_content("{\"status\":\"success\"}", "application/json");
-                } catch (const std::exception& e) {
-                    res.status = 500;
-                    res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
-                }
-            });
-        });
+            try {
+                Json::Value item = parse_json(req.body);
+
+                // ✅ 提取字段
+                std::string name = item["name"].asString();
+                double price = item["price"].asDouble();
+                std::string desc = item.get("description", "").asString();
+                std::string merchantId = item["merchantId"].asString();
+                std::string categoryId = item["categoryId"].asString();
+                std::string imageUrl = item.get("imageUrl", "").asString();
+                int stock = item.get("stock", 0).asInt();
+                int sales = item.get("sales", 0).asInt();
+                double rating = item.get("rating", 0.0).asDouble();
+                int isOnSale = item.get("isOnSale", 1).asInt();
+
+                LOG_DEBUG("/merchant/add_item name: " << name << ", price: " << price
+                    << ", merchantId: " << merchantId << ", categoryId: " << categoryId
+                    << ", stock: " << stock << ", isOnSale: " << isOnSale);
+
+                auto db_handler = acquire_db_handler();
+
+                // ✅ 插入菜品（dishId 在服务端生成，便于同步搜索索引）
+                const std::string dishId = generate_uuid();
+                db_handler->execute(StmtId::DishInsert,
+                    dishId, merchantId, categoryId, name, desc, price, imageUrl, stock, sales, rating, isOnSale);
+                db_handler.reset();
+                invalidate_catalog(merchantId);
+
+                Json::Value indexed;
+                indexed["dishId"] = dishId;
+                indexed["merchantId"] = merchantId;
+                indexed["name"] = name;
+                indexed["price"] = price;
+                indexed["imageUrl"] = imageUrl;
+                indexed["sales"] = sales;
+                indexed["rating"] = rating;
+                indexed["isOnSale"] = isOnSale;
+                dbRouter->note_write("search");
+                searchIndex->upsert_dish(indexed);
+
+                res.set_content("{\"status\":\"success\"}", "application/json");
+            } catch (const std::exception& e) {
+                res.status = 500;
+                res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+            }
+        }));
 // 添加商家的接口      
-server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response& res)
+server.Post("/merchant/add", dispatch("/merchant/add", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/merchant/add request body: " << req.body << std::endl;
+    LOG_DEBUG("/merchant/add request body: " << req.body);
 
     Json::Value merchant = parse_json(req.body);
 
@@ -299,69 +1287,51 @@ server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response&
     const bool isOpen = merchant.get("isOpen", false).asBool();
     const std::string status = merchant.get("status", "pending").asString();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[添加商家] name: " << name << std::endl;
-
-            auto db = acquire_db_handler();
-            const std::string merchantId = generate_uuid();
-
-            std::ostringstream sql;
-            sql << "INSERT INTO MERCHANT "
-                << "(merchantId, name, description, address, phoneNumber, logoUrl, isOpen, status) "
-                << "VALUES ('" << merchantId << "', '"
-                << name << "', '" 
-                << desc << "', '" 
-                << address << "', '"
-                << phone << "', '" 
-                << logo << "', "
-                << (isOpen ? "1" : "0") << ", '" 
-                << status << "')";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // ✅ 返回插入内容
-            Json::Value insertedMerchant;
-            insertedMerchant["merchantId"] = merchantId;
-            insertedMerchant["name"] = name;
-            insertedMerchant["description"] = desc;
-            insertedMerchant["address"] = address;
-            insertedMerchant["phoneNumber"] = phone;
-            insertedMerchant["logoUrl"] = logo;
-            insertedMerchant["isOpen"] = isOpen;
-            insertedMerchant["status"] = status;
-
-            response["status"] = "success";
-            response["message"] = "商家添加成功！";
-            response["merchant"] = insertedMerchant;
+    Json::Value response;
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+    try {
+        LOG_DEBUG("[添加商家] name: " << name);
 
-        return response.toStyledString();
-    });
+        auto db = acquire_db_handler();
+        const std::string merchantId = generate_uuid();
+
+        db->execute(StmtId::MerchantInsert,
+            merchantId, name, desc, address, phone, logo, isOpen ? 1 : 0, status);
+        db.reset();
+
+        // ✅ 返回插入内容
+        Json::Value insertedMerchant;
+        insertedMerchant["merchantId"] = merchantId;
+        insertedMerchant["name"] = name;
+        insertedMerchant["description"] = desc;
+        insertedMerchant["address"] = address;
+        insertedMerchant["phoneNumber"] = phone;
+        insertedMerchant["logoUrl"] = logo;
+        insertedMerchant["isOpen"] = isOpen;
+        insertedMerchant["status"] = status;
+
+        Json::Value indexed = insertedMerchant;
+        indexed["isOpen"] = isOpen ? 1 : 0;
+        indexed["registrationDate"] = current_time_string();
+        dbRouter->note_write("search");
+        searchIndex->upsert_merchant(indexed);
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "商家添加成功！";
+        response["merchant"] = insertedMerchant;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
         
 //添加菜品分类
- server.Post("/merchant/add_category", [&](const httplib::Request& req, httplib::Response& res)
+ server.Post("/merchant/add_category", dispatch("/merchant/add_category", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/merchant/add_category request body: " << req.body << std::endl;
+    LOG_DEBUG("/merchant/add_category request body: " << req.body);
 
     Json::Value category = parse_json(req.body);
 
@@ -371,62 +1341,42 @@ server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response&
     const std::string categoryName = category["categoryName"].asString();
     const int sortOrder = category["sortOrder"].asInt();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[添加分类] categoryId: " << categoryId << std::endl;
-            std::cout << "[添加分类] merchantId: " << merchantId << std::endl;
-            std::cout << "[添加分类] categoryName: " << categoryName << std::endl;
-            std::cout << "[添加分类] sortOrder: " << sortOrder << std::endl;
-
-            auto db = acquire_db_handler();
+    Json::Value response;
 
-            std::ostringstream sql;
-            sql << "INSERT INTO DISH_CATEGORY "
-                << "(categoryId, merchantId, categoryName, sortOrder) "
-                << "VALUES ('" << categoryId << "', '"
-                << merchantId << "', '"
-                << categoryName << "', "
-                << sortOrder << ")";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // ✅ 返回插入内容
-            Json::Value insertedCategory;
-            insertedCategory["categoryId"] = categoryId;
-            insertedCategory["merchantId"] = merchantId;
-            insertedCategory["categoryName"] = categoryName;
-            insertedCategory["sortOrder"] = sortOrder;
+    try {
+        LOG_DEBUG("[添加分类] categoryId: " << categoryId);
+        LOG_DEBUG("[添加分类] merchantId: " << merchantId);
+        LOG_DEBUG("[添加分类] categoryName: " << categoryName);
+        LOG_DEBUG("[添加分类] sortOrder: " << sortOrder);
 
-            response["status"] = "success";
-            response["message"] = "分类添加成功！";
-            response["category"] = insertedCategory;
+        auto db = acquire_db_handler();
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+        db->execute(StmtId::CategoryInsert, categoryId, merchantId, categoryName, sortOrder);
+        db.reset();
+        invalidate_catalog(merchantId);
 
-        return response.toStyledString();
-    });
+        // ✅ 返回插入内容
+        Json::Value insertedCategory;
+        insertedCategory["categoryId"] = categoryId;
+        insertedCategory["merchantId"] = merchantId;
+        insertedCategory["categoryName"] = categoryName;
+        insertedCategory["sortOrder"] = sortOrder;
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "分类添加成功！";
+        response["category"] = insertedCategory;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
 // 添加菜品
-  server.Post("/merchant/add_dish", [&](const httplib::Request& req, httplib::Response& res)
+  server.Post("/merchant/add_dish", dispatch("/merchant/add_dish", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/merchant/add_dish request body: " << req.body << std::endl;
+    LOG_DEBUG("/merchant/add_dish request body: " << req.body);
 
     Json::Value dish = parse_json(req.body);
 
@@ -443,64 +1393,60 @@ server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response&
     const double rating = dish["rating"].asDouble();
     const bool isOnSale = dish["isOnSale"].asBool();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[添加菜品] dishId: " << dishId << std::endl;
-
-            auto db = acquire_db_handler();
+    Json::Value response;
 
-            std::ostringstream sql;
-            sql << "INSERT INTO DISH (dishId, merchantId, categoryId, name, description, price, imageUrl, stock, sales, rating, isOnSale) "
-                << "VALUES ('" << dishId << "', '" << merchantId << "', '" << categoryId << "', '"
-                << name << "', '" << description << "', " << price << ", '" << imageUrl << "', "
-                << stock << ", " << sales << ", " << rating << ", " << (isOnSale ? "1" : "0") << ")";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // ✅ 返回插入内容
-            Json::Value insertedDish;
-            insertedDish["dishId"] = dishId;
-            insertedDish["merchantId"] = merchantId;
-            insertedDish["categoryId"] = categoryId;
-            insertedDish["name"] = name;
-            insertedDish["description"] = description;
-            insertedDish["price"] = price;
-            insertedDish["imageUrl"] = imageUrl;
-            insertedDish["stock"] = stock;
-            insertedDish["sales"] = sales;
-            insertedDish["rating"] = rating;
-            insertedDish["isOnSale"] = isOnSale;
-
-            response["status"] = "success";
-            response["message"] = "菜品添加成功！";
-            response["dish"] = insertedDish;
+    try {
+        LOG_DEBUG("[添加菜品] dishId: " << dishId);
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+        auto db = acquire_db_handler();
 
-        return response.toStyledString();
-    });
+        db->execute(StmtId::DishInsert,
+            dishId, merchantId, categoryId, name, description, price, imageUrl,
+            stock, sales, rating, isOnSale ? 1 : 0);
+        db.reset();
+        invalidate_catalog(merchantId);
+
+        // ✅ 返回插入内容
+        Json::Value insertedDish;
+        insertedDish["dishId"] = dishId;
+        insertedDish["merchantId"] = merchantId;
+        insertedDish["categoryId"] = categoryId;
+        insertedDish["name"] = name;
+        insertedDish["description"] = description;
+        insertedDish["price"] = price;
+        insertedDish["imageUrl"] = imageUrl;
+        insertedDish["stock"] = stock;
+        insertedDish["sales"] = sales;
+        insertedDish["rating"] = rating;
+        insertedDish["isOnSale"] = isOnSale;
+
+        Json::Value indexed;
+        indexed["dishId"] = dishId;
+        indexed["merchantId"] = merchantId;
+        indexed["name"] = name;
+        indexed["price"] = price;
+        indexed["imageUrl"] = imageUrl;
+        indexed["sales"] = sales;
+        indexed["rating"] = rating;
+        indexed["isOnSale"] = isOnSale ? 1 : 0;
+        dbRouter->note_write("search");
+        searchIndex->upsert_dish(indexed);
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "菜品添加成功！";
+        response["dish"] = insertedDish;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
  //用户注册    
- server.Post("/user/register", [&](const httplib::Request& req, httplib::Response& res)
+ server.Post("/user/register", dispatch("/user/register", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/user/register request body: " << req.body << std::endl;
+    LOG_DEBUG("/user/register request body: " << req.body);
 
     Json::Value user = parse_json(req.body);
 
@@ -514,67 +1460,44 @@ server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response&
     const std::string avatarUrl = user.get("avatarUrl", "").asString();
     const std::string gender = user.get("gender", "").asString();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[用户注册] userId: " << userId << std::endl;
-            std::cout << "[用户注册] username: " << username << std::endl;
+    Json::Value response;
 
-            auto db = acquire_db_handler();
-
-            std::ostringstream sql;
-            sql << "INSERT INTO USER (userId, username, passwordHash, email, phoneNumber, status, avatarUrl, gender) "
-                << "VALUES ('" << userId << "', '"
-                << username << "', '"
-                << passwordHash << "', '"
-                << email << "', '"
-                << phoneNumber << "', '"
-                << status << "', '"
-                << avatarUrl << "', '"
-                << gender << "')";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // ✅ 返回插入内容（注意：不返回敏感信息如passwordHash）
-            Json::Value insertedUser;
-            insertedUser["userId"] = userId;
-            insertedUser["username"] = username;
-            insertedUser["email"] = email;
-            insertedUser["phoneNumber"] = phoneNumber;
-            insertedUser["status"] = status;
-            insertedUser["avatarUrl"] = avatarUrl;
-            insertedUser["gender"] = gender;
+    try {
+        LOG_DEBUG("[用户注册] userId: " << userId);
+        LOG_DEBUG("[用户注册] username: " << username);
 
-            response["status"] = "success";
-            response["message"] = "用户注册成功！";
-            response["user"] = insertedUser;
+        auto db = acquire_db_handler();
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+        db->execute(StmtId::UserInsert,
+            userId, username, passwordHash, email, phoneNumber, status, avatarUrl, gender);
+        db.reset();
 
-        return response.toStyledString();
-    });
+        // ✅ 返回插入内容（注意：不返回敏感信息如passwordHash）
+        Json::Value insertedUser;
+        insertedUser["userId"] = userId;
+        insertedUser["username"] = username;
+        insertedUser["email"] = email;
+        insertedUser["phoneNumber"] = phoneNumber;
+        insertedUser["status"] = status;
+        insertedUser["avatarUrl"] = avatarUrl;
+        insertedUser["gender"] = gender;
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "用户注册成功！";
+        response["user"] = insertedUser;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
 
         //用户登录接口       
- server.Post("/merchant/login_user", [&](const httplib::Request& req, httplib::Response& res)
+ server.Post("/merchant/login_user", dispatch("/merchant/login_user", Lane::Auth, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/merchant/login_user request body: " << req.body << std::endl;
+    LOG_DEBUG("/merchant/login_user request body: " << req.body);
 
     Json::Value loginReq = parse_json(req.body);
 
@@ -582,95 +1505,72 @@ server.Post("/merchant/add", [&](const httplib::Request& req, httplib::Response&
     const std::string username = loginReq["username"].asString();
     const std::string passwordHash = loginReq["passwordHash"].asString();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
+    Json::Value response;
 
-        try {
-            std::cout << "[用户登录] userId: " << userId << std::endl;
-            std::cout << "[用户登录] username: " << username << std::endl;
-
-            auto db = acquire_db_handler();
+    try {
+        LOG_DEBUG("[用户登录] userId: " << userId);
+        LOG_DEBUG("[用户登录] username: " << username);
 
-            std::ostringstream sql;
-            sql << "SELECT userId, username, email, phoneNumber, status, avatarUrl, gender "
-                << "FROM USER WHERE userId = '" << userId
-                << "' AND username = '" << username
-                << "' AND passwordHash = '" << passwordHash << "'";
-
-            std::cout << "[用户登录] 执行查询 SQL: " << sql.str() << std::endl;
-
-            auto result = db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            if (!result.empty()) {
-                std::cout << "[用户登录] 查询成功：可以登录！" << std::endl;
-                
-                // 获取第一条记录(应该只有一条)
-                auto row = result[0];
-                
-                // ✅ 返回用户信息(不含敏感信息)
-                Json::Value userInfo;
-                userInfo["userId"] = row["userId"];
-                userInfo["username"] = row["username"];
-                userInfo["email"] = row["email"];
-                userInfo["phoneNumber"] = row["phoneNumber"];
-                userInfo["status"] = row["status"];
-                userInfo["avatarUrl"] = row["avatarUrl"];
-                userInfo["gender"] = row["gender"];
+        auto db = acquire_db_handler();
 
-                response["status"] = "success";
-                response["message"] = "登录成功";
-                response["user"] = userInfo;
-                
-                // 可以添加token或session信息
-                // response["token"] = generate_auth_token(userId);
-                
-            } else {
-                response["status"] = "fail";
-                response["message"] = "用户名或密码错误";
-            }
+        auto result = db->execute(StmtId::UserLogin, userId, username, passwordHash);
+        db.reset();
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+        if (!result.empty()) {
+            LOG_DEBUG("[用户登录] 查询成功：可以登录！");
+            
+            // 获取第一条记录(应该只有一条)
+            auto row = result[0];
+            
+            // ✅ 返回用户信息(不含敏感信息)
+            Json::Value userInfo;
+            userInfo["userId"] = row["userId"];
+            userInfo["username"] = row["username"];
+            userInfo["email"] = row["email"];
+            userInfo["phoneNumber"] = row["phoneNumber"];
+            userInfo["status"] = row["status"];
+            userInfo["avatarUrl"] = row["avatarUrl"];
+            userInfo["gender"] = row["gender"];
 
-        return response.toStyledString();
-    });
+            response["status"] = "success";
+            response["message"] = "登录成功";
+            response["user"] = userInfo;
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+            // 之后的请求携带 Authorization: Bearer <token>，由会话缓存校验，不再查库
+            response["token"] = sessionCache->issue("user", row["userId"].asString());
+            response["expiresIn"] = static_cast<Json::Int64>(sessionCache->ttl().count());
 
-    try {
-        std::string result = result_future.get();
-        if (result.find("\"status\":\"fail\"") != std::string::npos) {
-            res.status = 401;
+        } else {
+            response["status"] = "fail";
+            response["message"] = "用户名或密码错误";
         }
-        res.set_content(result, "application/json");
+
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
+    }
+
+    std::string result = to_json(response);
+    if (result.find("\"status\":\"fail\"") != std::string::npos) {
+        res.status = 401;
     }
-});
+    res.set_content(result, "application/json");
+}));
     
         // 添加订单接口
-server.Post("/order/create", [&](const httplib::Request& req, httplib::Response& res) {
+server.Post("/order/create", dispatch("/order/create", Lane::Checkout, [&](const httplib::Request& req, httplib::Response& res) {
     try {
-        std::cout << "/order/create request body: " << req.body << std::endl;
+        LOG_DEBUG("/order/create request body: " << req.body);
 
         // 解析JSON
-        Json::Value order;
-        Json::CharReaderBuilder reader;
-        std::string errors;
-        std::istringstream jsonStream(req.body);
-        
-        if (!Json::parseFromStream(reader, jsonStream, &order, &errors)) {
-            throw std::runtime_error("JSON解析错误: " + errors);
-        }
+        Json::Value order = parse_json(req.body);
 
         // 生成订单ID（如果未提供）
         const std::string orderId = order.get("orderId", generate_uuid()).asString();
-        const std::string userId = order["userId"].asString();
+        std::string userId = order["userId"].asString();
+        if (!resolve_user(req, res, userId)) {
+            return;
+        }
         const std::string merchantId = order["merchantId"].asString();
         const std::string addressId = order["addressId"].asString();
         const std::string remark = order.get("remark", "").asString();
@@ -687,42 +1587,119 @@ server.Post("/order/create", [&](const httplib::Request& req, httplib::Response&
         std::string actualDeliveryTime = order.get("actualDeliveryTime", estimatedDeliveryTime).asString();
 
         // 日志输出
-        std::cout << "[订单接口] 创建订单 - orderId: " << orderId << std::endl;
-        std::cout << "[订单接口] userId: " << userId << ", merchantId: " << merchantId << std::endl;
-        std::cout << "[订单接口] 总价: " << totalPrice << ", 订单时间: " << orderTime << std::endl;
-
-        auto db = acquire_db_handler();
+        LOG_DEBUG("[订单接口] 创建订单 - orderId: " << orderId);
+        LOG_DEBUG("[订单接口] userId: " << userId << ", merchantId: " << merchantId);
+        LOG_DEBUG("[订单接口] 总价: " << totalPrice << ", 订单时间: " << orderTime);
 
-        // 插入订单主表
-        std::ostringstream order_sql;
-        order_sql << "INSERT INTO `ORDER` (orderId, userId, merchantId, totalPrice, status, orderTime, paymentTime, "
-                << "estimatedDeliveryTime, actualDeliveryTime, addressId, remark) VALUES ('"
-                << orderId << "', '" << userId << "', '" << merchantId << "', " << totalPrice
-                << ", 'PENDING_PAYMENT', '" << orderTime << "', '" << paymentTime << "', '"
-                << estimatedDeliveryTime << "', '" << actualDeliveryTime << "', '"
-                << addressId << "', '" << remark << "')";
-
-        db->query(order_sql.str());
-
-        // 插入订单项
+        // 整理订单项：逐行准备批量插入的参数，同一菜品的数量合并后用于扣减库存
         const Json::Value& items = order["items"];
-        int itemCount = 0;
+        if (!items.isArray() || items.empty()) {
+            throw std::invalid_argument("订单项不能为空");
+        }
+
+        BoundValues itemParams(RequestArena::resource());
+        itemParams.reserve(items.size() * 6);
+        std::map<std::string, int> dishQuantities;   // 按 dishId 有序，保证各事务加行锁的顺序一致
         for (const auto& item : items) {
-            const std::string orderItemId = generate_uuid();
             const std::string dishId = item["dishId"].asString();
-            const std::string dishName = item["dishName"].asString();
-            double price = item["price"].asDouble();
-            int quantity = item["quantity"].asInt();
+            const int quantity = item["quantity"].asInt();
+            if (dishId.empty() || quantity <= 0) {
+                throw std::invalid_argument("订单项缺少菜品或数量无效");
+            }
+
+            itemParams.emplace_back(generate_uuid());
+            itemParams.emplace_back(orderId);
+            itemParams.emplace_back(dishId);
+            itemParams.emplace_back(item["dishName"].asString());
+            itemParams.emplace_back(item["price"].asDouble());
+            itemParams.emplace_back(quantity);
+
+            dishQuantities[dishId] += quantity;
+        }
+        const int itemCount = static_cast<int>(items.size());
+
+        BoundValues stockParams(RequestArena::resource());
+        stockParams.reserve(dishQuantities.size() * 2);
+        for (const auto& entry : dishQuantities) {
+            stockParams.emplace_back(entry.first);
+            stockParams.emplace_back(entry.second);
+        }
+
+        // 一条语句扣减全部菜品库存，任一菜品库存不足则抛出，由调用方的事务回滚
+        auto deduct_stock = [&](DatabaseHandler& db) {
+            const uint64_t updated = db.update_sql(dish_stock_deduct_sql(dishQuantities.size()), stockParams);
+            if (updated != dishQuantities.size()) {
+                throw OutOfStockError("库存不足或菜品不存在");
+            }
+        };
+        auto insert_order = [&](DatabaseHandler& db) {
+            db.execute(StmtId::OrderInsert,
+                orderId, userId, merchantId, totalPrice, orderTime, paymentTime,
+                estimatedDeliveryTime, actualDeliveryTime, addressId, remark);
+        };
+        auto insert_items = [&](DatabaseHandler& db) {
+            // 全部订单项一次多行插入
+            db.update_sql(multi_row_sql(StmtId::OrderItemInsert, items.size()), itemParams);
+        };
+
+        const size_t shard = orderShards->shard_for_user(userId);
+        if (inventory->enabled()) {
+            // 库存在内存中预留，订单写入不再锁 DISH 行；支付成功后确认，售出量由后台写回
+            if (!inventory->reserve(orderId, dishQuantities)) {
+                throw OutOfStockError("库存不足或菜品不存在");
+            }
+
+            try {
+                auto db = orderShards->lease(shard);
+                Transaction transaction(*db);
+                insert_order(*db);
+                insert_items(*db);
+                transaction.commit();
+            } catch (const std::exception&) {
+                inventory->release(orderId);
+                throw;
+            }
+        } else if (orderShards->colocated()) {
+            auto db = acquire_db_handler();
+
+            // 订单、库存与订单项在同一事务中完成，任何一步失败整体回滚
+            Transaction transaction(*db);
+
+            // 库存扣减先于订单项插入执行，
+            // 避免外键检查的共享锁升级为排他锁时与其他下单事务互相死锁
+            insert_order(*db);
+            deduct_stock(*db);
+            insert_items(*db);
 
-            std::ostringstream item_sql;
-            item_sql << "INSERT INTO ORDER_ITEM (orderItemId, orderId, dishId, dishName, price, quantity) VALUES ('"
-                    << orderItemId << "', '" << orderId << "', '" << dishId << "', '" << dishName << "', "
-                    << price << ", " << quantity << ")";
-            db->query(item_sql.str());
-            itemCount++;
+            transaction.commit();
+        } else {
+            // 订单表在分片上，菜品表在主库：先在主库扣减库存，再在用户所在分片写入订单
+            {
+                auto db = acquire_db_handler();
+                Transaction transaction(*db);
+                deduct_stock(*db);
+                transaction.commit();
+            }
+
+            try {
+                auto shardDb = orderShards->lease(shard);
+                Transaction transaction(*shardDb);
+                insert_order(*shardDb);
+                insert_items(*shardDb);
+                transaction.commit();
+            } catch (const std::exception&) {
+                // 分片写入失败：补还已扣减的库存
+                try {
+                    auto db = acquire_db_handler();
+                    db->update_sql(dish_stock_restore_sql(dishQuantities.size()), stockParams);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("[订单接口] 库存补偿失败 orderId: " << orderId << ", " << e.what());
+                }
+                throw;
+            }
         }
-        
-        release_db_handler(std::move(db));
+        orderShards->remember_order(orderId, shard);
+        dbRouter->note_write("user:" + userId);
 
         // ========== 构建标准化的JSON响应 ==========
         Json::Value response;
@@ -745,30 +1722,42 @@ server.Post("/order/create", [&](const httplib::Request& req, httplib::Response&
         response["data"] = orderData;
 
    // 转换为JSON字符串并设置响应
-        Json::StreamWriterBuilder writer;
-        std::string jsonResponse = Json::writeString(writer, response);
+        std::string jsonResponse = to_json(response);
         res.set_content(jsonResponse, "application/json");
 
+    } catch (const OutOfStockError& e) {
+        Json::Value errorResponse;
+        errorResponse["code"] = 409;
+        errorResponse["message"] = "订单创建失败: " + std::string(e.what());
+
+        res.status = 409;
+        res.set_content(to_json(errorResponse), "application/json");
+    } catch (const std::invalid_argument& e) {
+        Json::Value errorResponse;
+        errorResponse["code"] = 400;
+        errorResponse["message"] = "订单创建失败: " + std::string(e.what());
+
+        res.status = 400;
+        res.set_content(to_json(errorResponse), "application/json");
     } catch (const std::exception& e) {
         // 错误处理 - 确保返回JSON格式错误信息
         Json::Value errorResponse;
         errorResponse["code"] = 500;
         errorResponse["message"] = "订单创建失败: " + std::string(e.what());
         
-        Json::StreamWriterBuilder writer;
-        std::string errorJson = Json::writeString(writer, errorResponse);
+        std::string errorJson = to_json(errorResponse);
         res.status = 500;
         res.set_content(errorJson, "application/json");
         
-        std::cerr << "[订单接口] 错误: " << e.what() << std::endl;
+        LOG_ERROR_RATE(10, "[订单接口] 错误: " << e.what());
     }
-});
+}));
 
          //用户地址插入接口
          //用户地址插入接口
- server.Post("/merchant/add_user_address", [&](const httplib::Request& req, httplib::Response& res) 
+ server.Post("/merchant/add_user_address", dispatch("/merchant/add_user_address", Lane::Write, [&](const httplib::Request& req, httplib::Response& res) 
 {
-    std::cout << "/merchant/add_user_address request body: " << req.body << std::endl;
+    LOG_DEBUG("/merchant/add_user_address request body: " << req.body);
 
     Json::Value address = parse_json(req.body);
 
@@ -779,64 +1768,43 @@ server.Post("/order/create", [&](const httplib::Request& req, httplib::Response&
     const std::string fullAddress = address["fullAddress"].asString();
     const int isDefault = address.get("isDefault", 0).asInt();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[用户地址接口] addressId: " << addressId << std::endl;
-
-            auto db = acquire_db_handler();
+    Json::Value response;
 
-            std::ostringstream sql;
-            sql << "INSERT INTO USER_ADDRESS (addressId, userId, recipientName, phoneNumber, fullAddress, isDefault) "
-                << "VALUES ('" << addressId << "', '"
-                << userId << "', '"
-                << recipientName << "', '"
-                << phoneNumber << "', '"
-                << fullAddress << "', "
-                << isDefault << ")";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // 返回插入内容
-            Json::Value insertedAddress;
-            insertedAddress["addressId"] = addressId;
-            insertedAddress["userId"] = userId;
-            insertedAddress["recipientName"] = recipientName;
-            insertedAddress["phoneNumber"] = phoneNumber;
-            insertedAddress["fullAddress"] = fullAddress;
-            insertedAddress["isDefault"] = isDefault;
+    try {
+        LOG_DEBUG("[用户地址接口] addressId: " << addressId);
 
-            response["status"] = "success";
-            response["message"] = "地址添加成功！";
-            response["address"] = insertedAddress;
+        auto db = acquire_db_handler();
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
-        }
+        db->execute(StmtId::AddressInsert,
+            addressId, userId, recipientName, phoneNumber, fullAddress, isDefault);
+        db.reset();
 
-        return response.toStyledString();
-    });
+        // 返回插入内容
+        Json::Value insertedAddress;
+        insertedAddress["addressId"] = addressId;
+        insertedAddress["userId"] = userId;
+        insertedAddress["recipientName"] = recipientName;
+        insertedAddress["phoneNumber"] = phoneNumber;
+        insertedAddress["fullAddress"] = fullAddress;
+        insertedAddress["isDefault"] = isDefault;
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "地址添加成功！";
+        response["address"] = insertedAddress;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
 
   //添加对于菜品评论
 
-server.Post("/comment/add", [&](const httplib::Request& req, httplib::Response& res)
+server.Post("/comment/add", dispatch("/comment/add", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
-    std::cout << "/comment/add request body: " << req.body << std::endl;
+    LOG_DEBUG("/comment/add request body: " << req.body);
 
     Json::Value comment = parse_json(req.body);
 
@@ -846,74 +1814,89 @@ server.Post("/comment/add", [&](const httplib::Request& req, httplib::Response&
     const int rating = comment.get("rating", 5).asInt();
     const std::string content = comment.get("content", "").asString();
 
-    auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([=]() {
-        Json::Value response;
-
-        try {
-            std::cout << "[添加评论] commentId: " << commentId << std::endl;
+    Json::Value response;
 
-            auto db = acquire_db_handler();
+    try {
+        LOG_DEBUG("[添加评论] commentId: " << commentId);
 
-            std::ostringstream sql;
-            sql << "INSERT INTO USER_COMMENT "
-                << "(commentId, userId, dishId, rating, content, commentTime) "
-                << "VALUES ('" << commentId << "', '"
-                << userId << "', '"
-                << dishId << "', "
-                << rating << ", '"
-                << content << "', NOW())";
-
-            db->query(sql.str());
-            release_db_handler(std::move(db));
-
-            // 返回插入内容
-            Json::Value insertedComment;
-            insertedComment["commentId"] = commentId;
-            insertedComment["userId"] = userId;
-            insertedComment["dishId"] = dishId;
-            insertedComment["rating"] = rating;
-            insertedComment["content"] = content;
-            insertedComment["commentTime"] = RestServer::current_time_string();
+        if (rating < RATING_MIN || rating > RATING_MAX) {
+            throw std::invalid_argument("评分必须在 1 到 5 之间");
+        }
 
-            response["status"] = "success";
-            response["message"] = "评论添加成功！";
-            response["comment"] = insertedComment;
+        const std::string commentTime = RestServer::current_time_string();
+        if (writeBehind->enabled()) {
+            // 放入写入队列即返回，由后台线程合并成批量 INSERT
+            Json::Value row(Json::arrayValue);
+            row.append(commentId);
+            row.append(userId);
+            row.append(dishId.empty() ? Json::Value() : Json::Value(dishId));
+            row.append(rating);
+            row.append(content);
+            row.append(commentTime);
+            WriteBehindQueue::RowHook addRating;
+            if (!dishId.empty()) {
+                addRating = [dishId, rating](DatabaseHandler& db) {
+                    add_rating(db, RatingTarget::Dish, dishId, rating);
+                };
+            }
+            const bool queued = writeBehind->enqueue(StmtId::CommentInsertAt, WRITE_TARGET_PRIMARY, std::move(row),
+                [this, dishId] {
+                    if (!dishId.empty()) {
+                        dbRouter->note_write("dish:" + dishId);
+                        responseCache->invalidate("dish-reviews/" + dishId);
+                    }
+                },
+                std::move(addRating));
+            if (!queued) {
+                respond_busy(res);
+                return;
+            }
+        } else {
+            auto db = acquire_db_handler();
 
-        } catch (const std::exception& e) {
-            response["status"] = "error";
-            response["message"] = e.what();
+            // 评论与评分汇总在同一事务中写入
+            Transaction tx(*db);
+            db->execute(StmtId::CommentInsert, commentId, userId, nullable(dishId), rating, content);
+            if (!dishId.empty()) {
+                add_rating(*db, RatingTarget::Dish, dishId, rating);
+            }
+            tx.commit();
+            db.reset();
+            if (!dishId.empty()) {
+                dbRouter->note_write("dish:" + dishId);
+                responseCache->invalidate("dish-reviews/" + dishId);
+            }
         }
 
-        return response.toStyledString();
-    });
+        // 返回插入内容
+        Json::Value insertedComment;
+        insertedComment["commentId"] = commentId;
+        insertedComment["userId"] = userId;
+        insertedComment["dishId"] = dishId;
+        insertedComment["rating"] = rating;
+        insertedComment["content"] = content;
+        insertedComment["commentTime"] = commentTime;
 
-    std::future<std::string> result_future = task_ptr->get_future();
-    threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+        response["status"] = "success";
+        response["message"] = "评论添加成功！";
+        response["comment"] = insertedComment;
 
-    try {
-        std::string result = result_future.get();
-        res.set_content(result, "application/json");
     } catch (const std::exception& e) {
-        res.status = 500;
-        res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
+        response["status"] = "error";
+        response["message"] = e.what();
     }
-});
+
+    res.set_content(to_json(response), "application/json");
+}));
 
              // 添加管理员接口（重点在管理员信息插入）
               // 添加管理员接口（重点在管理员信息插入）
-server.Post("/admin/add_admin", [&](const httplib::Request& req, httplib::Response& res) {
+server.Post("/admin/add_admin", dispatch("/admin/add_admin", Lane::Write, [&](const httplib::Request& req, httplib::Response& res) {
     try {
-        std::cout << "/admin/add_admin request body: " << req.body << std::endl;
+        LOG_DEBUG("/admin/add_admin request body: " << req.body);
 
         // 解析JSON
-        Json::Value admin;
-        Json::CharReaderBuilder reader;
-        std::string errors;
-        std::istringstream jsonStream(req.body);
-        
-        if (!Json::parseFromStream(reader, jsonStream, &admin, &errors)) {
-            throw std::runtime_error("JSON解析错误: " + errors);
-        }
+        Json::Value admin = parse_json(req.body);
 
         // ✅ 自动生成 adminId 和当前时间
         const std::string adminId = generate_admin_id();
@@ -925,25 +1908,14 @@ server.Post("/admin/add_admin", [&](const httplib::Request& req, httplib::Respon
         const std::string role = admin.get("role", "operator").asString(); // 默认为 operator
 
         // ✅ 控制台日志输出
-        std::cout << "[管理员接口] 添加管理员 - adminId: " << adminId << std::endl;
-        std::cout << "[管理员接口] username: " << username << std::endl;
-        std::cout << "[管理员接口] role: " << role << std::endl;
+        LOG_DEBUG("[管理员接口] 添加管理员 - adminId: " << adminId);
+        LOG_DEBUG("[管理员接口] username: " << username);
+        LOG_DEBUG("[管理员接口] role: " << role);
 
         auto db = acquire_db_handler();
 
-        // ✅ 构造SQL插入语句
-        std::ostringstream sql;
-        sql << "INSERT INTO ADMIN_USER (adminId, username, passwordHash, role, lastLogin) VALUES ('"
-            << adminId << "', '"
-            << username << "', '"
-            << passwordHash << "', '"
-            << role << "', '"
-            << currentTime << "')";
-
-        std::cout << "[管理员接口] 执行 SQL: " << sql.str() << std::endl;
-
-        db->query(sql.str());
-        release_db_handler(std::move(db));
+        db->execute(StmtId::AdminInsert, adminId, username, passwordHash, role, currentTime);
+        db.reset();
 
         // ========== 构建标准化的JSON响应 ==========
         Json::Value response;
@@ -960,8 +1932,7 @@ server.Post("/admin/add_admin", [&](const httplib::Request& req, httplib::Respon
         response["data"] = adminData;
 
         // 转换为JSON字符串并设置响应
-        Json::StreamWriterBuilder writer;
-        std::string jsonResponse = Json::writeString(writer, response);
+        std::string jsonResponse = to_json(response);
         res.set_content(jsonResponse, "application/json");
 
     } catch (const std::exception& e) {
@@ -970,21 +1941,20 @@ server.Post("/admin/add_admin", [&](const httplib::Request& req, httplib::Respon
         errorResponse["code"] = 500;
         errorResponse["message"] = "添加管理员失败: " + std::string(e.what());
         
-        Json::StreamWriterBuilder writer;
-        std::string errorJson = Json::writeString(writer, errorResponse);
+        std::string errorJson = to_json(errorResponse);
         res.status = 500;
         res.set_content(errorJson, "application/json");
         
-        std::cerr << "[管理员接口] 错误: " << e.what() << std::endl;
+        LOG_ERROR_RATE(10, "[管理员接口] 错误: " << e.what());
     }
-});
+}));
 
                // 管理员登录接口(关键在于查询)
  // 管理员登录接口
-server.Post("/admin/login_admin", [&](const httplib::Request& req, httplib::Response& res) 
+server.Post("/admin/login_admin", dispatch("/admin/login_admin", Lane::Auth, [&](const httplib::Request& req, httplib::Response& res) 
 {
     try {
-        std::cout << "/admin/login_admin request body: " << req.body << std::endl;
+        LOG_DEBUG("/admin/login_admin request body: " << req.body);
 
         Json::Value loginReq = parse_json(req.body);
 
@@ -992,45 +1962,69 @@ server.Post("/admin/login_admin", [&](const httplib::Request& req, httplib::Resp
         const std::string username = loginReq["username"].asString();
         const std::string passwordHash = loginReq["passwordHash"].asString();
 
-        std::cout << "[管理员登录接口] adminId: " << adminId << std::endl;
-        std::cout << "[管理员登录接口] username: " << username << std::endl;
-        std::cout << "[管理员登录接口] passwordHash: " << passwordHash << std::endl;
+        LOG_DEBUG("[管理员登录接口] adminId: " << adminId);
+        LOG_DEBUG("[管理员登录接口] username: " << username);
 
         auto db = acquire_db_handler();
 
-        std::ostringstream sql;
-        sql << "SELECT * FROM ADMIN_USER WHERE adminId = '" << adminId
-            << "' AND username = '" << username
-            << "' AND passwordHash = '" << passwordHash << "'";
-
-        std::cout << "[管理员登录接口] 执行查询 SQL: " << sql.str() << std::endl;
-
-        auto result = db->query(sql.str());
-        release_db_handler(std::move(db));
+        auto result = db->execute(StmtId::AdminLogin, adminId, username, passwordHash);
+        db.reset();
 
         if (!result.empty()) {
-            std::cout << "[管理员登录接口] 查询成功：可以登录！" << std::endl;
+            LOG_DEBUG("[管理员登录接口] 查询成功：可以登录！");
             
-            // 直接构建并返回JSON字符串
-            std::string jsonResponse = "{\"status\":\"success\", \"message\":\"" + username + "登录成功\"}";
-            res.set_content(jsonResponse, "application/json");
+            Json::Value response;
+            response["status"] = "success";
+            response["message"] = username + "登录成功";
+            response["token"] = sessionCache->issue("admin", adminId);
+            response["expiresIn"] = static_cast<Json::Int64>(sessionCache->ttl().count());
+            res.set_content(to_json(response), "application/json");
             
         } else {
-            std::cout << "[管理员登录接口] 查询失败：未查到对应账号" << std::endl;
+            LOG_DEBUG("[管理员登录接口] 查询失败：未查到对应账号");
             res.status = 401;
             res.set_content("{\"status\":\"fail\", \"message\":\"未查询到对应账号，请检查id/用户名/密码\"}", "application/json");
         }
 
     } catch (const std::exception& e) {
-        std::cout << "[管理员登录接口] 异常错误: " << e.what() << std::endl;
+        LOG_ERROR_RATE(10, "[管理员登录接口] 异常错误: " << e.what());
         res.status = 500;
         res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
     }
-});
+}));
+
+        // 注销登录令牌
+        server.Post("/auth/logout", dispatch("/auth/logout", Lane::Write, [&](const httplib::Request& req, httplib::Response& res) {
+            const std::string token = SessionCache::bearer_token(req.get_header_value("Authorization"));
+            if (token.empty() || !sessionCache->revoke(token)) {
+                res.status = 401;
+                res.set_content("{\"status\":\"fail\", \"message\": \"登录已失效，请重新登录\"}", "application/json");
+                return;
+            }
+            res.set_content("{\"status\":\"success\", \"message\": \"已退出登录\"}", "application/json");
+        }));
+
+        // 查询令牌对应的登录身份
+        server.Get("/auth/session", dispatch("/auth/session", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            const std::optional<Session> session =
+                sessionCache->validate(SessionCache::bearer_token(req.get_header_value("Authorization")));
+            if (!session) {
+                res.status = 401;
+                res.set_content("{\"status\":\"fail\", \"message\": \"登录已失效，请重新登录\"}", "application/json");
+                return;
+            }
+
+            Json::Value response;
+            response["status"] = "success";
+            response["kind"] = session->kind;
+            response["subjectId"] = session->subjectId;
+            response["expiresAt"] = static_cast<Json::Int64>(session->expiresAt);
+            res.set_content(to_json(response), "application/json");
+        }));
 
         // 插入商家评价接口
   // 插入商家评价接口（同步版本）
-server.Post("/review/create", [&](const httplib::Request& req, httplib::Response& res) {
+server.Post("/review/create", dispatch("/review/create", Lane::Write, [&](const httplib::Request& req, httplib::Response& res) {
     try {
         Json::Value review = parse_json(req.body);
 
@@ -1040,20 +2034,51 @@ server.Post("/review/create", [&](const httplib::Request& req, httplib::Response
         int rating = review["rating"].asInt();
         const std::string content = review["content"].asString();
 
-        std::cout << "创建评价 - userId: " << userId << ", merchantId: " << merchantId << std::endl;
+        LOG_DEBUG("创建评价 - userId: " << userId << ", merchantId: " << merchantId);
+
+        if (rating < RATING_MIN || rating > RATING_MAX) {
+            res.status = 400;
+            res.set_content("{\"status\":\"error\", \"message\": \"评分必须在 1 到 5 之间\"}", "application/json");
+            return;
+        }
 
         // 使用自定义函数生成当前时间字符串
         std::string reviewTime = RestServer::current_time_string();
 
-        auto db = acquire_db_handler();
+        if (writeBehind->enabled()) {
+            // 写入成功后再失效评论列表缓存，避免缓存被还没写入的旧列表填回
+            Json::Value row(Json::arrayValue);
+            row.append(reviewId);
+            row.append(userId);
+            row.append(merchantId);
+            row.append(rating);
+            row.append(content);
+            row.append(reviewTime);
+            const bool queued = writeBehind->enqueue(StmtId::ReviewInsert, WRITE_TARGET_PRIMARY, std::move(row),
+                [this, merchantId] {
+                    dbRouter->note_write("reviews:" + merchantId);
+                    responseCache->invalidate("reviews/" + merchantId);
+                },
+                [merchantId, rating](DatabaseHandler& db) {
+                    add_rating(db, RatingTarget::Merchant, merchantId, rating);
+                });
+            if (!queued) {
+                respond_busy(res);
+                return;
+            }
+        } else {
+            auto db = acquire_db_handler();
 
-        std::ostringstream review_sql;
-        review_sql << "INSERT INTO MERCHANT_REVIEW (reviewId, userId, merchantId, rating, content, reviewTime) "
-                << "VALUES ('" << reviewId << "', '" << userId << "', '" << merchantId << "', "
-                << rating << ", '" << content << "', '" << reviewTime << "')";
-        db->query(review_sql.str());
+            // 评价与评分汇总在同一事务中写入
+            Transaction tx(*db);
+            db->execute(StmtId::ReviewInsert, reviewId, userId, merchantId, rating, content, reviewTime);
+            add_rating(*db, RatingTarget::Merchant, merchantId, rating);
+            tx.commit();
 
-        release_db_handler(std::move(db));
+            db.reset();
+            dbRouter->note_write("reviews:" + merchantId);
+            responseCache->invalidate("reviews/" + merchantId);
+        }
 
         // ========== 构建标准化的JSON响应 ==========
         Json::Value response;
@@ -1071,133 +2096,100 @@ server.Post("/review/create", [&](const httplib::Request& req, httplib::Response
         
         response["data"] = reviewData;
 
-        Json::StreamWriterBuilder writer;
-        res.set_content(Json::writeString(writer, response), "application/json");
+        res.set_content(to_json(response), "application/json");
 
     } catch (const std::exception& e) {
         res.status = 500;
         res.set_content("{\"status\":\"error\", \"message\": \"" + std::string(e.what()) + "\"}", "application/json");
     }
-});
+}));
 
         // 查看某个商家的评论列表
-        server.Get(R"(/merchant/reviews)", [&](const httplib::Request& req, httplib::Response& res) {
-            // 拿到路径参数中的 merchantId
-            std::cout << "/merchant/reviews request body: " << req.body << std::endl;
-            Json::Value requestResult = parse_json(req.body);
-            std::string merchantId = requestResult["merchant_id"].asString();
-            std::cout << "/merchant/reviews merchantId: " << merchantId << std::endl;
-
-            // 包装任务
-            auto task_ptr = std::make_shared<std::packaged_task<std::string()> >([this, merchantId]() {
-                std::cout << "[GET] /merchant/" << merchantId << "/reviews" << std::endl;
- 
-                Json::Value response;
-                try {
-                    auto db = acquire_db_handler();
-
-                    std::ostringstream sql;
-                    sql << "SELECT r.reviewId, r.userId, u.username, r.rating, r.content, r.reviewTime "
-                        << "FROM MERCHANT_REVIEW r "
-                        << "LEFT JOIN USER u ON r.userId = u.userId "
-                        << "WHERE r.merchantId = '" << merchantId << "' "
-                        << "ORDER BY r.reviewTime DESC";
-
-                    Json::Value result = db->query(sql.str());
-                    release_db_handler(std::move(db));
-
-                    response["status"] = "success";
-                    response["merchantId"] = merchantId;
-                    response["reviews"] = result;
-
-                } catch (const std::exception& e) {
-                    response["status"] = "error";
-                    response["message"] = e.what();
+        // 参数可放在 JSON 请求体或 URL 参数中：merchant_id、pageSize，以及翻页游标 cursorTime / cursorId
+        server.Get(R"(/merchant/reviews)", dispatch(R"(/merchant/reviews)", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            LOG_DEBUG("/merchant/reviews request body: " << req.body);
+            Json::Value requestResult;
+            parse_json(req.body.data(), req.body.data() + req.body.size(), requestResult);
+            auto param = [&](const char* key) {
+                if (requestResult.isObject() && requestResult.isMember(key)) {
+                    return requestResult[key].asString();
                 }
+                return req.get_param_value(key);
+            };
 
-                return response.toStyledString();
-            });
-
-            // 提交任务
-            std::future<std::string> result_future = task_ptr->get_future();
-            threadPool.enqueue([task_ptr] {
-                (*task_ptr)();
-            });
+            const std::string merchantId = param("merchant_id");
+            const std::string cursorTime = param("cursorTime");
+            const std::string cursorId = param("cursorId");
+            int pageSize = REVIEW_PAGE_SIZE_DEFAULT;
+            try {
+                const std::string value = param("pageSize");
+                if (!value.empty()) {
+                    pageSize = std::clamp(std::stoi(value), 1, REVIEW_PAGE_SIZE_MAX);
+                }
+            } catch (const std::exception&) {
+                // 非法的 pageSize 按默认值处理
+            }
+            LOG_DEBUG("[GET] /merchant/" << merchantId << "/reviews");
 
-            // 返回响应
             try {
-                std::string result = result_future.get();
-                std::cout << "/merchant/:id/reviews result: " << result << std::endl;
-                res.set_content(result, "application/json");
+                const bool firstPage = cursorTime.empty() || cursorId.empty();
+                if (firstPage && pageSize == REVIEW_PAGE_SIZE_DEFAULT) {
+                    send_cached(req, res, responseCache->get("reviews/" + merchantId, [&] {
+                        return review_page(RatingTarget::Merchant, merchantId, "", "", pageSize);
+                    }, has_reviews));
+                } else {
+                    res.set_content(to_json(review_page(RatingTarget::Merchant, merchantId, cursorTime, cursorId, pageSize)),
+                                    "application/json");
+                }
             } catch (const std::exception& e) {
-                res.status = 500;
-                res.set_content("{\"error\":\"" + std::string(e.what()) + "\"}", "application/json");
+                Json::Value response;
+                response["status"] = "error";
+                response["message"] = e.what();
+                res.set_content(to_json(response), "application/json");
             }
-        });
+        }));
 
         // 查看某个商家的菜品列表
-        server.Get(R"(/merchant/dishes)", [&](const httplib::Request& req, httplib::Response& res) 
+        server.Get(R"(/merchant/dishes)", dispatch(R"(/merchant/dishes)", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) 
         {
             // 打印请求体
-            std::cout << "/merchant/dishes request body: " << req.body << std::endl;
+            LOG_DEBUG("/merchant/dishes request body: " << req.body);
 
             Json::Value requestJson = parse_json(req.body);
             std::string merchantId = requestJson["merchantId"].asString();
-            std::cout << "/merchant/dishes merchantId: " << merchantId << std::endl;
+            LOG_DEBUG("/merchant/dishes merchantId: " << merchantId);
 
             // 包装异步任务
-            auto task_ptr = std::make_shared<std::packaged_task<std::string()> >([this, merchantId]() {
-                std::cout << "[GET] /merchant/" << merchantId << "/dishes" << std::endl;
-
-                Json::Value response;
+            LOG_DEBUG("[GET] /merchant/" << merchantId << "/dishes");
 
-                try {
-                    auto db = acquire_db_handler();
-
-                    std::ostringstream sql;
-                    sql << "SELECT dishId, merchantId, Name, description, price, imageUrl, categoryId "
-                        << "FROM DISH "
-                        << "WHERE merchantId = '" << merchantId << "' "
-                        << "ORDER BY Name ASC";
-
-                    Json::Value result = db->query(sql.str());
-                    release_db_handler(std::move(db));
+            try {
+                send_cached(req, res, responseCache->get("dishes/" + merchantId, [this, &merchantId] {
+                    std::shared_ptr<const MerchantCatalog> catalog = catalogCache->merchant(merchantId);
 
+                    Json::Value response;
                     response["status"] = "success";
                     response["merchantId"] = merchantId;
-                    response["dishes"] = result;
-
-                } catch (const std::exception& e) {
-                    response["status"] = "error";
-                    response["message"] = e.what();
-                }
-
-                return response.toStyledString();
-            });
-
-            // 提交任务
-            std::future<std::string> result_future = task_ptr->get_future();
-            threadPool.enqueue([task_ptr] {
-                (*task_ptr)();
-            });
-
-            // 设置返回响应
-            try {
-                std::string result = result_future.get();
-                std::cout << "/merchant/dishes result: " << result << std::endl;
-                res.set_content(result, "application/json");
+                    response["dishes"] = catalog->dishes;
+                    response["categories"] = catalog->categories;
+                    return response;
+                }, [](const Json::Value& response) {
+                    // 与目录缓存一样，不缓存不存在的商家
+                    return !response["dishes"].empty() || !response["categories"].empty();
+                }));
             } catch (const std::exception& e) {
-                res.status = 500;
-                res.set_content("{\"error\":\"" + std::string(e.what()) + "\"}", "application/json");
+                Json::Value response;
+                response["status"] = "error";
+                response["message"] = e.what();
+                res.set_content(to_json(response), "application/json");
             }
-        });
+        }));
 
 
 // 配送信息接口（同步版本）
-server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, httplib::Response& res)
+server.Post("/merchant/add_delivery_info", dispatch("/merchant/add_delivery_info", Lane::Write, [&](const httplib::Request& req, httplib::Response& res)
 {
     try {
-        std::cout << "/merchant/add_delivery_info request body: " << req.body << std::endl;
+        LOG_DEBUG("/merchant/add_delivery_info request body: " << req.body);
 
         Json::Value deliveryData = parse_json(req.body);
 
@@ -1216,43 +2208,19 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         const std::string deliveryPersonPhone = deliveryData.get("deliveryPersonPhone", "").asString();
 
         // ✅ 控制台日志输出
-        std::cout << "[配送信息接口] deliveryId（自动生成）: " << deliveryId << std::endl;
-        std::cout << "[配送信息接口] orderId: " << orderId << std::endl;
-        std::cout << "[配送信息接口] deliveryStatus: " << deliveryStatus << std::endl;
-        std::cout << "[配送信息接口] estimatedDeliveryTime: " << estimatedDeliveryTime << std::endl;
-        std::cout << "[配送信息接口] actualDeliveryTime: " << actualDeliveryTime << std::endl;
-        std::cout << "[配送信息接口] deliveryPersonId: " << deliveryPersonId << std::endl;
-        std::cout << "[配送信息接口] deliveryPersonName: " << deliveryPersonName << std::endl;
-        std::cout << "[配送信息接口] deliveryPersonPhone: " << deliveryPersonPhone << std::endl;
-
-        auto db = acquire_db_handler();
-
-        // ✅ 构造SQL插入语句
-        std::ostringstream sql;
-        sql << "INSERT INTO DELIVERY_INFO ("
-            << "deliveryId, orderId, deliveryStatus, estimatedDeliveryTime, "
-            << "actualDeliveryTime, deliveryPersonId, deliveryPersonName, deliveryPersonPhone"
-            << ") VALUES ('"
-            << deliveryId << "', '"
-            << orderId << "', '"
-            << deliveryStatus << "', "
-            << (estimatedDeliveryTime.empty() ? "NULL" : "'" + estimatedDeliveryTime + "'") << ", "
-            << (actualDeliveryTime.empty() ? "NULL" : "'" + actualDeliveryTime + "'") << ", "
-            << (deliveryPersonId.empty() ? "NULL" : "'" + deliveryPersonId + "'") << ", "
-            << (deliveryPersonName.empty() ? "NULL" : "'" + deliveryPersonName + "'") << ", "
-            << (deliveryPersonPhone.empty() ? "NULL" : "'" + deliveryPersonPhone + "'") << ")";
-
-        std::cout << "[配送信息接口] 执行 SQL: " << sql.str() << std::endl;
-
-        db->query(sql.str());
-        release_db_handler(std::move(db));
-
-        // ========== 构建标准化的JSON响应 ==========
-        Json::Value response;
-        response["status"] = "success";
-        response["message"] = "配送信息插入成功";  // 修改为要求的消息
-        
-        // 添加配送信息
+        LOG_DEBUG("[配送信息接口] deliveryId（自动生成）: " << deliveryId);
+        LOG_DEBUG("[配送信息接口] orderId: " << orderId);
+        LOG_DEBUG("[配送信息接口] deliveryStatus: " << deliveryStatus);
+        LOG_DEBUG("[配送信息接口] estimatedDeliveryTime: " << estimatedDeliveryTime);
+        LOG_DEBUG("[配送信息接口] actualDeliveryTime: " << actualDeliveryTime);
+        LOG_DEBUG("[配送信息接口] deliveryPersonId: " << deliveryPersonId);
+        LOG_DEBUG("[配送信息接口] deliveryPersonName: " << deliveryPersonName);
+        LOG_DEBUG("[配送信息接口] deliveryPersonPhone: " << deliveryPersonPhone);
+
+        // 配送信息与订单写在同一分片
+        const size_t shard = orderShards->locate_order(orderId);
+
+        // 响应与推送给订阅者的事件使用同一份内容
         Json::Value deliveryInfo;
         deliveryInfo["deliveryId"] = deliveryId;
         deliveryInfo["orderId"] = orderId;
@@ -1262,15 +2230,51 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         if (!deliveryPersonId.empty()) deliveryInfo["deliveryPersonId"] = deliveryPersonId;
         if (!deliveryPersonName.empty()) deliveryInfo["deliveryPersonName"] = deliveryPersonName;
         if (!deliveryPersonPhone.empty()) deliveryInfo["deliveryPersonPhone"] = deliveryPersonPhone;
+
+        if (writeBehind->enabled()) {
+            auto optional = [](const std::string& value) {
+                return value.empty() ? Json::Value() : Json::Value(value);
+            };
+            Json::Value row(Json::arrayValue);
+            row.append(deliveryId);
+            row.append(orderId);
+            row.append(deliveryStatus);
+            row.append(optional(estimatedDeliveryTime));
+            row.append(optional(actualDeliveryTime));
+            row.append(optional(deliveryPersonId));
+            row.append(optional(deliveryPersonName));
+            row.append(optional(deliveryPersonPhone));
+            // 写入成功后才推送
+            if (!writeBehind->enqueue(StmtId::DeliveryInsert, write_target_shard(shard), std::move(row),
+                    [this, orderId, deliveryInfo] { orderEvents->publish(orderId, "delivery", deliveryInfo); })) {
+                respond_busy(res);
+                return;
+            }
+        } else {
+            auto db = orderShards->lease(shard);
+
+            // ✅ 可选字段为空时写入 NULL
+            db->execute(StmtId::DeliveryInsert,
+                deliveryId, orderId, deliveryStatus,
+                nullable(estimatedDeliveryTime), nullable(actualDeliveryTime),
+                nullable(deliveryPersonId), nullable(deliveryPersonName), nullable(deliveryPersonPhone));
+            db.reset();
+            orderEvents->publish(orderId, "delivery", deliveryInfo);
+        }
+
+        // ========== 构建标准化的JSON响应 ==========
+        Json::Value response;
+        response["status"] = "success";
+        response["message"] = "配送信息插入成功";  // 修改为要求的消息
         
+        // 添加配送信息
         response["data"] = deliveryInfo;
         // ========== 响应构建结束 ==========
 
-        Json::StreamWriterBuilder writer;
-        res.set_content(Json::writeString(writer, response), "application/json");
+        res.set_content(to_json(response), "application/json");
 
     } catch (const std::exception& e) {
-        std::cout << "[配送信息接口] 错误：" << e.what() << std::endl;
+        LOG_ERROR_RATE(10, "[配送信息接口] 错误：" << e.what());
         res.status = 500;
         
         // ✅ 错误响应JSON
@@ -1278,13 +2282,12 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         errorResponse["status"] = "error";
         errorResponse["message"] = e.what();
         
-        Json::StreamWriterBuilder writer;
-        res.set_content(Json::writeString(writer, errorResponse), "application/json");
+        res.set_content(to_json(errorResponse), "application/json");
     }
-});
+}));
 
         //支付记录接口
- server.Post("/merchant/add_payment_record", [&](const httplib::Request& req, httplib::Response& res) {
+ server.Post("/merchant/add_payment_record", dispatch("/merchant/add_payment_record", Lane::Checkout, [&](const httplib::Request& req, httplib::Response& res) {
     try {
         // 确保请求体是有效的JSON
         if (req.body.empty()) {
@@ -1292,14 +2295,7 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         }
 
         // 解析JSON
-        Json::Value paymentData;
-        Json::CharReaderBuilder reader;
-        std::string errors;
-        std::istringstream jsonStream(req.body);
-        
-        if (!Json::parseFromStream(reader, jsonStream, &paymentData, &errors)) {
-            throw std::runtime_error("JSON解析错误: " + errors);
-        }
+        Json::Value paymentData = parse_json(req.body);
 
         // 生成必要数据
         const std::string paymentId = generate_short_id();
@@ -1313,27 +2309,49 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         const std::string status = paymentData.get("status", "SUCCESS").asString();
 
         // 日志输出
-        std::cout << "[支付记录] 添加记录 - "
-                  << "orderId: " << orderId << ", "
-                  << "amount: " << amount << ", "
-                  << "paymentMethod: " << paymentMethod << ", "
-                  << "transactionId: " << transactionId << ", "
-                  << "status: " << status << std::endl;
+        LOG_DEBUG("[支付记录] 添加记录 - "
+            << "orderId: " << orderId << ", "
+            << "amount: " << amount << ", "
+            << "paymentMethod: " << paymentMethod << ", "
+            << "transactionId: " << transactionId << ", "
+            << "status: " << status);
 
         // 数据库操作
-        auto db = acquire_db_handler();
-        std::ostringstream sql;
-        sql << "INSERT INTO PAYMENT_RECORD (paymentId, orderId, amount, paymentTime, paymentMethod, transactionId, status) "
-            << "VALUES ('" << paymentId << "', "
-            << "'" << orderId << "', "
-            << amount << ", "
-            << "'" << currentTime << "', "
-            << "'" << paymentMethod << "', "
-            << "'" << transactionId << "', "
-            << "'" << status << "')";
-        
-        db->query(sql.str());
-        release_db_handler(std::move(db));
+        auto db = orderShards->lease(orderShards->locate_order(orderId));
+        db->execute(StmtId::PaymentInsert,
+            paymentId, orderId, amount, currentTime, paymentMethod, transactionId, status);
+
+        // 内存库存：支付成功确认预留，失败或取消归还；支付记录已写入，这里出错只记日志
+        if (inventory->enabled()) {
+            try {
+                if (status == "SUCCESS") {
+                    if (!inventory->confirm(orderId)) {
+                        // 预留已超时归还或由其他实例创建：按订单项直接计入售出
+                        Inventory::Quantities quantities;
+                        const Json::Value items = db->execute_sql(order_items_by_orders_sql(1), {mysqlx::Value(orderId)});
+                        for (const auto& item : items) {
+                            quantities[item["dishId"].asString()] += item["quantity"].asInt();
+                        }
+                        if (!quantities.empty()) {
+                            inventory->commit_direct(quantities);
+                        }
+                    }
+                } else if (status == "FAILED" || status == "CANCELLED" || status == "REFUNDED") {
+                    inventory->release(orderId);
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("[支付记录] 库存更新失败 orderId: " << orderId << ", " << e.what());
+            }
+        }
+        db.reset();
+
+        Json::Value paymentEvent;
+        paymentEvent["orderId"] = orderId;
+        paymentEvent["paymentId"] = paymentId;
+        paymentEvent["status"] = status;
+        paymentEvent["amount"] = amount;
+        paymentEvent["paymentTime"] = currentTime;
+        orderEvents->publish(orderId, "payment", paymentEvent);
 
         // 构建JSON响应 - 确保这是最后一步
         Json::Value response;
@@ -1348,8 +2366,7 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         response["data"]["paymentTime"] = currentTime;
 
         // 转换为JSON字符串并设置响应
-        Json::StreamWriterBuilder writer;
-        std::string jsonResponse = Json::writeString(writer, response);
+        std::string jsonResponse = to_json(response);
         res.set_content(jsonResponse, "application/json");
 
     } catch (const std::exception& e) {
@@ -1358,256 +2375,320 @@ server.Post("/merchant/add_delivery_info", [&](const httplib::Request& req, http
         errorResponse["code"] = 500;
         errorResponse["message"] = "服务器错误: " + std::string(e.what());
         
-        Json::StreamWriterBuilder writer;
-        std::string errorJson = Json::writeString(writer, errorResponse);
+        std::string errorJson = to_json(errorResponse);
         res.status = 500;
         res.set_content(errorJson, "application/json");
         
-        std::cerr << "[支付记录] 错误: " << e.what() << std::endl;
+        LOG_ERROR_RATE(10, "[支付记录] 错误: " << e.what());
     }
-});
+}));
 
         // 按照名字搜索商家
-        server.Get("/merchants", [&](const httplib::Request& req, httplib::Response& res) {
+        server.Get("/merchants", dispatch("/merchants", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
             std::string name_keyword = req.get_param_value("name");
     
             if (name_keyword.empty()) {
                 Json::Value empty_result(Json::arrayValue);
-                res.set_content(empty_result.toStyledString(), "application/json");
+                res.set_content(to_json(empty_result), "application/json");
                 return;
             }
 
-            // 创建异步任务
-            auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([this, name_keyword]() {
-                auto db_handler = acquire_db_handler();
-        
-                // 手动转义特殊字符
-                std::string escaped;
-                escaped.reserve(name_keyword.length() * 2);
-                for (char c : name_keyword) {
-                    if (c == '\'' || c == '\\') {
-                        escaped += '\\';
-                    }
-                escaped += c;
+            if (searchIndex->enabled()) {
+                try {
+                    const SearchMode mode = req.get_param_value("mode") == "prefix" ? SearchMode::Prefix : SearchMode::Substring;
+                    const size_t limit = std::strtoul(req.get_param_value("limit").c_str(), nullptr, 10);
+                    res.set_content(to_json(searchIndex->merchants(name_keyword, mode, limit)), "application/json");
+                    return;
+                } catch (const std::exception& e) {
+                    // 索引还没有加载成功，退回数据库查询
+                    LOG_WARN_RATE(1, "Search index unavailable: " << e.what());
                 }
-        
-                std::string sql = "SELECT * FROM MERCHANT WHERE name LIKE '%" + escaped + "%'";
-                Json::Value merchants = db_handler->query(sql);
-                release_db_handler(std::move(db_handler));
-        
-                std::cout << "Executing SQL: " << sql << std::endl;
-                return merchants.toStyledString();
-            });
-
-            // 获取future并提交任务
-            std::future<std::string> result_future = task_ptr->get_future();
-            threadPool.enqueue([task_ptr] {
-                (*task_ptr)();
-            });
+            }
 
-            // 获取结果并设置响应
             try {
-                std::string result = result_future.get();
-                res.set_content(result, "application/json");
+                auto db_handler = acquire_read_handler("search");
+
+                // 关键字作为参数绑定，无需手动转义
+                mysqlx::SqlResult result = db_handler->execute_result(StmtId::MerchantSearch, name_keyword);
+                stream_rows(res, std::move(db_handler), std::move(result));
             } catch (const std::exception& e) {
                 Json::Value error;
                 error["error"] = e.what();
                 res.status = 500;
-                res.set_content(error.toStyledString(), "application/json");
+                res.set_content(to_json(error), "application/json");
+            }
+        }));
+
+        // 按名称搜索商家与菜品：q 关键字，mode=prefix 只匹配开头，limit 每类返回条数
+        server.Get("/search", dispatch("/search", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            const std::string keyword = req.get_param_value("q");
+            const SearchMode mode = req.get_param_value("mode") == "prefix" ? SearchMode::Prefix : SearchMode::Substring;
+            const size_t limit = std::strtoul(req.get_param_value("limit").c_str(), nullptr, 10);
+
+            Json::Value response;
+            if (!searchIndex->enabled()) {
+                res.status = 503;
+                response["status"] = "error";
+                response["message"] = "搜索未启用";
+                res.set_content(to_json(response), "application/json");
+                return;
             }
-        });
-
-        // 查询某个用户的所有订单及其订单项
-        server.Get(R"(/order/query)", [&](const httplib::Request& req, httplib::Response& res) {
-            std::cout << "/order/query request body: " << req.body << std::endl;
-            Json::Value requestJson = parse_json(req.body);
-            std::string userId = requestJson["userId"].asString();
-            std::cout << "[订单查询接口] userId: " << userId << std::endl;
 
-            auto task_ptr = std::make_shared<std::packaged_task<std::string()>>([this, userId]() {
-                Json::Value response;
+            try {
+                response["status"] = "success";
+                response["merchants"] = searchIndex->merchants(keyword, mode, limit);
+                response["dishes"] = searchIndex->dishes(keyword, mode, limit);
+            } catch (const SearchUnavailableError& e) {
+                // 索引加载失败后的退避期，不再排队等待重新加载
+                res.status = 503;
+                res.set_header("Retry-After", std::to_string(searchIndex->retry_after_seconds()));
+                response = Json::Value();
+                response["status"] = "error";
+                response["message"] = e.what();
+            } catch (const std::exception& e) {
+                LOG_ERROR_RATE(10, "/search error: " << e.what());
+                res.status = 500;
+                response = Json::Value();
+                response["status"] = "error";
+                response["message"] = e.what();
+            }
+            res.set_content(to_json(response), "application/json");
+        }));
+
+        // 分页查询某个用户的订单及其订单项
+        // 参数可放在 JSON 请求体或 URL 参数中：userId、pageSize，以及翻页游标 cursorTime / cursorOrderId
+        server.Get(R"(/order/query)", dispatch(R"(/order/query)", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            LOG_DEBUG("/order/query request body: " << req.body);
+            // 请求体可以为空，此时全部参数取自 URL
+            Json::Value requestJson;
+            parse_json(req.body.data(), req.body.data() + req.body.size(), requestJson);
+            auto param = [&](const char* key) {
+                if (requestJson.isObject() && requestJson.isMember(key)) {
+                    return requestJson[key].asString();
+                }
+                return req.get_param_value(key);
+            };
 
-                try {
-                    auto db = acquire_db_handler();
+            std::string userId = param("userId");
+            if (!resolve_user(req, res, userId)) {
+                return;
+            }
+            std::string cursorTime = param("cursorTime");
+            std::string cursorOrderId = param("cursorOrderId");
+            int pageSize = ORDER_PAGE_SIZE_DEFAULT;
+            try {
+                const std::string value = param("pageSize");
+                if (!value.empty()) {
+                    pageSize = std::clamp(std::stoi(value), 1, ORDER_PAGE_SIZE_MAX);
+                }
+            } catch (const std::exception&) {
+                // 非法的 pageSize 按默认值处理
+            }
+            LOG_DEBUG("[订单查询接口] userId: " << userId << ", pageSize: " << pageSize);
 
-                    // 查询订单主信息
-                    std::ostringstream order_sql;
-                    order_sql << "SELECT * FROM `ORDER` WHERE userId = '" << userId << "' ORDER BY orderTime DESC";
-                    Json::Value orders = db->query(order_sql.str());
+            Json::Value response;
 
-                    // 遍历每个订单，查询它的订单项
-                    for (auto& order : orders) {
-                        std::string orderId = order["orderId"].asString();
+            try {
+                // 订单分片后直接读用户所在分片；否则读从库，刚下过单的用户读主库
+                auto db = orderShards->colocated() ? acquire_read_handler("user:" + userId)
+                                                   : orderShards->lease_for_user(userId);
+
+                // 多取一条用于判断是否还有下一页
+                Json::Value orders;
+                if (cursorTime.empty() || cursorOrderId.empty()) {
+                    orders = db->execute(StmtId::OrdersByUserFirstPage, userId, pageSize + 1);
+                } else {
+                    orders = db->execute(StmtId::OrdersByUserAfter,
+                        userId, cursorTime, cursorTime, cursorOrderId, pageSize + 1);
+                }
 
-                        std::ostringstream item_sql;
-                        item_sql << "SELECT dishId, dishName, price, quantity "
-                                << "FROM ORDER_ITEM WHERE orderId = '" << orderId << "'";
-                        Json::Value items = db->query(item_sql.str());
+                const bool hasMore = orders.size() > static_cast<Json::ArrayIndex>(pageSize);
+                if (hasMore) {
+                    Json::Value removed;
+                    orders.removeIndex(static_cast<Json::ArrayIndex>(pageSize), &removed);
+                }
 
-                        order["items"] = items; // 添加订单项到订单中
+                // 本页全部订单项一次查出，再按 orderId 归组
+                if (!orders.empty()) {
+                    std::pmr::memory_resource* arena = RequestArena::resource();
+                    BoundValues orderIds(arena);
+                    orderIds.reserve(orders.size());
+                    std::pmr::unordered_map<std::pmr::string, Json::ArrayIndex> orderIndex(arena);
+                    for (Json::ArrayIndex index = 0; index < orders.size(); ++index) {
+                        Json::Value& order = orders[index];
+                        order["items"] = Json::Value(Json::arrayValue);
+                        const std::string orderId = order["orderId"].asString();
+                        orderIndex.emplace(std::pmr::string(orderId, arena), index);
+                        orderIds.emplace_back(orderId);
                     }
 
-                    release_db_handler(std::move(db));
-
-                    response["status"] = "success";
-                    response["userId"] = userId;
-                    response["orders"] = orders;
-
-                } catch (const std::exception& e) {
-                    response["status"] = "error";
-                    response["message"] = e.what();
+                    Json::Value items = db->execute_sql(order_items_by_orders_sql(orderIds.size()), orderIds);
+                    std::pmr::string itemOrderId(arena);
+                    for (auto& item : items) {
+                        itemOrderId = json_string_view(item["orderId"]);
+                        auto found = orderIndex.find(itemOrderId);
+                        if (found != orderIndex.end()) {
+                            item.removeMember("orderId");
+                            orders[found->second]["items"].append(std::move(item));
+                        }
+                    }
                 }
 
-                return response.toStyledString();
-            });
+                db.reset();
 
-            std::future<std::string> result_future = task_ptr->get_future();
-            threadPool.enqueue([task_ptr] { (*task_ptr)(); });
+                response["status"] = "success";
+                response["userId"] = userId;
+                response["orders"] = orders;
+                response["hasMore"] = hasMore;
+                if (hasMore) {
+                    const Json::Value& last = orders[orders.size() - 1];
+                    response["nextCursor"]["cursorTime"] = last["orderTime"];
+                    response["nextCursor"]["cursorOrderId"] = last["orderId"];
+                }
 
-            try {
-                std::string result = result_future.get();
-                res.set_content(result, "application/json");
             } catch (const std::exception& e) {
-                res.status = 500;
-                res.set_content("{\"error\":\"" + std::string(e.what()) + "\"}", "application/json");
+                response["status"] = "error";
+                response["message"] = e.what();
             }
-        });
-
-        //查看菜品评价
-       server.Get(R"(/dish/reviews)", [&](const httplib::Request& req, httplib::Response& res) 
-        {
-            std::cout << "/dish/reviews request body: " << req.body << std::endl;
-
-            Json::Value requestJson = parse_json(req.body);
-            std::string dishId = requestJson["dishId"].asString();
-            std::cout << "/dish/reviews dishId: " << dishId << std::endl;
-
-            auto task_ptr = std::make_shared<std::packaged_task<std::string()> >([this, dishId]() {
-                std::cout << "[GET] /dish/" << dishId << "/reviews" << std::endl;
-
-                Json::Value response;
-                try 
-                {
-                    auto db = acquire_db_handler();
-
-                    std::ostringstream sql;
-                    sql << "SELECT r.commentId, r.userId, u.username, r.rating, r.content, "
 
-                        << "DATE_FORMAT(r.commentTime, '%Y-%m-%d %H:%i:%s') AS commentTime "
+            res.set_content(to_json(response), "application/json");
+        }));
 
-                        << "FROM USER_COMMENT r "
-                        << "LEFT JOIN USER u ON r.userId = u.userId "
-                    << "WHERE r.dishId = '" << dishId << "' "
-                    << "ORDER BY r.commentTime DESC";
+        // 商家最近的订单：各分片并行取前 pageSize 条，按 (orderTime, orderId) 倒序合并
+        server.Get("/merchant/orders", dispatch("/merchant/orders", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            const std::string merchantId = req.get_param_value("merchantId");
+            int pageSize = ORDER_PAGE_SIZE_DEFAULT;
+            try {
+                const std::string value = req.get_param_value("pageSize");
+                if (!value.empty()) {
+                    pageSize = std::clamp(std::stoi(value), 1, ORDER_PAGE_SIZE_MAX);
+                }
+            } catch (const std::exception&) {
+                // 非法的 pageSize 按默认值处理
+            }
 
-                    Json::Value result = db->query(sql.str());
-                    release_db_handler(std::move(db));
+            Json::Value response;
+            try {
+                const std::vector<Json::Value> parts = orderShards->scatter([&](DatabaseHandler& db, size_t) {
+                    return db.execute(StmtId::MerchantOrdersRecent, merchantId, pageSize);
+                });
+
+                std::pmr::vector<const Json::Value*> merged(RequestArena::resource());
+                for (const Json::Value& part : parts) {
+                    for (const Json::Value& order : part) {
+                        merged.push_back(&order);
+                    }
+                }
+                // orderTime 为 yyyy-mm-dd hh:mm:ss，按字符串比较即按时间比较；直接比较 JSON 中的字符串，不复制
+                std::sort(merged.begin(), merged.end(), [](const Json::Value* a, const Json::Value* b) {
+                    const std::string_view timeA = json_string_view((*a)["orderTime"]);
+                    const std::string_view timeB = json_string_view((*b)["orderTime"]);
+                    return timeA != timeB ? timeA > timeB : json_string_view((*a)["orderId"]) > json_string_view((*b)["orderId"]);
+                });
+                if (merged.size() > static_cast<size_t>(pageSize)) {
+                    merged.resize(static_cast<size_t>(pageSize));
+                }
 
-                    response["status"] = "success";
-                    response["dishId"] = dishId;
-                    response["reviews"] = result;
-                } 
-                catch (const std::exception& e) 
-                {
-                    response["status"] = "error";
-                    response["message"] = e.what();
+                Json::Value orders(Json::arrayValue);
+                for (const Json::Value* order : merged) {
+                    orders.append(*order);
                 }
+                response["status"] = "success";
+                response["merchantId"] = merchantId;
+                response["orders"] = orders;
+            } catch (const std::exception& e) {
+                res.status = 500;
+                response["status"] = "error";
+                response["message"] = e.what();
+            }
+            res.set_content(to_json(response), "application/json");
+        }));
 
-                return response.toStyledString();
-            });
+        // 商家订单数与营业额：各分片并行统计后求和
+        server.Get("/merchant/order_stats", dispatch("/merchant/order_stats", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res) {
+            const std::string merchantId = req.get_param_value("merchantId");
 
-            std::future<std::string> result_future = task_ptr->get_future();
-            threadPool.enqueue([task_ptr] 
-            {
-                (*task_ptr)();
-            });
+            Json::Value response;
+            try {
+                const std::vector<Json::Value> parts = orderShards->scatter([&](DatabaseHandler& db, size_t) {
+                    return db.execute(StmtId::MerchantOrderStats, merchantId);
+                });
+
+                uint64_t orderCount = 0;
+                double revenue = 0;
+                for (const Json::Value& part : parts) {
+                    if (part.empty()) {
+                        continue;
+                    }
+                    // DECIMAL 列可能以字符串形式返回
+                    const Json::Value& row = part[0];
+                    orderCount += row["orderCount"].asUInt64();
+                    revenue += row["revenue"].isString() ? std::atof(row["revenue"].asCString()) : row["revenue"].asDouble();
+                }
 
-            try 
-            {
-                std::string result = result_future.get();
-                std::cout << "/dish/reviews result: " << result << std::endl;
-                res.set_content(result, "application/json");
-            } 
-            catch (const std::exception& e) 
-            {
+                response["status"] = "success";
+                response["merchantId"] = merchantId;
+                response["orderCount"] = Json::UInt64(orderCount);
+                response["revenue"] = revenue;
+            } catch (const std::exception& e) {
                 res.status = 500;
-                res.set_content("{\"error\":\"" + std::string(e.what()) + "\"}", "application/json");
+                response["status"] = "error";
+                response["message"] = e.what();
             }
-        });
- 
+            res.set_content(to_json(response), "application/json");
+        }));
 
-
-}
-
-    Json::Value RestServer::parse_json(const std::string& jsonStr) 
-    {
-        Json::Value root;
-        Json::CharReaderBuilder builder;
-        std::string errors;
-        std::istringstream json_stream(jsonStr);
-        
-        if (!Json::parseFromStream(builder, json_stream, &root, &errors)) 
+        // 查看菜品评价，参数与 /merchant/reviews 相同，菜品用 dishId 指定
+        server.Get(R"(/dish/reviews)", dispatch(R"(/dish/reviews)", Lane::Browse, [&](const httplib::Request& req, httplib::Response& res)
         {
-            throw std::runtime_error("JSON parse error: " + errors);
-        }
-
-        return root;
-    }
-
-   std::string RestServer::generate_uuid()
-    {
-        std::stringstream ss;
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 15);
-
-        const char* hex = "0123456789abcdef";
-        std::vector<int> uuid_format = {8, 4, 4, 4, 12}; 
+            LOG_DEBUG("/dish/reviews request body: " << req.body);
+            Json::Value requestJson;
+            parse_json(req.body.data(), req.body.data() + req.body.size(), requestJson);
+            auto param = [&](const char* key) {
+                if (requestJson.isObject() && requestJson.isMember(key)) {
+                    return requestJson[key].asString();
+                }
+                return req.get_param_value(key);
+            };
 
-        for (size_t i = 0; i < uuid_format.size(); ++i) {
-            for (int j = 0; j < uuid_format[i]; ++j) {
-                ss << hex[dis(gen)];
+            const std::string dishId = param("dishId");
+            const std::string cursorTime = param("cursorTime");
+            const std::string cursorId = param("cursorId");
+            int pageSize = REVIEW_PAGE_SIZE_DEFAULT;
+            try {
+                const std::string value = param("pageSize");
+                if (!value.empty()) {
+                    pageSize = std::clamp(std::stoi(value), 1, REVIEW_PAGE_SIZE_MAX);
+                }
+            } catch (const std::exception&) {
+                // 非法的 pageSize 按默认值处理
             }
-            if (i != uuid_format.size() - 1) ss << "-";
-        }
-
-        return ss.str(); // 返回长度为 36 的标准 UUID
-    }
-
-    //生成adressid的函数
-
-    std::string RestServer::generate_short_id(int length)
-    {
-        const std::string chars = "abcdefghijklmnopqrstuvwxyz0123456789";
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dist(0, chars.size() - 1);
-
-        std::string result;
-        for (int i = 0; i < length; ++i) {
-            result += chars[dist(gen)];
-            return result;
-        }
-    }
+            LOG_DEBUG("[GET] /dish/" << dishId << "/reviews");
 
-        //生成管理员id的函数
-    std::string RestServer::generate_admin_id(int length)
-     {
-        std::stringstream ss;
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 15); // 16进制字符下标
+            try {
+                const bool firstPage = cursorTime.empty() || cursorId.empty();
+                if (firstPage && pageSize == REVIEW_PAGE_SIZE_DEFAULT) {
+                    send_cached(req, res, responseCache->get("dish-reviews/" + dishId, [&] {
+                        return review_page(RatingTarget::Dish, dishId, "", "", pageSize);
+                    }, has_reviews));
+                } else {
+                    res.set_content(to_json(review_page(RatingTarget::Dish, dishId, cursorTime, cursorId, pageSize)),
+                                    "application/json");
+                }
+            } catch (const std::exception& e) {
+                Json::Value response;
+                response["status"] = "error";
+                response["message"] = e.what();
+                res.set_content(to_json(response), "application/json");
+            }
+        }));
 
-        const char* hex = "0123456789abcdef";
+ 
 
-        for (int i = 0; i < length; ++i) {
-            ss << hex[dis(gen)];
-        }
 
-        return ss.str(); 
-    }
+}
 
-        //自动生成时间戳
+    //自动生成时间戳
     std::string RestServer::current_time_string() 
     {
         time_t rawtime;
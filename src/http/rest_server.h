@@ -4,12 +4,45 @@
 #include <mysqlx/xdevapi.h>
 
 #include "common.h"
-#include "thread_pool.h"
+#include "lane_scheduler.h"
+#include "request_deadline.h"
+#include "request_arena.h"
 #include "db_handler.h"
+#include "db_pool.h"
+#include "db_router.h"
+#include "order_shards.h"
+#include "rating_summary.h"
+#include "write_behind.h"
+#include "json_row_writer.h"
+#include "catalog_cache.h"
+#include "inventory.h"
+#include "session_cache.h"
+#include "order_events.h"
+#include "event_stream_server.h"
+#include "response_cache.h"
+#include "search_index.h"
+#include "metrics.h"
+#include "id_generator.h"
 
 
 namespace TakeAwayPlatform
 {
+    // HTTP 监听参数：多个监听实例以 SO_REUSEPORT 绑定同一端口，由内核把新连接分给各实例的 accept 循环；
+    // 每个实例有自己的工作线程（thread_pool_size 按实例均分），可以绑定到一组 CPU
+    struct ListenerOptions
+    {
+        int port = 9090;
+        size_t listeners = 1;
+        int backlog = 512;                          // listen() 队列长度，实际值不超过 net.core.somaxconn
+        size_t keepAliveMaxCount = 100;             // 一个长连接上最多处理的请求数
+        std::chrono::seconds keepAliveTimeout {5};  // 长连接空闲多久后关闭
+        std::vector<std::vector<int>> cpuSets;      // 每个实例绑定的 CPU，为空时不绑定
+    };
+
+    // 从 config.json 的 server 节读取；cpu_affinity 为 "auto" 时把进程可用的 CPU 按实例数均分，
+    // 也可以写成每个实例一个 CPU 编号数组，"none" 不绑定
+    ListenerOptions load_listener_options(const Json::Value& config);
+
     class RestServer 
     {
     public:
@@ -19,28 +52,63 @@ namespace TakeAwayPlatform
         void start(int port);
         void stop();
         bool is_running() const;
+
+        // 配置文件中的监听端口，启动参数未指定端口时使用
+        int configured_port() const { return listenerOptions.port; }
         
 
     private:
+        // 一个监听实例：独立的 httplib::Server、accept 线程与工作线程
+        struct Listener
+        {
+            size_t index = 0;
+            httplib::Server server;
+            std::vector<int> cpus;
+            int socket = -1;                        // 监听套接字，绑定后用于调整 backlog
+            std::thread thread;
+        };
+
         void init_db_pool(const Json::Value& config);
 
-        void run_server(int port);
+        void run_listener(Listener& listener, int port);
 
-        std::unique_ptr<DatabaseHandler> create_db_handler();
+        // 写入、事务与登录校验使用主库
+        DBLease acquire_db_handler();
 
-        std::unique_ptr<DatabaseHandler> acquire_db_handler();
+        // 只读查询优先使用从库；stickyKey 刚写入过时改读主库
+        DBLease acquire_read_handler(const std::string& stickyKey = std::string());
 
-        void release_db_handler(std::unique_ptr<DatabaseHandler> handler);
+        void setup_routes(httplib::Server& server);
 
-        void setup_routes();
+        // 等待连接池预热，再按配置预热菜品目录与搜索索引，完成后 /health 报告就绪
+        void warm_up(std::chrono::seconds timeout, size_t catalogMerchants, bool warmSearch);
 
-        Json::Value parse_json(const std::string& jsonStr);
+        // 请求带有登录令牌时以令牌中的用户身份为准，userId 为空则填入令牌中的用户；
+        // 令牌无效或与 userId 不符时写入 401 / 403 响应并返回 false，管理员令牌不限制 userId
+        bool resolve_user(const httplib::Request& req, httplib::Response& res, std::string& userId);
 
-        std::string generate_uuid();
+        // 包装路由处理函数：进入处理函数前先在对应通道申请许可，并按路由记录耗时与状态码
+        httplib::Server::Handler dispatch(const std::string& route, Lane lane, httplib::Server::Handler handler);
 
-        std::string generate_short_id(int length = 4);
+        // 连接池、通道、缓存等现算指标，在 /metrics 采集时输出
+        void register_collectors();
 
-        std::string generate_admin_id(int length = 6);
+        // 发送缓存的响应：支持 If-None-Match 返回 304，客户端接受时发送 gzip 副本
+        void send_cached(const httplib::Request& req, httplib::Response& res,
+                         const std::shared_ptr<const CachedResponse>& cached);
+
+        // 把结果集以 JSON 数组分块发送，边读边发；连接在发送结束后归还
+        void stream_rows(httplib::Response& res, DBLease db, mysqlx::SqlResult result);
+
+        // 订单状态推送的订阅校验：令牌有效且订单属于该用户（管理员不限），返回订单当前状态
+        StreamOpenResult open_order_stream(const StreamRequest& request);
+
+        // 商家评价或菜品评论的一页：按 (时间, ID) 倒序，游标为上一页最后一条的时间与 ID，附带评分汇总
+        Json::Value review_page(RatingTarget target, const std::string& targetId,
+                                const std::string& cursorTime, const std::string& cursorId, int pageSize);
+
+        // 商家目录变化：先失效目录缓存，再失效由它生成的响应
+        void invalidate_catalog(const std::string& merchantId);
 
         std::string current_time_string();
 
@@ -48,20 +116,39 @@ namespace TakeAwayPlatform
 
 
     private:
-        httplib::Server server;
-        ThreadPool threadPool;
-        std::vector<DBConfig> dbConfig;
-        std::mutex dbPoolMutex;
-        std::queue<std::unique_ptr<DatabaseHandler>> dbPool;
+        ListenerOptions listenerOptions;
+        std::vector<std::unique_ptr<Listener>> listeners;
+        std::unique_ptr<DatabaseRouter> dbRouter;
+        std::unique_ptr<OrderShards> orderShards;
+        std::unique_ptr<LaneScheduler> laneScheduler;
+        std::unique_ptr<CatalogCache> catalogCache;
+        std::unique_ptr<ResponseCache> responseCache;
+        std::unique_ptr<SearchIndex> searchIndex;
+        std::unique_ptr<OrderEventBus> orderEvents;         // 晚于全部发布方析构
+        std::unique_ptr<WriteBehindQueue> writeBehind;     // 析构时先于缓存与连接池写完积压
+        std::unique_ptr<Inventory> inventory;              // 析构时先于连接池写回售出量
+        std::unique_ptr<SessionCache> sessionCache;
+        std::unique_ptr<EventStreamServer> eventStream;
+
+        // 监控指标
+        Histogram& poolWait;
+        Counter& poolTimeouts;
+        Histogram& taskWait;
+        std::atomic<int64_t> queuedTasks {0};
+        size_t collectorId = 0;
 
         std::atomic<bool> isRunning {false};
+        size_t activeListeners = 0;                 // 仍在 accept 循环中的实例，stopMtx 保护
         std::atomic<bool> stopRequested {false};
+        std::atomic<bool> ready {false};            // 预热结束，可以接收流量
+
+        bool warmupBeforeListen = false;            // 预热结束后才开始监听
+        std::chrono::milliseconds requestTimeout {10000};   // server.timeout
+        std::thread warmupThread;
 
         // 用于等待服务器停止的同步对象
         std::mutex stopMtx;
         std::condition_variable stopCv;
-
-        std::thread serverThread;
     };
 
 }
@@ -1,29 +1,64 @@
 #include <csignal>
+#include <cstdlib>
 #include <atomic>
 #include <thread>
 #include <condition_variable>
 
 #include "common.h"
+#include "logger.h"
 #include "rest_server.h"
 
 
+// 启动参数未指定配置文件时使用
+const char* DEFAULT_CONFIG_PATH = "/opt/TakeAwayPlatform/config/config.json";
+
 std::atomic<bool> running(true);
+std::atomic<int> receivedSignal(0);
 std::mutex mtx;
 std::condition_variable cv;
 
 
 void signal_handler(int signal) {
-    std::cout << "Received signal " << signal << ", shutting down..." << std::endl;
-    std::cout.flush();
-
+    // 信号处理函数中只做异步信号安全的操作，日志留给主线程输出
+    receivedSignal = signal;
     running = false;
 
     cv.notify_all();  // 唤醒可能阻塞的主线程
 }
 
-int main() {
-    std::cout << "Entry main.." << std::endl;
-    std::cout.flush();
+// 命令行参数优先，其次环境变量，都没有时返回 nullptr
+const char* startup_option(int argc, char** argv, int index, const char* env) {
+    if (argc > index && argv[index][0] != '\0') {
+        return argv[index];
+    }
+    const char* value = std::getenv(env);
+    return value && value[0] != '\0' ? value : nullptr;
+}
+
+// 解析端口号，不合法时返回 -1
+int parse_port(const char* text) {
+    char* end = nullptr;
+    const long port = std::strtol(text, &end, 10);
+    return end != text && *end == '\0' && port > 0 && port <= 65535 ? static_cast<int>(port) : -1;
+}
+
+// 用法: TakeAwayPlatform [config_path] [port]
+// 未指定时读取环境变量 TAKEAWAY_CONFIG / TAKEAWAY_PORT；端口也没有设置时使用配置文件中的 server.port
+int main(int argc, char** argv) {
+    LOG_INFO("Entry main..");
+
+    const char* configOption = startup_option(argc, argv, 1, "TAKEAWAY_CONFIG");
+    const std::string configPath = configOption ? configOption : DEFAULT_CONFIG_PATH;
+
+    int port = 0;
+    if (const char* portOption = startup_option(argc, argv, 2, "TAKEAWAY_PORT")) {
+        port = parse_port(portOption);
+        if (port < 0) {
+            LOG_ERROR("Invalid port: " << portOption);
+            TakeAwayPlatform::Logger::instance().shutdown();
+            return 1;
+        }
+    }
 
     // 设置信号处理
     struct sigaction sa;
@@ -37,12 +72,14 @@ int main() {
 
     try 
     {
-        TakeAwayPlatform::RestServer restSrv("/opt/TakeAwayPlatform/config/config.json");
-        std::cout << "Starting server on port 9090..." << std::endl;
-        std::cout.flush();
+        TakeAwayPlatform::RestServer restSrv(configPath);
+        if (port == 0) {
+            port = restSrv.configured_port();
+        }
+        LOG_INFO("Starting server on port " << port << "...");
         
         // 启动服务器（分离线程）
-        restSrv.start(9090);
+        restSrv.start(port);
         
         // 使用条件变量等待信号，避免忙等待
         {
@@ -52,14 +89,17 @@ int main() {
             });
         }
         
+        if (receivedSignal != 0) {
+            LOG_INFO("Received signal " << receivedSignal << ", shutting down...");
+        }
+
         // 检测服务器是否意外停止
         if (!restSrv.is_running()) {
-            std::cerr << "Server thread has stopped unexpectedly!" << std::endl;
+            LOG_ERROR("Server thread has stopped unexpectedly!");
         }
         
         // 优雅关闭
-        std::cout << "Shutting down server..." << std::endl;
-        std::cout.flush();
+        LOG_INFO("Shutting down server...");
         restSrv.stop();
         
         // 等待服务器完全停止（最多10秒）
@@ -73,15 +113,16 @@ int main() {
         }
         
         if (restSrv.is_running()) {
-            std::cerr << "Warning: Server did not stop within timeout" << std::endl;
+            LOG_WARN("Server did not stop within timeout");
         }
     } catch (const std::exception& e) {
-        std::cerr << "Server error: " << e.what() << std::endl;
+        LOG_ERROR("Server error: " << e.what());
+        TakeAwayPlatform::Logger::instance().shutdown();
         return 1;
     }
 
-    std::cout << "Server shutdown complete." << std::endl;
-    std::cout.flush();
+    LOG_INFO("Server shutdown complete.");
+    TakeAwayPlatform::Logger::instance().shutdown();
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../include/lane_scheduler.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        constexpr double SHORT_RTT_ALPHA = 0.1;     // 近期延迟的指数平均系数
+        constexpr size_t RTT_WINDOW = 1000;         // 每这么多次采样用窗口内最短延迟更新基线
+        constexpr double RTT_TOLERANCE = 1.5;       // 近期延迟在基线 1.5 倍以内不收缩
+        constexpr double LIMIT_SMOOTHING = 0.2;     // 新上限向目标值靠拢的比例
+    }
+
+    const char* lane_name(Lane lane)
+    {
+        switch (lane)
+        {
+            case Lane::Checkout: return "checkout";
+            case Lane::Write:    return "write";
+            case Lane::Browse:   return "browse";
+            case Lane::Auth:     return "auth";
+            default:             return "unknown";
+        }
+    }
+
+    LaneScheduler::LaneScheduler(const Json::Value& config, size_t workerCount)
+    {
+        const size_t workers = std::max<size_t>(1, workerCount);
+        const size_t half = std::max<size_t>(1, workers / 2);
+        const size_t quarter = std::max<size_t>(1, workers / 4);
+
+        // 默认值：下单支付可以用满全部工作线程，写入与浏览各自最多占一半，登录最多占四分之一
+        const LaneOptions defaults[LANE_COUNT] = {
+            { workers, workers, std::chrono::milliseconds(2000), true, 1 },
+            { half, quarter, std::chrono::milliseconds(1000), true, 1 },
+            { half, quarter, std::chrono::milliseconds(500), true, 1 },
+            { quarter, quarter, std::chrono::milliseconds(1000), true, 1 },
+        };
+
+        for (size_t index = 0; index < LANE_COUNT; ++index)
+        {
+            const Json::Value& laneConfig = config[lane_name(static_cast<Lane>(index))];
+            LaneOptions& options = lanes[index].options;
+
+            options = defaults[index];
+            if (laneConfig.isObject())
+            {
+                options.maxConcurrency = std::max<Json::UInt>(1,
+                    laneConfig.get("max_concurrency", static_cast<Json::UInt>(options.maxConcurrency)).asUInt());
+                options.maxQueue = laneConfig.get("max_queue", static_cast<Json::UInt>(options.maxQueue)).asUInt();
+                options.maxWait = std::chrono::milliseconds(
+                    laneConfig.get("max_wait_ms", static_cast<Json::Int>(options.maxWait.count())).asInt());
+                options.adaptive = laneConfig.get("adaptive", options.adaptive).asBool();
+                options.minConcurrency = std::clamp<size_t>(
+                    laneConfig.get("min_concurrency", static_cast<Json::UInt>(options.minConcurrency)).asUInt(),
+                    1, options.maxConcurrency);
+            }
+
+            // 从上限开始，只在延迟上升时收缩
+            lanes[index].limit = static_cast<double>(options.maxConcurrency);
+        }
+    }
+
+    LaneScheduler::Permit LaneScheduler::admit(Lane lane, std::chrono::steady_clock::time_point deadline)
+    {
+        LaneState& state = lanes[static_cast<size_t>(lane)];
+        std::unique_lock<std::mutex> lock(state.mtx);
+
+        if (state.active < current_limit(state))
+        {
+            ++state.active;
+            state.admitted.fetch_add(1, std::memory_order_relaxed);
+            return Permit(this, lane);
+        }
+
+        if (state.waiting >= state.options.maxQueue)
+        {
+            state.rejected.fetch_add(1, std::memory_order_relaxed);
+            return Permit();
+        }
+
+        ++state.waiting;
+        const auto waitUntil = std::min(std::chrono::steady_clock::now() + state.options.maxWait, deadline);
+        const bool granted = state.available.wait_until(lock, waitUntil, [&state] {
+            return state.active < current_limit(state);
+        });
+        --state.waiting;
+
+        if (!granted)
+        {
+            state.timeouts.fetch_add(1, std::memory_order_relaxed);
+            return Permit();
+        }
+
+        ++state.active;
+        state.admitted.fetch_add(1, std::memory_order_relaxed);
+        return Permit(this, lane);
+    }
+
+    void LaneScheduler::release(Lane lane, std::chrono::steady_clock::duration held)
+    {
+        LaneState& state = lanes[static_cast<size_t>(lane)];
+        size_t wake = 0;
+        {
+            std::lock_guard<std::mutex> lock(state.mtx);
+            const size_t inflight = state.active;
+            --state.active;
+            if (state.options.adaptive) {
+                update_limit(state, std::chrono::duration<double>(held).count(), inflight);
+            }
+
+            // 上限被调高时空出的名额可能不止一个，按空位数唤醒等待者；上限收缩到没有空位时不唤醒
+            const size_t limit = current_limit(state);
+            const size_t open = limit > state.active ? limit - state.active : 0;
+            wake = std::min(open, state.waiting);
+        }
+        for (size_t index = 0; index < wake; ++index) {
+            state.available.notify_one();
+        }
+    }
+
+    void LaneScheduler::update_limit(LaneState& state, double rtt, size_t inflight)
+    {
+        if (state.minRtt <= 0.0) {
+            state.shortRtt = state.minRtt = state.windowMinRtt = rtt;
+            return;
+        }
+
+        state.shortRtt += SHORT_RTT_ALPHA * (rtt - state.shortRtt);
+        state.minRtt = std::min(state.minRtt, rtt);
+
+        // 基线按窗口刷新，下游整体变慢（例如换了更慢的库）时基线也能跟着上移；
+        // 每个窗口最多上移 10%，避免过载时窗口内的最短延迟偏大导致上限一下子放开
+        state.windowMinRtt = state.windowSamples == 0 ? rtt : std::min(state.windowMinRtt, rtt);
+        if (++state.windowSamples >= RTT_WINDOW) {
+            state.minRtt = std::min(state.windowMinRtt, state.minRtt * 1.1);
+            state.windowSamples = 0;
+        }
+
+        // 并发没有用到一半时延迟反映不了容量，保持上限不变
+        if (static_cast<double>(inflight) * 2.0 < state.limit) {
+            return;
+        }
+
+        const double gradient = std::clamp(RTT_TOLERANCE * state.minRtt / std::max(state.shortRtt, 1e-9), 0.5, 1.0);
+        const double target = state.limit * gradient + std::sqrt(state.limit);
+        state.limit = std::clamp(state.limit * (1.0 - LIMIT_SMOOTHING) + target * LIMIT_SMOOTHING,
+                                 static_cast<double>(state.options.minConcurrency),
+                                 static_cast<double>(state.options.maxConcurrency));
+    }
+
+    size_t LaneScheduler::current_limit(const LaneState& state)
+    {
+        if (!state.options.adaptive) {
+            return state.options.maxConcurrency;
+        }
+        return std::max<size_t>(1, static_cast<size_t>(state.limit));
+    }
+
+    LaneStats LaneScheduler::stats(Lane lane) const
+    {
+        const LaneState& state = lanes[static_cast<size_t>(lane)];
+
+        LaneStats snapshot;
+        snapshot.admitted = state.admitted.load(std::memory_order_relaxed);
+        snapshot.rejected = state.rejected.load(std::memory_order_relaxed);
+        snapshot.timeouts = state.timeouts.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(state.mtx);
+        snapshot.active = state.active;
+        snapshot.waiting = state.waiting;
+        snapshot.limit = current_limit(state);
+        return snapshot;
+    }
+
+    const LaneOptions& LaneScheduler::options(Lane lane) const
+    {
+        return lanes[static_cast<size_t>(lane)].options;
+    }
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+
+#include "id_generator.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        std::atomic<bool> timeOrderedIds {true};
+
+        // 上一个 UUIDv7 的 (毫秒 << 12) | 序号，保证进程内严格递增
+        std::atomic<uint64_t> lastV7 {0};
+
+        const char HEX[] = "0123456789abcdef";
+        const char SHORT_ID_CHARS[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+        uint64_t splitmix64(uint64_t& state)
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        // xoshiro256**，每个线程一份，只在线程第一次使用时读取 random_device
+        class IdRandom
+        {
+        public:
+            IdRandom()
+            {
+                std::random_device device;
+                uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+                seed ^= static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+                seed ^= std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9e3779b97f4a7c15ULL;
+                for (uint64_t& word : state) {
+                    word = splitmix64(seed);
+                }
+            }
+
+            uint64_t next()
+            {
+                const uint64_t result = rotl(state[1] * 5, 7) * 9;
+                const uint64_t t = state[1] << 17;
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= t;
+                state[3] = rotl(state[3], 45);
+                return result;
+            }
+
+            // [0, bound) 内的均匀整数（乘法取高位，bound 很小时偏差可以忽略）
+            uint32_t below(uint32_t bound)
+            {
+                return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+            }
+
+        private:
+            static uint64_t rotl(uint64_t x, int k)
+            {
+                return (x << k) | (x >> (64 - k));
+            }
+
+            uint64_t state[4];
+        };
+
+        IdRandom& local_random()
+        {
+            thread_local IdRandom random;
+            return random;
+        }
+
+        void write_hex(char* out, uint64_t value, int digits)
+        {
+            for (int index = digits - 1; index >= 0; --index) {
+                out[index] = HEX[value & 0xf];
+                value >>= 4;
+            }
+        }
+
+        // 128 位按 8-4-4-4-12 格式输出
+        std::string format_uuid(uint64_t high, uint64_t low)
+        {
+            char buffer[36];
+            write_hex(buffer, high >> 32, 8);
+            buffer[8] = '-';
+            write_hex(buffer + 9, (high >> 16) & 0xffff, 4);
+            buffer[13] = '-';
+            write_hex(buffer + 14, high & 0xffff, 4);
+            buffer[18] = '-';
+            write_hex(buffer + 19, low >> 48, 4);
+            buffer[23] = '-';
+            write_hex(buffer + 24, low & 0xffffffffffffULL, 12);
+            return std::string(buffer, sizeof(buffer));
+        }
+
+        constexpr uint64_t VARIANT_MASK = 0x3fffffffffffffffULL;
+        constexpr uint64_t VARIANT_RFC4122 = 0x8000000000000000ULL;
+    }
+
+    IdOptions load_id_options(const Json::Value& config)
+    {
+        IdOptions options;
+        options.timeOrdered = config.get("time_ordered", true).asBool();
+        return options;
+    }
+
+    void configure_ids(const IdOptions& options)
+    {
+        timeOrderedIds.store(options.timeOrdered, std::memory_order_relaxed);
+    }
+
+    std::string generate_uuid()
+    {
+        return timeOrderedIds.load(std::memory_order_relaxed) ? generate_uuid_v7() : generate_uuid_v4();
+    }
+
+    std::string generate_uuid_v4()
+    {
+        IdRandom& random = local_random();
+        const uint64_t high = (random.next() & ~0xf000ULL) | 0x4000ULL;
+        const uint64_t low = (random.next() & VARIANT_MASK) | VARIANT_RFC4122;
+        return format_uuid(high, low);
+    }
+
+    std::string generate_uuid_v7()
+    {
+        const uint64_t millis = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+        // 同一毫秒内序号加一；序号用完或时钟回拨时沿用上一个值加一，时间戳随之前进
+        uint64_t previous = lastV7.load(std::memory_order_relaxed);
+        uint64_t current;
+        do {
+            current = std::max(millis << 12, previous + 1);
+        } while (!lastV7.compare_exchange_weak(previous, current, std::memory_order_relaxed));
+
+        const uint64_t high = ((current >> 12) << 16) | 0x7000ULL | (current & 0xfffULL);
+        const uint64_t low = (local_random().next() & VARIANT_MASK) | VARIANT_RFC4122;
+        return format_uuid(high, low);
+    }
+
+    std::string generate_short_id(int length)
+    {
+        if (length <= 0) {
+            return std::string();
+        }
+
+        IdRandom& random = local_random();
+        std::string result(static_cast<size_t>(length), '\0');
+        for (char& c : result) {
+            c = SHORT_ID_CHARS[random.below(sizeof(SHORT_ID_CHARS) - 1)];
+        }
+        return result;
+    }
+
+    std::string generate_admin_id(int length)
+    {
+        if (length <= 0) {
+            return std::string();
+        }
+
+        IdRandom& random = local_random();
+        std::string result(static_cast<size_t>(length), '\0');
+        uint64_t bits = 0;
+        for (size_t index = 0; index < result.size(); ++index) {
+            // 每个随机数提供 16 个十六进制字符
+            if (index % 16 == 0) {
+                bits = random.next();
+            }
+            result[index] = HEX[bits & 0xf];
+            bits >>= 4;
+        }
+        return result;
+    }
+}
@@ -1,24 +1,27 @@
 #include <fstream>
 #include <sstream>
-#include <iostream>
+#include <memory>
+
+#ifdef TAKEAWAY_USE_SIMDJSON
+#include <simdjson.h>
+#endif
 
 #include "common.h"
+#include "logger.h"
 
 
 namespace TakeAwayPlatform
 {
     Json::Value load_config(const std::string& path) 
     {
-        std::cout << "Loading config, path:" << path << std::endl;
-        std::cout.flush();
+        LOG_INFO("Loading config, path:" << path);
 
         std::ifstream configFile(path);
         if (!configFile.is_open()) {
             throw std::runtime_error("Failed to open config file: " + path);
         }
 
-        std::cout << "Opening config success." << std::endl;
-        std::cout.flush();
+        LOG_INFO("Opening config success.");
 
         std::stringstream buffer;
         buffer << configFile.rdbuf();
@@ -34,5 +37,125 @@ namespace TakeAwayPlatform
         
         return root;
     }
-}
 
+
+    namespace
+    {
+#ifdef TAKEAWAY_USE_SIMDJSON
+        // simdjson 解析结果转换为 Json::Value，处理函数仍按 jsoncpp 接口读取字段
+        void convert(simdjson::dom::element element, Json::Value& out)
+        {
+            switch (element.type())
+            {
+                case simdjson::dom::element_type::ARRAY:
+                    out = Json::Value(Json::arrayValue);
+                    for (simdjson::dom::element child : simdjson::dom::array(element)) {
+                        convert(child, out.append(Json::Value()));
+                    }
+                    break;
+
+                case simdjson::dom::element_type::OBJECT:
+                    out = Json::Value(Json::objectValue);
+                    for (simdjson::dom::key_value_pair field : simdjson::dom::object(element)) {
+                        convert(field.value, out[std::string(field.key)]);
+                    }
+                    break;
+
+                case simdjson::dom::element_type::INT64:
+                    out = Json::Value(static_cast<Json::Int64>(int64_t(element)));
+                    break;
+
+                case simdjson::dom::element_type::UINT64:
+                    out = Json::Value(static_cast<Json::UInt64>(uint64_t(element)));
+                    break;
+
+                case simdjson::dom::element_type::DOUBLE:
+                    out = Json::Value(double(element));
+                    break;
+
+                case simdjson::dom::element_type::STRING: {
+                    std::string_view text = element;
+                    out = Json::Value(text.data(), text.data() + text.size());
+                    break;
+                }
+
+                case simdjson::dom::element_type::BOOL:
+                    out = Json::Value(bool(element));
+                    break;
+
+                default:
+                    out = Json::Value();
+            }
+        }
+#else
+        Json::CharReader& thread_reader()
+        {
+            thread_local std::unique_ptr<Json::CharReader> reader = [] {
+                Json::CharReaderBuilder builder;
+                builder["collectComments"] = false;
+                return std::unique_ptr<Json::CharReader>(builder.newCharReader());
+            }();
+            return *reader;
+        }
+#endif
+
+        struct CompactWriter
+        {
+            std::unique_ptr<Json::StreamWriter> writer;
+            std::ostringstream stream;
+        };
+
+        CompactWriter& thread_writer()
+        {
+            thread_local CompactWriter compact = [] {
+                Json::StreamWriterBuilder builder;
+                builder["indentation"] = "";
+                builder["emitUTF8"] = true;
+                CompactWriter created;
+                created.writer.reset(builder.newStreamWriter());
+                return created;
+            }();
+            return compact;
+        }
+    }
+
+    bool parse_json(const char* begin, const char* end, Json::Value& root, std::string* errors)
+    {
+#ifdef TAKEAWAY_USE_SIMDJSON
+        thread_local simdjson::dom::parser parser;
+
+        simdjson::dom::element element;
+        const simdjson::error_code error = parser.parse(begin, static_cast<size_t>(end - begin)).get(element);
+        if (error) {
+            if (errors) {
+                *errors = simdjson::error_message(error);
+            }
+            return false;
+        }
+
+        convert(element, root);
+        return true;
+#else
+        return thread_reader().parse(begin, end, &root, errors);
+#endif
+    }
+
+    Json::Value parse_json(const std::string& text)
+    {
+        Json::Value root;
+        std::string errors;
+        if (!parse_json(text.data(), text.data() + text.size(), root, &errors)) {
+            throw std::runtime_error("JSON parse error: " + errors);
+        }
+        return root;
+    }
+
+    std::string to_json(const Json::Value& value)
+    {
+        CompactWriter& compact = thread_writer();
+        compact.stream.str(std::string());
+        compact.stream.clear();
+        compact.writer->write(value, &compact.stream);
+        return compact.stream.str();
+    }
+}
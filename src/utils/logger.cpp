@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include "logger.h"
+
+
+namespace TakeAwayPlatform
+{
+    const char* log_level_name(LogLevel level)
+    {
+        switch (level)
+        {
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info:  return "INFO ";
+            case LogLevel::Warn:  return "WARN ";
+            case LogLevel::Error: return "ERROR";
+            default:              return "OFF  ";
+        }
+    }
+
+    LogLevel parse_log_level(const std::string& name, LogLevel fallback)
+    {
+        if (name == "debug") return LogLevel::Debug;
+        if (name == "info")  return LogLevel::Info;
+        if (name == "warn")  return LogLevel::Warn;
+        if (name == "error") return LogLevel::Error;
+        if (name == "off")   return LogLevel::Off;
+        return fallback;
+    }
+
+    Logger& Logger::instance()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    Logger::Logger()
+    {
+        lineBuffer.reserve(64 * 1024);
+        running.store(true);
+        writer = std::thread([this] { writer_loop(); });
+    }
+
+    Logger::~Logger()
+    {
+        shutdown();
+    }
+
+    Logger::RingHandle::~RingHandle()
+    {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+
+    void Logger::configure(const LogOptions& options)
+    {
+        minLevel.store(static_cast<uint8_t>(options.level), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(outputMtx);
+        flushInterval = options.flushInterval;
+
+        FILE* opened = options.file.empty() ? stdout : std::fopen(options.file.c_str(), "a");
+        if (opened == nullptr) {
+            // 打不开日志文件时保留原输出
+            std::fprintf(stderr, "Failed to open log file: %s\n", options.file.c_str());
+            return;
+        }
+
+        if (ownsOutput) {
+            std::fclose(output);
+        }
+        output = opened;
+        ownsOutput = opened != stdout;
+    }
+
+    void Logger::write(LogLevel level, const std::string& message)
+    {
+        if (!running.load(std::memory_order_acquire)) {
+            write_sync(level, message);
+            return;
+        }
+
+        Ring* ring = local_ring();
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        if (head - tail >= RING_SLOTS) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Slot& slot = ring->slots[head & (RING_SLOTS - 1)];
+        slot.timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        slot.level = level;
+
+        // 过长的日志截断，结尾标记 ...
+        size_t length = std::min(message.size(), SLOT_TEXT);
+        std::memcpy(slot.text, message.data(), length);
+        if (message.size() > SLOT_TEXT) {
+            std::memcpy(slot.text + SLOT_TEXT - 3, "...", 3);
+        }
+        slot.length = static_cast<uint16_t>(length);
+
+        ring->head.store(head + 1, std::memory_order_release);
+        writtenCount.fetch_add(1, std::memory_order_relaxed);
+
+        // 错误日志或缓冲区过半时立即唤醒后台线程
+        if (level >= LogLevel::Error || head - tail >= RING_SLOTS / 2) {
+            wakeCv.notify_one();
+        }
+    }
+
+    void Logger::flush()
+    {
+        if (!running.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(outputMtx);
+            std::fflush(output);
+            return;
+        }
+
+        const uint64_t target = writtenCount.load(std::memory_order_relaxed);
+        wakeCv.notify_one();
+
+        std::unique_lock<std::mutex> lock(wakeMtx);
+        drainedCv.wait_for(lock, std::chrono::seconds(2), [this, target] {
+            return drainedCount.load(std::memory_order_relaxed) >= target
+                || !running.load(std::memory_order_relaxed);
+        });
+    }
+
+    void Logger::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMtx);
+            if (!running.exchange(false)) {
+                return;
+            }
+        }
+        wakeCv.notify_all();
+        if (writer.joinable()) {
+            writer.join();
+        }
+
+        // 后台线程退出后再取一次，避免遗漏
+        drain();
+
+        std::lock_guard<std::mutex> lock(outputMtx);
+        std::fflush(output);
+        if (ownsOutput) {
+            std::fclose(output);
+            output = stdout;
+            ownsOutput = false;
+        }
+    }
+
+    Logger::Ring* Logger::local_ring()
+    {
+        thread_local RingHandle handle;
+        if (!handle.ring) {
+            std::lock_guard<std::mutex> lock(ringsMtx);
+            handle.ring = std::make_shared<Ring>(nextThreadId++);
+            rings.push_back(handle.ring);
+        }
+        return handle.ring.get();
+    }
+
+    void Logger::writer_loop()
+    {
+        while (running.load(std::memory_order_acquire)) {
+            if (drain() > 0) {
+                continue;
+            }
+
+            std::chrono::milliseconds interval;
+            {
+                std::lock_guard<std::mutex> lock(outputMtx);
+                interval = flushInterval;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMtx);
+            wakeCv.wait_for(lock, interval);
+        }
+    }
+
+    size_t Logger::drain()
+    {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(ringsMtx);
+            snapshot = rings;
+        }
+
+        lineBuffer.clear();
+        size_t drained = 0;
+        bool hasRetired = false;
+
+        for (const auto& ring : snapshot) {
+            const bool retired = ring->retired.load(std::memory_order_acquire);
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+
+            for (; tail < head; ++tail) {
+                format_line(ring->threadId, ring->slots[tail & (RING_SLOTS - 1)], lineBuffer);
+                ++drained;
+            }
+            ring->tail.store(tail, std::memory_order_release);
+
+            hasRetired = hasRetired || retired;
+        }
+
+        // 移除已退出线程的空缓冲区
+        if (hasRetired) {
+            std::lock_guard<std::mutex> lock(ringsMtx);
+            rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<Ring>& ring) {
+                return ring->retired.load(std::memory_order_acquire)
+                    && ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+            }), rings.end());
+        }
+
+        // 报告丢弃的日志条数
+        const uint64_t drops = droppedCount.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            Slot notice;
+            notice.timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            notice.level = LogLevel::Warn;
+            const int length = std::snprintf(notice.text, SLOT_TEXT, "[logger] dropped %llu log lines (buffer full)",
+                static_cast<unsigned long long>(drops - reportedDrops));
+            notice.length = static_cast<uint16_t>(std::min<size_t>(std::max(length, 0), SLOT_TEXT - 1));
+            format_line(0, notice, lineBuffer);
+            reportedDrops = drops;
+        }
+
+        if (!lineBuffer.empty()) {
+            std::lock_guard<std::mutex> lock(outputMtx);
+            std::fwrite(lineBuffer.data(), 1, lineBuffer.size(), output);
+            std::fflush(output);
+        }
+
+        if (drained > 0) {
+            drainedCount.fetch_add(drained, std::memory_order_relaxed);
+            { std::lock_guard<std::mutex> lock(wakeMtx); }
+            drainedCv.notify_all();
+        }
+        return drained;
+    }
+
+    void Logger::format_line(uint32_t threadId, const Slot& slot, std::string& out) const
+    {
+        const std::time_t seconds = static_cast<std::time_t>(slot.timeMicros / 1000000);
+        const int millis = static_cast<int>((slot.timeMicros / 1000) % 1000);
+
+        std::tm local {};
+        localtime_r(&seconds, &local);
+
+        char prefix[64];
+        const int length = std::snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d.%03d %s [%u] ",
+            local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+            local.tm_hour, local.tm_min, local.tm_sec, millis,
+            log_level_name(slot.level), threadId);
+
+        out.append(prefix, length > 0 ? static_cast<size_t>(length) : 0);
+        out.append(slot.text, slot.length);
+        out += '\n';
+    }
+
+    void Logger::write_sync(LogLevel level, const std::string& message)
+    {
+        Slot slot;
+        slot.timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        slot.level = level;
+        slot.length = static_cast<uint16_t>(std::min(message.size(), SLOT_TEXT));
+        std::memcpy(slot.text, message.data(), slot.length);
+
+        std::string line;
+        format_line(0, slot, line);
+
+        std::lock_guard<std::mutex> lock(outputMtx);
+        std::fwrite(line.data(), 1, line.size(), output);
+        std::fflush(output);
+    }
+
+    bool LogRateLimiter::allow(uint32_t limit, uint64_t& suppressed)
+    {
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        int64_t start = windowStart.load(std::memory_order_relaxed);
+        if (start != now && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        if (count.fetch_add(1, std::memory_order_relaxed) < limit) {
+            suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "metrics.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // Prometheus 直方图输出的桶边界（秒）
+        const struct { uint64_t micros; const char* label; } EXPORT_BUCKETS[] = {
+            {100, "0.0001"}, {250, "0.00025"}, {500, "0.0005"},
+            {1000, "0.001"}, {2500, "0.0025"}, {5000, "0.005"},
+            {10000, "0.01"}, {25000, "0.025"}, {50000, "0.05"},
+            {100000, "0.1"}, {250000, "0.25"}, {500000, "0.5"},
+            {1000000, "1"}, {2500000, "2.5"}, {5000000, "5"}, {10000000, "10"}
+        };
+
+        const struct { double q; const char* label; } EXPORT_QUANTILES[] = {
+            {0.5, "0.5"}, {0.9, "0.9"}, {0.99, "0.99"}, {0.999, "0.999"}
+        };
+
+        void append_value(std::string& out, double value)
+        {
+            char buffer[32];
+            if (std::floor(value) == value && std::fabs(value) < 9007199254740992.0) {
+                std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+            } else {
+                std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+            }
+            out += buffer;
+        }
+
+        void append_label_value(std::string& out, const std::string& value)
+        {
+            for (char c : value) {
+                switch (c)
+                {
+                    case '\\': out += "\\\\"; break;
+                    case '"':  out += "\\\""; break;
+                    case '\n': out += "\\n"; break;
+                    default:   out += c; break;
+                }
+            }
+        }
+    }
+
+    size_t metric_shard()
+    {
+        static std::atomic<size_t> nextShard {0};
+        thread_local const size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+        return shard;
+    }
+
+    uint64_t Counter::value() const
+    {
+        uint64_t total = 0;
+        for (const Shard& shard : shards) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    size_t Histogram::bucket_index(uint64_t micros)
+    {
+        if (micros < SUB_COUNT) {
+            return static_cast<size_t>(micros);
+        }
+        if (micros >= (uint64_t(1) << MAX_BITS)) {
+            micros = (uint64_t(1) << MAX_BITS) - 1;
+        }
+
+        // 最高位决定区间，其后 SUB_BITS 位决定子桶
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(micros));
+        const unsigned shift = msb - SUB_BITS;
+        return static_cast<size_t>(shift) * SUB_COUNT + static_cast<size_t>(micros >> shift);
+    }
+
+    uint64_t Histogram::bucket_upper(size_t index)
+    {
+        if (index < 2 * SUB_COUNT) {
+            return index;
+        }
+        const unsigned shift = static_cast<unsigned>(index / SUB_COUNT) - 1;
+        const uint64_t top = index % SUB_COUNT + SUB_COUNT;
+        return ((top + 1) << shift) - 1;
+    }
+
+    void Histogram::record(uint64_t micros)
+    {
+        Shard& shard = shards[metric_shard()];
+        shard.buckets[bucket_index(micros)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sumMicros.fetch_add(micros, std::memory_order_relaxed);
+    }
+
+    Histogram::Snapshot Histogram::snapshot() const
+    {
+        Snapshot merged;
+        for (const Shard& shard : shards) {
+            for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+                merged.buckets[index] += shard.buckets[index].load(std::memory_order_relaxed);
+            }
+            merged.sumMicros += shard.sumMicros.load(std::memory_order_relaxed);
+        }
+
+        // 总数由桶汇总得出，保证与各桶一致
+        for (uint64_t bucket : merged.buckets) {
+            merged.count += bucket;
+        }
+        return merged;
+    }
+
+    uint64_t Histogram::Snapshot::quantile(double q) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+        uint64_t seen = 0;
+        for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+            seen += buckets[index];
+            if (seen >= rank) {
+                return bucket_upper(index);
+            }
+        }
+        return bucket_upper(BUCKET_COUNT - 1);
+    }
+
+    uint64_t Histogram::Snapshot::count_at_most(uint64_t micros) const
+    {
+        uint64_t total = 0;
+        for (size_t index = 0; index < BUCKET_COUNT && bucket_upper(index) <= micros; ++index) {
+            total += buckets[index];
+        }
+        return total;
+    }
+
+    void MetricsWriter::counter(const std::string& name, const std::string& help, double value, const MetricLabels& labels)
+    {
+        header(name, help, "counter");
+        sample(name, labels, value);
+    }
+
+    void MetricsWriter::gauge(const std::string& name, const std::string& help, double value, const MetricLabels& labels)
+    {
+        header(name, help, "gauge");
+        sample(name, labels, value);
+    }
+
+    void MetricsWriter::histogram(const std::string& name, const std::string& help,
+                                  const Histogram::Snapshot& snapshot, const MetricLabels& labels)
+    {
+        header(name, help, "histogram");
+
+        const std::string bucketName = name + "_bucket";
+        for (const auto& bucket : EXPORT_BUCKETS) {
+            sample(bucketName, labels, static_cast<double>(snapshot.count_at_most(bucket.micros)), "le", bucket.label);
+        }
+        sample(bucketName, labels, static_cast<double>(snapshot.count), "le", "+Inf");
+        sample(name + "_sum", labels, static_cast<double>(snapshot.sumMicros) / 1e6);
+        sample(name + "_count", labels, static_cast<double>(snapshot.count));
+    }
+
+    void MetricsWriter::header(const std::string& name, const std::string& help, const char* type)
+    {
+        if (!described.insert(name).second) {
+            return;
+        }
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    void MetricsWriter::sample(const std::string& name, const MetricLabels& labels, double value,
+                               const char* extraKey, const std::string& extraValue)
+    {
+        out += name;
+        if (!labels.empty() || extraKey != nullptr) {
+            out += '{';
+            bool first = true;
+            for (const auto& label : labels) {
+                if (!first) out += ',';
+                first = false;
+                out += label.first;
+                out += "=\"";
+                append_label_value(out, label.second);
+                out += '"';
+            }
+            if (extraKey != nullptr) {
+                if (!first) out += ',';
+                out += extraKey;
+                out += "=\"";
+                append_label_value(out, extraValue);
+                out += '"';
+            }
+            out += '}';
+        }
+        out += ' ';
+        append_value(out, value);
+        out += '\n';
+    }
+
+    MetricsRegistry& MetricsRegistry::instance()
+    {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    template<typename T>
+    T& MetricsRegistry::find_or_create(std::map<std::string, Family<T>>& families, const std::string& name,
+                                       const std::string& help, const MetricLabels& labels)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        Family<T>& family = families[name];
+        if (family.help.empty()) {
+            family.help = help;
+        }
+        for (auto& series : family.series) {
+            if (series.first == labels) {
+                return *series.second;
+            }
+        }
+        family.series.emplace_back(labels, std::make_unique<T>());
+        return *family.series.back().second;
+    }
+
+    Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const MetricLabels& labels)
+    {
+        return find_or_create(counters, name, help, labels);
+    }
+
+    Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const MetricLabels& labels)
+    {
+        return find_or_create(histograms, name, help, labels);
+    }
+
+    size_t MetricsRegistry::add_collector(Collector collector)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        const size_t id = nextCollectorId++;
+        collectors.emplace(id, std::move(collector));
+        return id;
+    }
+
+    void MetricsRegistry::remove_collector(size_t id)
+    {
+        // 与 render 共用一把锁，返回后回调不会再被调用
+        std::lock_guard<std::mutex> lock(mtx);
+        collectors.erase(id);
+    }
+
+    std::string MetricsRegistry::render()
+    {
+        std::string out;
+        out.reserve(64 * 1024);
+        MetricsWriter writer(out);
+
+        std::lock_guard<std::mutex> lock(mtx);
+
+        for (const auto& family : counters) {
+            for (const auto& series : family.second.series) {
+                writer.counter(family.first, family.second.help,
+                               static_cast<double>(series.second->value()), series.first);
+            }
+        }
+
+        for (const auto& family : histograms) {
+            // 同一指标的各序列连续输出，分位数作为单独的 gauge 放在后面
+            std::vector<Histogram::Snapshot> snapshots;
+            snapshots.reserve(family.second.series.size());
+            for (const auto& series : family.second.series) {
+                snapshots.push_back(series.second->snapshot());
+                writer.histogram(family.first, family.second.help, snapshots.back(), series.first);
+            }
+
+            const std::string quantileName = family.first + "_quantile";
+            for (size_t index = 0; index < snapshots.size(); ++index) {
+                for (const auto& quantile : EXPORT_QUANTILES) {
+                    MetricLabels labels = family.second.series[index].first;
+                    labels.emplace_back("quantile", quantile.label);
+                    writer.gauge(quantileName, family.second.help + " (quantile estimate)",
+                                 static_cast<double>(snapshots[index].quantile(quantile.q)) / 1e6, labels);
+                }
+            }
+        }
+
+        for (const auto& collector : collectors) {
+            collector.second(writer);
+        }
+
+        return out;
+    }
+}
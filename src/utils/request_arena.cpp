@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "request_arena.h"
+
+
+namespace TakeAwayPlatform
+{
+    namespace
+    {
+        // 缓冲大小按页取整
+        constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+        std::atomic<size_t> initialCapacity {16 * 1024};
+        std::atomic<size_t> maxCapacity {256 * 1024};
+
+        std::atomic<uint64_t> requestCount {0};
+        std::atomic<uint64_t> overflowCount {0};
+        std::atomic<uint64_t> overflowByteCount {0};
+        std::atomic<size_t> reservedByteCount {0};
+
+        size_t round_up(size_t bytes)
+        {
+            return (bytes + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+        }
+
+        // 线程缓冲用完后的上游分配器，记录本次请求向堆申请的字节数
+        class OverflowResource : public std::pmr::memory_resource
+        {
+        public:
+            size_t bytes = 0;
+
+        private:
+            void* do_allocate(size_t size, size_t alignment) override
+            {
+                bytes += size;
+                return std::pmr::new_delete_resource()->allocate(size, alignment);
+            }
+
+            void do_deallocate(void* pointer, size_t size, size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+
+        struct ThreadArena
+        {
+            std::unique_ptr<std::byte[]> buffer;
+            size_t capacity = 0;
+            OverflowResource overflow;
+            std::optional<std::pmr::monotonic_buffer_resource> arena;
+
+            ~ThreadArena()
+            {
+                reservedByteCount.fetch_sub(capacity, std::memory_order_relaxed);
+            }
+
+            void resize(size_t bytes)
+            {
+                if (bytes == capacity) {
+                    return;
+                }
+                buffer.reset(new std::byte[bytes]);
+                reservedByteCount.fetch_add(bytes, std::memory_order_relaxed);
+                reservedByteCount.fetch_sub(capacity, std::memory_order_relaxed);
+                capacity = bytes;
+            }
+        };
+
+        ThreadArena& thread_arena()
+        {
+            thread_local ThreadArena arena;
+            return arena;
+        }
+    }
+
+    std::pmr::memory_resource* RequestArena::resource()
+    {
+        ThreadArena& thread = thread_arena();
+        return thread.arena ? &*thread.arena : std::pmr::get_default_resource();
+    }
+
+    void RequestArena::configure(size_t initialBytes, size_t maxBytes)
+    {
+        const size_t initial = round_up(std::max<size_t>(initialBytes, BUFFER_ALIGNMENT));
+        initialCapacity.store(initial, std::memory_order_relaxed);
+        maxCapacity.store(std::max(initial, round_up(maxBytes)), std::memory_order_relaxed);
+    }
+
+    RequestArenaStats RequestArena::stats()
+    {
+        RequestArenaStats snapshot;
+        snapshot.requests = requestCount.load(std::memory_order_relaxed);
+        snapshot.overflows = overflowCount.load(std::memory_order_relaxed);
+        snapshot.overflowBytes = overflowByteCount.load(std::memory_order_relaxed);
+        snapshot.reservedBytes = reservedByteCount.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    RequestArena::Scope::Scope()
+    {
+        ThreadArena& thread = thread_arena();
+        if (thread.arena) {
+            return;
+        }
+
+        const size_t initial = initialCapacity.load(std::memory_order_relaxed);
+        const size_t limit = maxCapacity.load(std::memory_order_relaxed);
+        thread.resize(std::clamp(thread.capacity, initial, limit));
+
+        thread.overflow.bytes = 0;
+        thread.arena.emplace(thread.buffer.get(), thread.capacity, &thread.overflow);
+        active = true;
+        requestCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    RequestArena::Scope::~Scope()
+    {
+        if (!active) {
+            return;
+        }
+
+        // 销毁 monotonic_buffer_resource 时一次性归还向堆申请的块，线程缓冲留给下一个请求
+        ThreadArena& thread = thread_arena();
+        thread.arena.reset();
+
+        const size_t spilled = thread.overflow.bytes;
+        if (spilled > 0) {
+            overflowCount.fetch_add(1, std::memory_order_relaxed);
+            overflowByteCount.fetch_add(spilled, std::memory_order_relaxed);
+            const size_t limit = maxCapacity.load(std::memory_order_relaxed);
+            thread.resize(std::min(limit, round_up(thread.capacity + spilled)));
+        }
+    }
+}